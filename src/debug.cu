@@ -24,7 +24,6 @@ __HOST__ void  Debug::free_db() { if (_db) delete _db; }
 #define MEM(a)   ((U8*)&mu->_pmem[a])         /** memory pointer by offset           */
 #define DIDX     (mu->_didx)                  /** number of dictionary entries       */
 #define DICT(w)  (mu->_dict[w])               /** dictionary entry                   */
-#define XT0      ((UFP)DICT(0).xt)            /** base of lambda functions (i.e. xt) */
 ///@}
 ///@name Primitive words to help printing
 ///@{
@@ -156,14 +155,12 @@ Debug::see(IU w, int base) {
 __HOST__ void
 Debug::dict_dump() {
     h_ostr &fout = io->fout;
-    UFP xt0 = XT0;
-
     keep_fmt();
-    fout << "Built-in Dictionary: _XT0="
-         << std::hex << xt0 << std::setfill('0') << ENDL;
+    fout << "Built-in Dictionary: xrom="
+         << std::hex << (UFP)mu->_xrom << std::setfill('0') << ENDL;
     for (int i=0; i < DIDX; i++) {
         Code &c = DICT(i);
-        U32  ip = c.udf ? c.pfa : (U32)(((UFP)c.xt & MSK_XT) - xt0);
+        U32  ip = c.pfa;                          /// * pfa or primitive table index
         fout << std::dec << std::setw(4) << i << '|'
              << std::hex << std::setw(3) << i << '>'
              << (c.udf ? " pf=" : " xt=")
@@ -186,14 +183,10 @@ Debug::_d2h(const char *d_str) {
 }
 __HOST__ int
 Debug::_p2didx(Param *p) {
-    UFP xt0 = XT0;
     IU  pfa = p->ioff;
     for (int i = DIDX - 1; i > 0; --i) {
         Code &c  = DICT(i);
-        bool hit = p->udf
-            ? (c.udf  && pfa==c.pfa)
-            : (!c.udf && pfa==(IU)((UFP)c.xt - xt0));
-        if (hit) return i;
+        if (c.udf == p->udf && pfa == c.pfa) return i;
     }
     return -1;                                     /// * not found
 }
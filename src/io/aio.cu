@@ -7,6 +7,7 @@
 #include <cstdio>        // printf
 #include <iostream>      // cin, cout
 #include <iomanip>       // setbase, setprecision
+#include <cstring>       // strncpy
 #include "aio.h"
 ///
 ///@name singleton and contructor
@@ -93,3 +94,133 @@ AIO::_show_obj(T4Base &t, bool is_view, int base) {
 
 
 
+///==========================================================================
+///@name included file streaming
+///@{
+///
+/// push a file onto the include stack, what is left of current input
+/// (and a chunk already read ahead) resumes after the file
+///
+__HOST__ int
+AIO::included(const char *fn, Istream &is) {
+    if (_rf.joinable()) _rf.join();
+    if (_rfn) {                                  /// * read ahead of current file
+        _inc.push_back({ NULL, std::string(is.back(), _rfn) });
+        _rfn = 0;
+    }
+    const char *r = is.rest();                   ///< after included, held by device
+    if (r && *r) _inc.push_back({ NULL, std::string(r) });
+    
+    if (_inc.size() >= T4_INCL_DEPTH) {
+        ERROR("included %s: nested too deep\n", fn); return -1;
+    }
+    std::ifstream *fs = new std::ifstream(fn, std::ios::binary);
+    if (!fs->is_open()) {
+        delete fs;
+        ERROR("included %s: not found\n", fn); return -1;
+    }
+    _inc.push_back({ fs, "" });
+    IO_DB("AIO::included %s depth=%ld\n", fn, (long)_inc.size());
+    return 0;
+}
+///
+/// the back buffer is managed memory, the host may write it while kernels
+/// are in flight only with concurrent managed access (else a fault)
+///
+__HOST__ bool
+AIO::_ahead() {
+    if (_cma < 0) {
+        int dev = 0;
+        _cma = 0;
+        GPU_ERR(cudaGetDevice(&dev));
+        GPU_ERR(cudaDeviceGetAttribute(&_cma, cudaDevAttrConcurrentManagedAccess, dev));
+        IO_DB("AIO::chunk read ahead %s\n", _cma ? "on" : "off, synchronous");
+    }
+    return _cma != 0;
+}
+///
+/// swap next chunk into device input, then read the one after on
+/// the read ahead thread while device interprets this one (or at the
+/// next call, between launches, without concurrent managed access)
+///
+__HOST__ int
+AIO::chunk(Istream &is) {
+    if (_rf.joinable()) _rf.join();
+    while (_inc.size()) {
+        _isrc &s = _inc.back();
+        int   n  = _rfn ? _rfn : _read(s, is.back(), is.size());
+        _rfn = 0;
+        if (!n) { _pop(); continue; }            /// * source done
+        
+        is.flip(n);
+        if (s.fs && _ahead()) _rf = std::thread([this, &s, &is]() {
+            _rfn = _read(s, is.back(), is.size());
+        });
+        return 1;
+    }
+    return 0;
+}
+///
+/// line by line, for resident VMs fed thru the command ring
+///
+__HOST__ int
+AIO::getline(char *tib, int sz) {
+    if (_rf.joinable()) _rf.join();
+    while (_inc.size()) {
+        _isrc &s = _inc.back();
+        std::string l;
+        if (s.txt.find('\n') == std::string::npos && s.fs && std::getline(*s.fs, l)) {
+            s.txt += l + '\n';
+        }
+        if (s.txt.empty()) { _pop(); continue; }
+        
+        size_t e = s.txt.find('\n');
+        l = s.txt.substr(0, e);
+        s.txt.erase(0, e == std::string::npos ? e : e + 1);
+        strncpy(tib, l.c_str(), sz - 1);
+        tib[sz - 1] = '\0';
+        return 1;
+    }
+    return 0;
+}
+
+__HOST__ void
+AIO::incl_abort() {
+    if (_rf.joinable()) _rf.join();
+    if (_inc.size()) IO_DB("AIO::included aborted, depth=%ld\n", (long)_inc.size());
+    while (_inc.size()) _pop();
+    _rfn = 0;
+}
+///@}
+///@name private methods
+///@{
+///
+/// left over first, then file, cut after the last line end (or blank
+/// of an over long line) so an idiom never spans two chunks
+///
+__HOST__ int
+AIO::_read(_isrc &s, char *buf, int sz) {
+    int n = (int)s.txt.size() < sz - 1 ? (int)s.txt.size() : sz - 1;
+    memcpy(buf, s.txt.data(), n);
+    s.txt.erase(0, n);
+    if (s.fs && n < sz - 1) {
+        s.fs->read(buf + n, sz - 1 - n);
+        n += (int)s.fs->gcount();
+    }
+    bool more = s.txt.size() || (s.fs && !s.fs->eof());
+    if (more) {
+        int c = n;
+        while (c > 0 && buf[c - 1] != '\n') c--;
+        if (!c) { c = n; while (c > 0 && buf[c - 1] != ' ') c--; }
+        if (c) { s.txt.insert(0, buf + c, n - c); n = c; }
+    }
+    return n;
+}
+
+__HOST__ void
+AIO::_pop() {
+    _isrc &s = _inc.back();
+    if (s.fs) delete s.fs;                       /// * closes file
+    _inc.pop_back();
+}
+///@}
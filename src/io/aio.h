@@ -16,6 +16,10 @@
 #include "dataset.h"                  // in ../mmu
 #include "model.h"                    // in ../mmu
 #include "ldr/loader.h"               // in ../ldr (include corpus.h)
+#include <thread>
+#include <fstream>
+#include <string>
+#include <vector>
 
 typedef std::istream h_istr;          ///< host input stream
 typedef std::ostream h_ostr;          ///< host output ostream
@@ -24,7 +28,13 @@ typedef std::ostream h_ostr;          ///< host output ostream
 
 class AIO {                           ///< create in host mode
     __HOST__ AIO(h_istr &i, h_ostr &o, int verbo) : fin(i), fout(o), trace(verbo) {}
-    __HOST__ ~AIO() { TRACE("\\   AIO: instance freed\n"); }
+    __HOST__ ~AIO() {
+#if (T4_ENABLE_OBJ && T4_ENABLE_NN)
+        if (_pf.joinable()) _pf.join();       /// * pending batch prefetch
+#endif // (T4_ENABLE_OBJ && T4_ENABLE_NN)
+        incl_abort();                         /// * close included files
+        TRACE("\\   AIO: instance freed\n");
+    }
 
 public:
     friend class Debug;               ///< Debug can access my private members
@@ -33,22 +43,18 @@ public:
     h_ostr &fout;                     ///< host output stream
     int    trace;                     ///< debug tracing verbosity level
     
-#if DO_MULTITASK
-    static bool     io_busy;          ///< IO locking control
-    static MUTEX    io;               ///< mutex for io access
-    static COND_VAR cv_io;            ///< io control
-    ///
-    /// IO interface
-    ///
-    static void io_lock();            ///< lock IO
-    static void io_unlock();          ///< unlock IO
-#endif // DO_MULTITASK
-
     static __HOST__ AIO *get_io(h_istr &i, h_ostr &o, int verbo);
     static __HOST__ AIO *get_io();
     static __HOST__ void free_io();
     
     __HOST__ void show(DU v, int base=10);      ///< display value by ss_dump
+    ///
+    /// included files, streamed in chunks cut at line ends
+    ///
+    __HOST__ int  included(const char *fn, Istream &is); ///< push a file, rest of tib kept
+    __HOST__ int  chunk(Istream &is);           ///< next chunk into tib, 0 if none
+    __HOST__ int  getline(char *tib, int sz);   ///< next line of included files, 0 if none
+    __HOST__ void incl_abort();                 ///< drop all included files
     
 #if T4_ENABLE_OBJ
     __HOST__ void show(T4Base &t, bool is_view, int base=10); ///< display tensor token (for ss_dump)
@@ -59,7 +65,7 @@ public:
     ///
     /// dataset IO methods
     ///
-    __HOST__ int  dsfetch(Dataset &ds, char *ds_name=NULL, bool rewind=0); ///< fetch a dataset batch (rewind=false load batch)
+    __HOST__ int  dsfetch(DU id, char *ds_name=NULL, bool rewind=0); ///< fetch a dataset batch (rewind=false load batch)
     ///
     /// NN model persistence (i.e. serialization) methods
     ///
@@ -73,6 +79,22 @@ private:
     int     _thres = 10;                       ///< max cell count for each dimension
     int     _edge  = 3;                        ///< number of tensor edge items
     int     _prec  = 4;                        ///< shown floating point precision
+    ///
+    /// include stack, next chunk of top file read ahead while device
+    /// interprets the current one
+    ///
+    struct _isrc {
+        std::ifstream *fs;                     ///< included file, NULL for text
+        std::string   txt;                     ///< left over, after a cut or an included
+    };
+    std::vector<_isrc> _inc;                   ///< include stack, top is current
+    std::thread _rf;                           ///< read ahead thread
+    int         _rfn   = 0;                    ///< bytes read ahead into back buffer
+    int         _cma   = -1;                   ///< concurrent managed access, -1 not queried
+    
+    __HOST__ int  _read(_isrc &s, char *buf, int sz); ///< a chunk cut at last line end
+    __HOST__ bool _ahead();                    ///< read ahead allowed while kernels run
+    __HOST__ void _pop();                      ///< close top of include stack
 
 #if T4_ENABLE_OBJ // vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
     ///
@@ -90,6 +112,16 @@ private:
     __HOST__ int  _tsave_npy(h_ostr &fs, Tensor &t);
     
 #if T4_ENABLE_NN
+    ///
+    /// next batch read ahead, overlaps device compute of current batch
+    ///
+    std::thread _pf;                              ///< prefetch thread
+    Corpus      *_pfc  = NULL;                    ///< corpus being prefetched
+    int         _pfid  = -1;                      ///< batch id prefetched
+    bool        _pfok  = false;                   ///< prefetch result
+    
+    __HOST__ void _prefetch(Corpus *cp, int bid, int bsz); ///< start reading batch bid
+    __HOST__ bool _pfjoin(Corpus *cp, int bid);            ///< wait, true if bid of cp is ready
     ///
     /// NN model print methods
     ///
@@ -26,12 +26,14 @@
 ///      -> dataset::reshape    - set dimensions for the first batch (no alloc yet) 
 ///      -> dataset::load_batch - transfer host blocks to device
 ///         -> dataset::alloc   - alloc device memory blocks if needed
+///      -> aio::_prefetch      - read next batch on a host thread while
+///                               the device computes this one
 /// Note:
 ///   ds_name: dataset name (match in loader.cu), for initial dataset setup
 ///   ds_name: NULL, following batch
 ///
 __HOST__ int
-AIO::dsfetch(Dataset &ds, char *ds_name, bool rewind) {
+AIO::dsfetch(DU id, char *ds_name, bool rewind) {
     Dataset &ds = (Dataset&)T4Base::du2obj(id);   ///< dataset ref
     U32     dsx = DU2X(id) & ~T4_TYPE_MSK;        ///< dataset mnemonic
     if (!ds.is_dataset()) {                       /// * indeed a dataset?
@@ -47,24 +49,27 @@ AIO::dsfetch(Dataset &ds, char *ds_name, bool rewind) {
     if (!cp) {
         ERROR(" dataset not found\n"); return -1;
     }
-    int batch_sz = ds.N();                       ///< mini batch size
+    int  batch_sz = ds.N();                      ///< mini batch size
+    bool pf = _pfjoin(cp, ds.batch_id);          ///< batch read ahead already
     if (ds_name) {                               /// * init load
         if (cp->init()==NULL) {
             ERROR(" dataset setup failed!\n"); return -2;
         }
         ds.reshape(batch_sz, cp->H, cp->W, cp->C);/// * reshape ds to match Corpus
     }
+    if (rewind || ds_name) pf = false;
     if (rewind) {
         cp->rewind();
         ds.batch_id = ds.done = 0;
     }
-    else if ((ds.done=cp->eof)) {                /// * dataset exhausted?
+    else if (!pf && (ds.done=cp->eof)) {         /// * dataset exhausted?
         IO_DB(" completed, no more data.\n"); return 0;
     }
     ///
     /// load a mini-batch of data points
     ///
-    if (!cp->fetch(ds.batch_id, batch_sz)) {     /// * fetch a batch from Corpus
+    if (pf) IO_DB(" prefetched,");
+    else if (!cp->fetch(ds.batch_id, batch_sz)) {/// * fetch a batch from Corpus
         ERROR("fetch failed\n");  return -3;
     }
     ///
@@ -76,10 +81,43 @@ AIO::dsfetch(Dataset &ds, char *ds_name, bool rewind) {
 
     ds.batch_id++;
     ds.done = cp->eof;
+    ///
+    /// start page migration of the batch and read the next one
+    /// while the device works on this one
+    ///
+    int dev;
+    cudaGetDevice(&dev);
+    cudaMemPrefetchAsync(ds.data, ds.numel * sizeof(DU), dev);
+    cudaMemPrefetchAsync(ds.label, ds.N() * sizeof(U32), dev);
+    if (!ds.done) _prefetch(cp, ds.batch_id, batch_sz);
     
     return 0;
 }
 ///
+/// read batch bid of a corpus on the prefetch thread
+/// Note: Corpus::fetch seeks by batch id, so a discarded prefetch
+///       only leaves the eof flag behind (cleared in _pfjoin)
+///
+__HOST__ void
+AIO::_prefetch(Corpus *cp, int bid, int bsz) {
+    _pfc  = cp;
+    _pfid = bid;
+    _pfok = false;
+    _pf   = std::thread([this, cp, bid, bsz]() {
+        _pfok = cp->fetch(bid, bsz) != NULL;
+    });
+}
+__HOST__ bool
+AIO::_pfjoin(Corpus *cp, int bid) {
+    if (!_pf.joinable()) return false;
+    _pf.join();
+    bool ok = _pfok && _pfc == cp && _pfid == bid;
+    if (!ok && _pfc) _pfc->eof = 0;              /// * undo read ahead
+    _pfc  = NULL;
+    _pfid = -1;
+    return ok;
+}
+///
 /// NN model persistence (i.e. serialization) methods
 ///
 __HOST__ int
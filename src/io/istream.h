@@ -13,29 +13,33 @@
 ///
 class Istream : public Managed {
     char *_buf;                 /// input buffer
+    char *_bak;                 /// back buffer, host fills next chunk
+    int  _sz;                   /// size of each buffer
     int  _idx  = 0;             /// current buffer index
     int  _gn   = 0;             /// number of byte processed
+    int  _stop = 0;             /// 1: held by included, 2: flushed on error
     ///
-    ///> process a token (separated by delimiter)
+    ///> process a token (separated by delimiter), line ends are blanks
     ///
+    __GPU__ static bool _ws(char c) { return c==' ' || c=='\t' || c=='\n' || c=='\r'; }
     __GPU__ int _tok(char delim) {
         char *p = &_buf[_idx];  ///< pointer to indexed buffer
-        while (delim==' ' && (*p==' ' || *p=='\t')) (p++, _idx++); // skip leading blanks and tabs
+        while (delim==' ' && _ws(*p)) (p++, _idx++);               // skip leading blanks, tabs and line ends
         int nidx=_idx;
-        while (*p && *p!=delim) (p++, nidx++);                     // advance pointers
+        while (*p && (delim==' ' ? !_ws(*p) : *p!=delim)) (p++, nidx++); // advance pointers
         _gn = (delim!=' ' && *p!=delim) ? nidx=0 : nidx - _idx;    // not found or end of input string
         return nidx;                                               // found at input string index (0 not found)
     }
 public:
-    Istream(int sz=T4_IBUF_SZ) { MM_ALLOC(&_buf, sz);       }
-    ~Istream()                 { GPU_SYNC(); MM_FREE(_buf); }
+    Istream(int sz=T4_IBUF_SZ) : _sz(sz) { MM_ALLOC(&_buf, sz); MM_ALLOC(&_bak, sz); }
+    ~Istream()                 { GPU_SYNC(); MM_FREE(_buf); MM_FREE(_bak); }
     ///
     /// intialize by a given string
     ///
     __BOTH__ char     *rdbuf() { return _buf; }
     __BOTH__ Istream& clear()  {
         //LOCK;
-        _idx = _gn = 0;
+        _idx = _gn = _stop = 0;
         //UNLOCK;
         return *this;
     }
@@ -45,20 +49,36 @@ public:
         return *this;
     }
     ///
+    /// double buffering, host reads next chunk into back() while
+    /// device interprets the front one, flip() swaps them
+    ///
+    __HOST__ char     *back()  { return _bak; }
+    __HOST__ Istream& flip(int n) {
+        char *t = _buf; _buf = _bak; _bak = t;
+        _buf[n] = '\0';
+        return clear();
+    }
+    __HOST__ int      stopped() { return _stop; }
+    __HOST__ const char *rest() { return _stop==1 ? &_buf[_idx] : NULL; } ///< left by included
+    __GPU__  void     stop(int why) { _stop = why; }      ///< no more idiom for this round
+    ///
     /// sizing
     ///
     __HOST__ int gcount() { return _gn;  }
     __HOST__ int tellg()  { return _idx; }
+    __BOTH__ int size()   { return _sz;  }
     //
     /// parser
     ///
     __GPU__ Istream& get_idiom(char *s, char delim=' ') {
+        if (_stop) { _gn = 0; *s = '\0'; return *this; }  // held, rest kept for host
         int nidx = _tok(delim);             // index to next token
 
         if (nidx > 0) {                     // token found
-            MEMCPY(s, &_buf[_idx], _gn);    // CUDA memcpy
+            int n = _gn < T4_STRBUF_SZ ? _gn : T4_STRBUF_SZ - 1; // pad size, long comments in files
+            MEMCPY(s, &_buf[_idx], n);      // CUDA memcpy
             _idx = nidx + (delim != ' ');   // advance index
-            s[_gn] = '\0';                  // terminated with '\0'
+            s[n] = '\0';                    // terminated with '\0'
             DEBUG("ibuf[%d] >> '%s' (%d bytes)\n", _idx, s, _gn);
         }
         else if (delim=='\n') {             // comment line
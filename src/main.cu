@@ -0,0 +1,58 @@
+/** -*- c++ -*-
+ * @file
+ * @brief tensorForth main program, kept apart so tests link the VMs without it
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <iostream>          // cin, cout
+#include <signal.h>
+#include "ten4.h"            // wrapper
+
+using namespace std;
+///
+/// main program
+///
+void sigsegv_handler(int sig, siginfo_t *si, void *arg) {
+    cout << "Exception caught at: " << si->si_addr << endl;
+    exit(1);
+}
+
+void sigtrap() {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(struct sigaction));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_sigaction = sigsegv_handler;
+    sa.sa_flags     = SA_SIGINFO;
+    sigaction(SIGSEGV, &sa, NULL);
+}
+
+#include "opt.h"
+int main(int argc, char**argv) {
+    sigtrap();
+    
+    Options opt;
+    opt.parse(argc, argv);
+    
+    GPU_ERR(cudaDeviceSetLimit(cudaLimitStackSize, T4_PER_THREAD_STACK));
+    // GPU_ERR(cudaDeviceSetLimit(cudaLimitMallocHeapSize, 16*1024*1024));
+    
+    if (opt.help) {
+        opt.print_usage(cout);
+        opt.check_devices(cout);
+        cout << "\nRecommended GPU: " << opt.device_id << endl;
+        return 0;
+    }
+    else opt.check_devices(cout, false);
+
+    cout << T4_APP_NAME << endl;
+
+    TensorForth *f = new TensorForth(opt.device_id, opt.verbose);
+    f->setup();
+    if (opt.resident) f->main_resident();
+    else              f->main_loop();
+    f->teardown();
+    
+    cout << T4_APP_NAME << " done." << endl;
+
+    return 0;
+}
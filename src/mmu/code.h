@@ -7,44 +7,52 @@
 #ifndef __MMU_CODE_H
 #define __MMU_CODE_H
 ///
-/// CUDA functor (device only)
-/// Note: nvstd::function is generic and smaller (at 56-byte)
+/// ROM primitive table entry (device only)
+/// Note: a CODE lambda captures the VM pointer only, so it is kept by value
+///       next to a plain function pointer that invokes it, no heap functor
+///       and no virtual dispatch
+///       words are added once (by VM0) but run on every VM, so the trampoline
+///       rebinds the captured pointer to the executing VM before the call
+///       (single inheritance, a VM and its bases share one address)
 ///
-///@name light-weight functor object implementation
-///@brief functor object (80-byte allocated by CUDA)
+///@name primitive table entry
 ///@{
-struct fop { __GPU__ virtual void operator()() = 0; };  ///< functor virtual class
-template<typename F>                                    ///< template functor class
-struct functor : fop {
-    F op;                                               ///< reference to lambda
-    __GPU__ __INLINE__ functor(const F f) : op(f) {     ///< constructor
-        DEBUG("fop:%p => ", this);
-    }
-    __GPU__ __INLINE__ void operator()() {              ///< lambda invoke
-        DEBUG("op(%p) => ", this);
-        op();
+typedef void (*XFN)(const void*, void*); ///< primitive trampoline (closure, VM)
+template<typename F>
+__GPU__ void _xcall(const void *f, void *vm) {
+    F g = *(const F*)f;                       /// * closure copy
+    memcpy(&g, &vm, sizeof(void*));           /// * captured this => executing VM
+    g();
+}
+struct Prim {
+    XFN fn;                       ///< trampoline for lambda type
+    U64 cl;                       ///< closure (captured VM pointer)
+    template<typename F>
+    __GPU__ void set(const F &f) {
+        static_assert(sizeof(F) == sizeof(void*), "CODE lambda captures [this] only");
+        fn = _xcall<F>;
+        memcpy(&cl, &f, sizeof(F));           /// * device memcpy builtin
     }
+    __GPU__ __INLINE__ void operator()(void *vm) const { fn(&cl, vm); }
 };
-typedef fop* FPTR;                ///< lambda function pointer
 ///@}
 ///@name Code class for dictionary word
 ///@{
-constexpr UFP MSK_XT = (UFP)~0>>2;/// xt pointer mask (for union attributes)
 struct Code : public Managed {
     const char *name = 0;         ///< name field
     union {
-        FPTR xt = 0;              ///< lambda pointer (CUDA 49-bit)
-        U64  *fp;                 ///< function pointer (for debugging)
+        U64 xt = 0;               ///< all attributes (for alias and snapshot)
         struct {
-            IU  pfa;              ///< param field offset to pmem space
+            IU  pfa;              ///< pmem offset of colon word, or primitive table index
             U32 nfa : 16;         ///< reserved
-            U32 didx: 14;         ///< dictionary index (reverse link)
+            U32 didx: 13;         ///< dictionary index (reverse link)
+            U32 cdp : 1;          ///< may launch child kernels (not with resident VMs)
             U32 imm : 1;          ///< immediate flag
             U32 udf : 1;          ///< colon defined word
         };
     };
 
-    __HOST__ Code(const char *n, IU w) : name(n), xt((FPTR)((UFP)w)) {}  ///< primitives
+    __HOST__ Code(const char *n, IU w) : name(n), xt(w) {}               ///< primitives
     __HOST__ ~Code() { DEBUG("Code(%s) freed\n", name); }                ///< destructor
 /*
     __GPU__ Code() {}             ///< blank struct (for initilization)
@@ -53,12 +61,12 @@ struct Code : public Managed {
         DEBUG("%cCode(name=%p, xt=%p) %s\n", im ? '*' : ' ', name, xt, n);
     }
 */    
-    template<typename F>          ///< template function for lambda
-    __GPU__ void set(const char *n, F &f, bool im) {
+    __GPU__ void set(const char *n, IU x, bool im) {  ///< built-in word
         name = n;
-        xt   = new functor<F>(f);
+        xt   = 0;
+        pfa  = x;                 /// * index to primitive table
         imm  = im ? 1 : 0;
-        DEBUG("%cCode(name=%p, xt=%p) %s\n", im ? '*' : ' ', name, xt, n);
+        DEBUG("%cCode(name=%p, x=%d) %s\n", im ? '*' : ' ', name, x, n);
     }
 };
 #endif // __MMU_CODE_H
@@ -5,13 +5,17 @@
  * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
  */
 #include <iomanip>             // setw, setbase
+#include <stdio.h>             // fopen, snapshot
+#include <fcntl.h>             // open
+#include <unistd.h>            // ftruncate, close
+#include <sys/mman.h>          // mmap
 #include "mmu.h"
+#include "param.h"             // in ../vm, snapshot pmem walk
 
 ///@name static class member
 ///@note: CUDA does not support device static data
 ///@{
 MMU *_mmu = NULL;              ///< singleton MMU controler
-__GPU__  UFP _XT0;
 __GPU__  UFP _NM0;
 ///@}
 ///
@@ -20,14 +24,22 @@ __GPU__  UFP _NM0;
 __HOST__
 MMU::MMU() {
     MM_ALLOC(&_dict, sizeof(Code) * T4_DICT_SZ);
+    MM_ALLOC(&_xrom, sizeof(Prim) * T4_DICT_SZ);
     MM_ALLOC(&_vmss, sizeof(DU) * T4_SS_SZ * T4_VM_COUNT);
     MM_ALLOC(&_vmrs, sizeof(DU) * T4_RS_SZ * T4_VM_COUNT);
     MM_ALLOC(&_pmem, T4_PMEM_SZ);
+    MM_ALLOC(&_wmap, sizeof(IU) * T4_DICT_SZ * 2);
+    MM_ALLOC(&_wsig, sizeof(U32) * T4_DICT_SZ * 2);
     
 #if T4_ENABLE_OBJ    
-    MM_ALLOC(&_mark, sizeof(DU) * T4_TFREE_SZ);
-    MM_ALLOC(&_obj,  T4_OSTORE_SZ);
-    _ostore.init(_obj, T4_OSTORE_SZ);
+    for (int i = 0; i < T4_TFREE_SEG; i++) _fseg[i] = NULL;
+    MM_ALLOC(&_fseg[0], sizeof(DU) * T4_TFREE_SZ);   /// * first segment, others on demand
+    memset(_fseg[0], 0, sizeof(DU) * T4_TFREE_SZ);
+    MM_ALLOC(&_ohdr, T4_OHDR_SZ);                      /// * headers, never grown
+    _hstore.init(_ohdr, T4_OHDR_SZ);
+    for (int i = 0; i < T4_OSEG_MAX; i++) { _oseg[i] = NULL; _cold[i] = false; }
+    memset(&_mst, 0, sizeof(t4_mstat));
+    for (U64 sz = 0; sz < T4_OSTORE_SZ; sz += T4_OSEG_SZ) grow();
 #endif // T4_ENABLE_OBJ
 
     _midx = T4_USER_AREA;      // set aside user area (for base and maybe compile)
@@ -38,17 +50,29 @@ MMU::MMU() {
         "\\\tvmss=%p\n"
         "\\\tvmrs=%p\n"
         "\\\tmem =%p\n"
-        "\\\tmark=%p\n"
-        "\\\tobj =%p\n",
-        _dict, _vmss, _vmrs, _pmem, _mark, _obj);
+        "\\\tfree=%p\n"
+        "\\\tobj =%p\n"
+        "\\\tdata=%p\n",
+        _dict, _vmss, _vmrs, _pmem, _fseg[0], _ohdr, _oseg[0]);
 }
 __HOST__
 MMU::~MMU() {
-    if (_obj)  MM_FREE(_obj);
-    if (_mark) MM_FREE(_mark);
+#if T4_ENABLE_OBJ
+    for (int i = 0; i < _nseg; i++) {
+        if (!_cold[i]) { MM_FREE(_oseg[i]); continue; }
+        cudaHostUnregister(_oseg[i]);
+        munmap(_oseg[i], T4_OSEG_SZ);
+    }
+    MM_FREE(_ohdr);
+#endif // T4_ENABLE_OBJ
+    if (_fseg[0]) MM_FREE(_fseg[0]); /// * other segments from device heap
+    if (_simg) ::free(_simg);
+    MM_FREE(_wsig);
+    MM_FREE(_wmap);
     MM_FREE(_pmem);
     MM_FREE(_vmrs);
     MM_FREE(_vmss);
+    MM_FREE(_xrom);
     MM_FREE(_dict);
     TRACE("\\   MMU: CUDA Managed Memory freed\n");
 }
@@ -62,26 +86,198 @@ MMU::free_mmu() {
     if (_mmu) delete _mmu;
 }
 ///
-/// static functions (for type conversion)
+/// dictionary snapshot
+///   header | add_word slot map[nw] | name hash[nw] | t4_sent[didx] | pmem[midx]
+///   the running hash of built-in names (in add_word order) is checked by
+///   add_word before each slot is replayed, a different word list stops the
+///   replay at the first mismatch and snap_restore then keeps the cold dictionary
+///   colon word names are pmem offsets
+///   object handles do not survive a reboot, so a pmem holding one (e.g.
+///   `3 3 matrix constant M`) is not saved
+///
+#define T4_SNAP_ID   "t4snap " __DATE__ " " __TIME__   /**< image format stamp */
+typedef struct {
+    char id[32];                    ///< build stamp
+    U32  dict_sz, pmem_sz;          ///< configuration
+    U32  nw, nprim;                 ///< add_word calls, built-in words
+    U32  didx, midx;                ///< dictionary and pmem indices
+    U32  sig, xx;                   ///< hash of built-in names in order, reserved
+} t4_shdr;
+typedef struct {
+    U64  x;                         ///< Code attributes (pfa or table index, flags)
+    U32  nm;                        ///< name offset in pmem
+    U32  xx;                        ///< reserved
+} t4_sent;
+
+__HOST__ int
+MMU::snap_load(const char *fn) {
+    FILE *f = fopen(fn, "rb");
+    if (!f) return 0;                               /// * first boot
+    t4_shdr h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 &&
+        strncmp(h.id, T4_SNAP_ID, sizeof(h.id)) == 0 &&
+        h.dict_sz == T4_DICT_SZ && h.pmem_sz == T4_PMEM_SZ &&
+        h.nw <= T4_DICT_SZ * 2 && h.didx <= T4_DICT_SZ && h.midx <= T4_PMEM_SZ;
+    U64 sz = ok ? sizeof(h) + (sizeof(IU) + sizeof(U32)) * h.nw
+        + sizeof(t4_sent) * h.didx + h.midx : 0;
+    if (ok) {
+        _simg = (U8*)malloc(sz);
+        fseek(f, 0, SEEK_SET);
+        ok = fread(_simg, 1, sz, f) == sz;
+    }
+    fclose(f);
+    if (!ok) {
+        INFO("\\ MMU: snapshot %s stale, cold boot\n", fn);
+        if (_simg) { ::free(_simg); _simg = NULL; }
+        return 0;
+    }
+    memcpy(_wmap, _simg + sizeof(h), sizeof(IU) * h.nw);
+    memcpy(_wsig, _simg + sizeof(h) + sizeof(IU) * h.nw, sizeof(U32) * h.nw);
+    _nwx = h.nw;                                    /// * init skips find() while names match
+    return 1;
+}
+
+__HOST__ int
+MMU::snap_restore() {
+    if (!_simg) return 0;
+    t4_shdr &h  = *(t4_shdr*)_simg;
+    t4_sent *e  = (t4_sent*)(_simg + sizeof(h) + (sizeof(IU) + sizeof(U32)) * h.nw);
+    U8      *m  = (U8*)&e[h.didx];
+    bool    ok  = _nwx == h.nw && _nw == h.nw &&    /// * replayed to the end
+        h.sig == _nsig && h.nprim == _nprim;        /// * same built-in names in order
+    _nwx = 0;
+    if (ok) {
+        for (IU i = _nprim; i < h.didx; i++) {      /// * user words
+            _dict[i].xt   = e[i].x;
+            _dict[i].name = (const char*)&_pmem[e[i].nm];
+        }
+        memcpy(_pmem, m, h.midx);                   /// * one copy, user area included
+        _didx = h.didx;
+        _midx = h.midx;
+    }
+    else INFO("\\ MMU: snapshot word list changed, user words not restored\n");
+    ::free(_simg);
+    _simg = NULL;
+    return ok;
+}
+
+///
+/// first colon word with an object handle in its pmem (literal, value,
+/// variable or comma'd cell), 0 if none
+///
+__HOST__ IU
+MMU::snap_obj() {
+    for (IU w = _nprim; w < _didx; w++) {
+        if (!_dict[w].udf) continue;
+        IU e = _midx;                               ///< end of body, next colon word
+        for (IU i = w + 1; i < _didx; i++) {
+            if (_dict[i].udf) { e = _dict[i].nfa; break; }
+        }
+        bool var = false;                           ///< cells after VAR are data
+        for (IU a = _dict[w].pfa; a + sizeof(IU) <= e;) {
+            if (var) {
+                if (IS_OBJ(*(DU*)&_pmem[a])) return w;
+                a += sizeof(DU);
+                continue;
+            }
+            Param &p = *(Param*)&_pmem[a];
+            a += sizeof(IU);
+            switch (p.op) {
+            case LIT:  if (IS_OBJ(*(DU*)&_pmem[a])) return w;
+                       a += sizeof(DU);  break;
+            case VAR:  var = true;       break;
+            case STR:
+            case DOTQ: a += p.ioff;      break;
+            default:                     break;
+            }
+        }
+    }
+    return 0;
+}
+
+__HOST__ int
+MMU::snap_save(const char *fn) {
+    _snap = false;
+    IU   w = snap_obj();
+    if (w) {
+        ERROR("MMU::snap_save %s holds an object handle, not saved\n", _dict[w].name);
+        return 0;
+    }
+    FILE *f = fn ? fopen(fn, "wb") : NULL;
+    if (!f) { ERROR("MMU::snap_save %s open failed\n", fn ? fn : "(T4_SNAP_FILE not set)"); return 0; }
+    t4_shdr h = {};
+    strncpy(h.id, T4_SNAP_ID, sizeof(h.id));
+    h.dict_sz = T4_DICT_SZ;  h.pmem_sz = T4_PMEM_SZ;
+    h.nw      = _nw;         h.nprim   = _nprim;
+    h.didx    = _didx;       h.midx    = _midx;
+    h.sig     = _nsig;
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(_wmap, sizeof(IU), _nw, f);
+    fwrite(_wsig, sizeof(U32), _nw, f);
+    for (IU i = 0; i < _didx; i++) {
+        Code    &c = _dict[i];
+        t4_sent e  = {};
+        e.x  = c.xt;
+        e.nm = i < _nprim ? 0 : (U32)((U8*)c.name - _pmem);
+        fwrite(&e, sizeof(e), 1, f);
+    }
+    fwrite(_pmem, 1, _midx, f);
+    fclose(f);
+    TRACE("\\ MMU: snapshot %s dict[%d], pmem[%d]\n", fn, _didx, _midx);
+    return 1;
+}
+#if T4_ENABLE_OBJ
+///
+/// add a tensor data segment, in managed memory or, past T4_OSEG_HOT
+/// segments and with T4_OSEG_FILE set, in a host mmap'd file mapped to device
+/// Note: host only, between kernel launches
 ///
-__GPU__  FPTR MMU::XT(IU ioff)      { return (FPTR)(_XT0 + ioff);  }
-__GPU__  IU   MMU::XTOFF(FPTR xt)   { return (IU)((UFP)xt - _XT0); }
+__HOST__ int
+MMU::grow() {
+    _grow = false;
+    if (_nseg >= T4_OSEG_MAX) {
+        ERROR("MMU::grow max %d segments reached\n", T4_OSEG_MAX);
+        return -1;
+    }
+    const char *fn = getenv("T4_OSEG_FILE");  ///< backing file prefix
+    U8  *p  = NULL;
+    bool cd = fn && _nseg >= T4_OSEG_HOT;
+    if (cd) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s.%d", fn, _nseg);
+        int fd = open(path, O_RDWR | O_CREAT, 0600);
+        if (fd < 0 || ftruncate(fd, T4_OSEG_SZ)) {
+            ERROR("MMU::grow %s open failed\n", path);
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        p = (U8*)mmap(NULL, T4_OSEG_SZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == (U8*)MAP_FAILED) { ERROR("MMU::grow mmap failed\n"); return -1; }
+        GPU_ERR(cudaHostRegister(p, T4_OSEG_SZ, cudaHostRegisterMapped)); /// * UVA, same pointer
+    }
+    else MM_ALLOC(&p, T4_OSEG_SZ);
+    _ostore[_nseg].init(p, T4_OSEG_SZ);
+    _oseg[_nseg] = p;
+    _cold[_nseg] = cd;
+    TRACE("\\ MMU: object segment[%d]=%p %s\n", _nseg, p, cd ? fn : "managed");
+    return _nseg++;
+}
+#endif // T4_ENABLE_OBJ
 ///
 /// dictionary management methods
-/// TODO: use const Code[] directly, as ROM, to prevent deep copy
+/// Note: built-in words index _xrom directly (ioff == dictionary index)
 ///
 __GPU__ void
 MMU::dict_validate() {
-    UFP  x0 = ~0;                           ///< base of xt   allocations
     UFP  n0 = ~0;
     Code *c = _dict;
-    for (int i=0; i < _didx; i++, c++) {    /// * scan thru for max range
-        if ((UFP)c->xt   < x0) x0 = (UFP)c->xt;
+    for (int i=0; i < _didx; i++, c++) {    /// * scan thru for name range
         if ((UFP)c->name < n0) n0 = (UFP)c->name;
     }
-    _XT0 = x0;
-    _NM0 = n0;
-    _dict[0].xt = (FPTR)x0;                 /// * borrow for xt0
+    _NM0   = n0;
+    _nprim = _didx;                         /// * built-in words, before any colon word
+    _kids  = false;
 }
 
 __GPU__ IU
@@ -96,26 +292,60 @@ MMU::find(const char *s) {
 
 __GPU__ void
 MMU::status() {
-    INFO("\\ MMU.stat dict[%d/%d], pmem[%d]=%0.1f%%, tfree[%d/%d]\n",
-        _didx, T4_DICT_SZ, _midx, 100.0*(_midx/T4_PMEM_SZ), _fidx, T4_TFREE_SZ);
+    INFO("\\ MMU.stat dict[%d/%d], pmem[%d]=%0.1f%%\n",
+        _didx, T4_DICT_SZ, _midx, 100.0*(_midx/T4_PMEM_SZ));
     ///
-    /// display object store statistics
+    /// display free queue and object store statistics
     ///
-#if T4_ENABLE_OBJ    
-    _ostore.status();
+#if T4_ENABLE_OBJ
+    int ns = 0;
+    for (int i = 0; i < T4_TFREE_SEG; i++) ns += _fseg[i] != NULL;
+    INFO("\\ MMU.tfree depth=%ld/%d, swept=%ld, sweep cycles last=%ld max=%ld\n",
+        _ftail - _fhead, ns * T4_TFREE_SZ, _fcnt, _ftick, _fmax);
+    INFO("\\ MMU.ohdr %p\n", _ohdr);
+    _hstore.status();
+    for (int i = 0; i < _nseg; i++) {
+        INFO("\\ MMU.ostore[%d/%d] %p%s", i, T4_OSEG_MAX, _oseg[i], _cold[i] ? " mmap\n" : "\n");
+        _ostore[i].status();
+    }
+    INFO("\\ MMU.ostore in use=%ld, high-water=%ld bytes\n", _mst.use, _mst.hwm);
 #endif // T4_ENABLE_OBJ
 }
+#if T4_ENABLE_OBJ
+///
+/// report allocation counters since last reset, for sizing T4_OSTORE_SZ
+///
+__GPU__ void
+MMU::tally(bool reset) {
+    const char *tnm[MT_TAGS] = {
+        "tensor", "model", "dataset", "gradient", "momentum"
+    };
+    INFO("\\ MMU.tally alloc=%ld blocks/%ld bytes, free=%ld blocks/%ld bytes\n",
+         _mst.na, _mst.ba, _mst.nf, _mst.bf);
+    INFO("\\ MMU.tally in use=%ld, high-water=%ld bytes\n", _mst.use, _mst.hwm);
+    INFO("\\ MMU.tally by site:");
+    for (int i = 0; i < MT_TAGS; i++) INFO(" %s=%ld", tnm[i], _mst.tag[i]);
+    INFO("\n\\ MMU.tally by size:");
+    for (int i = 0; i < L1_BITS; i++) {
+        if (_mst.hist[i]) INFO(" %ld+=%d", 1L << i, _mst.hist[i]);
+    }
+    INFO("\n");
+    if (!reset) return;
+    _mst.na = _mst.nf = _mst.ba = _mst.bf = 0;         /// * in-use and tags carry over
+    _mst.hwm = _mst.use;
+    for (int i = 0; i < L1_BITS; i++) _mst.hist[i] = 0;
+}
+#endif // T4_ENABLE_OBJ
 
 __GPU__ void
 MMU::dict_dump() {
     Code *c = _dict;
-    INFO("Built-in Dictionary [name0=0x%lx, xt0=0x%lx]\n", _NM0, _XT0);
+    INFO("Built-in Dictionary [name0=0x%lx, xrom=%p]\n", _NM0, _xrom);
     for (int i=0; i<_didx; i++, c++) {      ///< dump dictionary from device
-        IU  ix = c->udf ? c->pfa : (U32)(((UFP)c->xt & MSK_XT) - _XT0);
         U32 sz = ALIGN(STRLEN(c->name) + 1);
         INFO("%4d|%03x> name=%6x, %s=%6x %s\n", i, i,
               c->udf ? (c->pfa - sz) : (U32)((UFP)c->name - _NM0),
-              c->udf ? "pf" : "xt", ix, c->name);
+              c->udf ? "pf" : "xt", c->pfa, c->name);
     }
 }
 ///
@@ -141,31 +371,164 @@ MMU::colon(const char *name) {
 #include "model.h"             // in ../nn, include ../mmu/mmu.h
 #include "dataset.h"           // in ../nn
 
-#define OBJ2X(t)  ((U32)((U8*)&(t) - _obj))
+#define OBJ2X(t)  ((U32)(UFP)&(t))   /** low address bits, for debugging */
+#define TFREE_CAP ((U64)T4_TFREE_SZ * T4_TFREE_SEG)
+///
+/// free queue slot i, segments are a ring allocated on first use
+///
+__GPU__ volatile U32*
+MMU::_fslot(U64 i, bool grow) {
+    DU **sp = &_fseg[(i / T4_TFREE_SZ) % T4_TFREE_SEG];
+    if (!*sp && grow) {               /// * grow, the loser of the race frees its copy
+        DU *d = new DU[T4_TFREE_SZ];
+        for (int k = 0; k < T4_TFREE_SZ; k++) d[k] = DU0;
+        if (atomicCAS((unsigned long long*)sp, 0ULL, (unsigned long long)d)) delete[] d;
+        __threadfence();
+    }
+    return *sp ? (volatile U32*)&(*sp)[i % T4_TFREE_SZ] : NULL;
+}
+///
+/// mark an object free, lock-free multi-producer enqueue
+/// Note: a slot holds 0 until published, objects are never 0
+///
 __GPU__ void
 MMU::mark_free(DU v) {            ///< mark a tensor free for release
-    if (IS_VIEW(v)) return;
     T4Base &t = du2obj(v);
-    MM_DB("mmu#mark T:%x to free[%d]\n", OBJ2X(t), _fidx);
-//    lock();                     ///< TODO: CC: DEAD LOCK, now!
-    if (_fidx < T4_TFREE_SZ) _mark[_fidx++] = obj2du(t);
-    else ERROR("ERR: tfree store full, increase T4_TFREE_SZ!");
-//    unlock();
+    if (_ftail - _fhead >= TFREE_CAP - T4_VM_COUNT) {  /// * room for racing VMs
+        ERROR("ERR: tfree queue full, increase T4_TFREE_SEG!");
+        return;
+    }
+    U64 i = atomicAdd((unsigned long long*)&_ftail, 1ULL);
+    MM_DB("mmu#mark T:%x to free[%ld]\n", OBJ2X(t), i);
+    volatile U32 *p = _fslot(i, true);
+    if (!p) { ERROR("ERR: tfree segment alloc failed!"); return; }
+    DU x = obj2du(t);
+    *p = *(U32*)&x;                   /// * publish
 }
 #if T4_ENABLE_OBJ
+///
+/// release marked objects in order, single consumer
+/// Note: at most T4_SWEEP_MAX per call to bound the time of a tick
+///
 __GPU__ void                      ///< release marked free tensor
 MMU::sweep() {
-//    lock();                       /// * dead locked now
-    for (int i = 0, n=_fidx; n && i < n; i++) {
-        DU v = _mark[i];
-        MM_DB("mmu#release T:%x from free[%d]\n", DU2X(v) & ~T4_TT_OBJ, i);
-        drop(du2obj(v));
+    if (_cmpt) { _cmpt = false; _defrag(); }  /// * safe point, no VM running
+    if (_fhead == _ftail) return;
+    U64 t0 = clock64();
+    for (int n = 0; n < T4_SWEEP_MAX && _fhead < _ftail; n++) {
+        volatile U32 *p = _fslot(_fhead, false);
+        U32 x = p ? *p : 0;
+        if (!x) break;                /// * not published yet, next tick
+        *p = 0;
+        MM_DB("mmu#release T:%x from free[%ld]\n", x & ~T4_TT_OBJ, _fhead);
+        _fhead++;
+        _fcnt++;
+        drop(du2obj(*(DU*)&x));
     }
-    _fidx = 0;
-//    unlock();
+    _ftick = clock64() - t0;
+    if (_ftick > _fmax) _fmax = _ftick;
+}
+///
+/// relocate tensor data blocks into low memory, fix up the owners' data pointers
+///
+__GPU__ void
+MMU::_defrag() {
+    U64   f0 = 0, f1 = 0;                      ///< largest free block before, after
+    int   n  = _hstore.objects(NULL, 0);       ///< number of live objects
+    int   m  = 0, nmv = 0;
+    for (int i = 0; i < _nseg; i++) {
+        U64 f = _ostore[i].largest();
+        if (f > f0) f0 = f;
+    }
+    void  **obj = new void*[n];
+    void  ***own = new void**[n];              ///< data pointers into the store
+    U64   *key = new U64[n];                   ///< segment[63:32] | offset, sort key
+    _hstore.objects(obj, n);
+    for (int i = 0; i < n; i++) {
+        T4Base &t = *(T4Base*)obj[i];
+        int    s  = _seg(t.data);
+        if (s < 0) continue;                   /// * not in the store, e.g. host loaded
+        key[m]   = ((U64)s << 32) | (U64)((U8*)t.data - _oseg[s]);
+        own[m++] = (void**)&t.data;
+    }
+    for (int g = m / 2; g > 0; g /= 2) {       /// * shell sort by (segment, offset)
+        for (int i = g; i < m; i++) {          /// * segment bases are in no order
+            void **x = own[i];
+            U64  kx  = key[i];
+            int  j   = i;
+            for (; j >= g && key[j - g] > kx; j -= g) {
+                own[j] = own[j - g];
+                key[j] = key[j - g];
+            }
+            own[j] = x;
+            key[j] = kx;
+        }
+    }
+    for (int i = 0, k = 0; i < _nseg; i++) {   /// * owners of a segment are contiguous
+        int k0 = k;
+        while (k < m && (int)(key[k] >> 32) == i) k++;
+        nmv += _ostore[i].compact(&own[k0], k - k0);
+        U64 f = _ostore[i].largest();
+        if (f > f1) f1 = f;
+    }
+    INFO("\\ MMU.compact objs=%d, moved=%d, largest free %ld => %ld bytes\n",
+         n, nmv, f0, f1);
+    delete[] key;
+    delete[] own;
+    delete[] obj;
+}
+///
+/// object headers from the header store, data from the first segment that
+/// fits, ask host for a spare segment once the last one is in use
+///
+__GPU__ void*
+MMU::_malloc(U64 sz, bool obj) {
+    TLSF *h = &_hstore;
+    void *p = NULL;
+    if (obj) {
+        p = _hstore.malloc(sz);
+        if (!p) { ERROR("mmu#malloc(%ld) header store full, T4_OHDR_SZ?\n", sz); return NULL; }
+        _hstore.pin(p);                        /// * handles point to it, never moved
+    }
+    else {
+        int i = 0;
+        for (; !p && i < _nseg; i++) p = _ostore[i].malloc(sz);
+        if (i >= _nseg) _grow = true;          /// * added by host at next tick
+        if (!p) { ERROR("mmu#malloc(%ld) object store full\n", sz); return NULL; }
+        h = &_ostore[i - 1];
+    }
+    ///
+    /// update counters, block size includes TLSF header
+    ///
+    typedef unsigned long long ULL;
+    U64 bsz = h->bsize(p);
+    atomicAdd((ULL*)&_mst.na, 1ULL);
+    atomicAdd((ULL*)&_mst.ba, (ULL)bsz);
+    atomicMax((ULL*)&_mst.hwm, (ULL)(atomicAdd((ULL*)&_mst.use, (ULL)bsz) + bsz));
+    atomicAdd(&_mst.hist[63 - __clzll((long long)bsz)], 1);
+    return p;
+}
+__GPU__ void
+MMU::_free(void *p) {
+    bool o = _hdr(p);
+    int  s = o ? 0 : _seg(p);
+    if (s < 0) return;                         /// * not in the store, e.g. host loaded
+    TLSF &h = o ? _hstore : _ostore[s];
+    typedef unsigned long long ULL;
+    U64 bsz = h.bsize(p);
+    atomicAdd((ULL*)&_mst.nf, 1ULL);
+    atomicAdd((ULL*)&_mst.bf, (ULL)bsz);
+    atomicAdd((ULL*)&_mst.use, (ULL)(-(S64)bsz));
+    h.free(p);
+}
+__GPU__ void
+MMU::_tag(T4Base &t, int tg, S64 sz) {
+    t.mtag = tg;
+    atomicAdd((unsigned long long*)&_mst.tag[tg], (unsigned long long)sz);
 }
 __GPU__ void
 MMU::drop(T4Base &t) {
+    if (t.ref_dec()) return;                           /// * still shared
 #if T4_ENABLE_NN
     if (t.is_model())  { free((Model&)t); return;  }   /// release TLSF memory block
 #endif  // T4_ENABLE_NN
@@ -174,15 +537,25 @@ MMU::drop(T4Base &t) {
 #endif  // T4_ENABLE_OBJ
 
 __GPU__ Tensor&                    ///< allocate a tensor from tensor space
-MMU::talloc(U64 sz) {
+MMU::talloc(U64 sz, t4_mtag tg) {
     MM_DB("mmu#talloc(%lx) {\n", sz);
-    Tensor &t = *(Tensor*)_ostore.malloc(sizeof(Tensor));
-    void   *d = _ostore.malloc(sz * sizeof(DU));
-    MM_DB("} mmu#talloc => T:%x+%x\n", OBJ2X(t), (U32)((U8*)d - _obj));
-    _ostore.status();
+    Tensor &t = *(Tensor*)_malloc(sizeof(Tensor), true);
+    void   *d = _malloc(sz * sizeof(DU));
+    MM_DB("} mmu#talloc => T:%x+%x\n", OBJ2X(t), (U32)(UFP)d);
     t.reset(d, sz);
+    _tag(t, tg, sz * sizeof(DU));
     return t;
 }
+__GPU__ DU*                        ///< allocate raw tensor storage
+MMU::dalloc(U64 sz) {
+    MM_DB("mmu#dalloc(%lx)\n", sz);
+    return (DU*)_malloc(sz * sizeof(DU));
+}
+__GPU__ void                       ///< release raw tensor storage
+MMU::dfree(DU *d) {
+    MM_DB("mmu#dfree(%x)\n", (U32)(UFP)d);
+    _free(d);
+}
 __GPU__ Tensor&                    ///< create a one-dimensional tensor
 MMU::tensor(U64 sz) {
     MM_DB("mmu#tensor(%ld) numel=%ld ", sz, sz);
@@ -197,10 +570,10 @@ MMU::tensor(U32 h, U32 w) {
     return t;
 }
 __GPU__ Tensor&                    ///< create a NHWC tensor
-MMU::tensor(U32 n, U32 h, U32 w, U32 c) {
+MMU::tensor(U32 n, U32 h, U32 w, U32 c, t4_mtag tg) {
     U64 sz = (U64)n * h * w * c;
     MM_DB("mmu#tensor(%d,%d,%d,%d) numel=%ld ", n, h, w, c, sz);
-    Tensor &t = talloc(sz);
+    Tensor &t = talloc(sz, tg);
     t.reshape(n, h, w, c);
     return t;
 }
@@ -209,21 +582,22 @@ MMU::resize(Tensor &t, U64 sz) {
     if (t.rank != 1) { ERROR("mmu#resize rank==1 only\n"); return; }
     MM_DB("mmu#resize numel=%ld (was %ld) ", sz, t.numel);
     DU *d0 = t.data;             /// * keep original memory block
-    t.data = (DU*)_ostore.malloc(sz * sizeof(DU));
+    t.data = (DU*)_malloc(sz * sizeof(DU));
     ///
     /// hardcopy tensor storage
     ///
     memcpy(t.data, d0, (t.numel < sz ? t.numel : sz) * sizeof(DU));
-    t.H() = t.numel = sz;        /// * adjust tensor storage size
     
-    _ostore.free(d0);            /// * release 
-    _ostore.status();
+    _free(d0);                   /// * release 
+    _tag(t, t.mtag, ((S64)sz - (S64)t.numel) * sizeof(DU));
+    t.H() = t.numel = sz;        /// * adjust tensor storage size
 }
 __GPU__ void                     ///< release tensor memory blocks
 MMU::free(Tensor &t) {
     int n = t.rank;
     MM_DB("mmu#free(T%d) numel=%ld T:%x {\n", n, t.numel, OBJ2X(t));
-    _ostore.free(t.data);        /// * free physical data
+    _tag(t, t.mtag, -(S64)(t.numel * sizeof(DU)));
+    _free(t.data);               /// * free physical data
     if (t.grad_fn != L_NONE) {
         MM_DB("{\n");
         for (int i=0; t.mtum[i] && i < 4; i++) {
@@ -233,40 +607,46 @@ MMU::free(Tensor &t) {
         for (int i=0; t.grad[i] && i < 4; i++) {
             MM_DB("\t\t"); free(*t.grad[i]);    /// recursive
         }
+        for (int i=0; i < 2 && t.qnt[i]; i++) {
+            MM_DB("\t\t"); free(*t.qnt[i]);     /// * INT8 weights and scales
+        }
         MM_DB("\t} ");
     }
-    _ostore.free(&t);              /// * free tensor object itself
+    _free(&t);                     /// * free tensor object itself
     MM_DB("} mmu#free(T%d)\n", n);
-    _ostore.status();
 }
 #if T4_ENABLE_NN
 __GPU__ Model&                     ///< create a NN model with NHWC input
 MMU::model(U64 sz) {
     MM_DB("mmu#model layers=%ld ", sz);
-    Model  *m = (Model*)_ostore.malloc(sizeof(Model));
-    Tensor &t = talloc(sz);        /// * allocate tensor storage
+    Model  *m = (Model*)_malloc(sizeof(Model), true);
+    Tensor &t = talloc(sz, MT_MODEL); /// * allocate tensor storage
     m->reset(this, t);
+    _tag(*m, MT_MODEL, sizeof(Model));
     return *m;
 }
 __GPU__ Dataset&                   ///< create a Dataset holder
 MMU::dataset(U32 batch_sz) {       /// * Note: data block is not allocated yet
     MM_DB("mmu#dataset batch_sz=%d ", batch_sz);
-    Dataset *ds = (Dataset*)_ostore.malloc(sizeof(Dataset));
+    Dataset *ds = (Dataset*)_malloc(sizeof(Dataset), true);
     ds->init(0, T4_DATASET, 4);
     ds->N()      = batch_sz;       /// * other members filled in host mode
     ds->batch_id = 0;              /// * setup control flag
-    _ostore.status();
+    _tag(*ds, MT_DATASET, sizeof(Dataset));
     return *ds;
 }
 __GPU__ void                     ///< release tensor memory blocks
 MMU::free(Model &m) {
     MM_DB("mmu#free(N%d) [\n", m.numel);
+    m.unshare();                   /// * layers in ping-pong buffers
+    m.dp(1);                       /// * replica dw/db
+    m.pipe(0);                     /// * micro-batch streams
     for (int i = m.numel-1; i >= 0; i--) {
         MM_DB("\t"); free(m[i]);
     }
     MM_DB("] ");
-    _ostore.free(&m);
-    _ostore.status();
+    _tag(m, MT_MODEL, -(S64)sizeof(Model));
+    _free(&m);
 }
 #endif // T4_ENABLE_NN
 ///
@@ -274,24 +654,26 @@ MMU::free(Model &m) {
 /// TODO: CDP
 ///
 __GPU__ Tensor&
-MMU::copy(Tensor &t0) {
+MMU::copy(Tensor &t0, t4_mtag tg) {
     if (!t0.is_tensor()) return t0;    ///> skip, TODO: copy model
 
     MM_DB("mmu#copy(T%d:%x) numel=%ld {\n", t0.rank, OBJ2X(t0), t0.numel);
-    Tensor &t1  = *(Tensor*)_ostore.malloc(sizeof(Tensor));
+    Tensor &t1  = *(Tensor*)_malloc(sizeof(Tensor), true);
     memcpy(&t1, &t0, sizeof(Tensor));   /// * copy attributes
     ///
     /// set attributes
     ///
     for (int i=0; i<4; i++) t1.grad[i] = t1.mtum[i] = NULL;  /// * blank gradients
+    t1.qnt[0]  = t1.qnt[1] = NULL;      /// * blank quantized weights
     t1.grad_fn = L_NONE;                /// * not a network layer
     t1.nref    = 1;                     /// * reset ref counter
     ///
     /// hard copy data block
     ///
     U64 bsz = sizeof(DU) * t0.numel;
-    t1.data = (DU*)_ostore.malloc(bsz);
+    t1.data = (DU*)_malloc(bsz);
     t1 = t0;                            /// * copy all tensor elements
+    _tag(t1, tg, bsz);
     
     MM_DB("} mmu#copy(T%d) => T%d:%x\n", t0.rank, t1.rank, OBJ2X(t1));
     return t1;
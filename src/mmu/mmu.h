@@ -16,19 +16,62 @@
 ///
 struct Model;
 struct Dataset;
+///
+/// allocation site tags (T4Base::mtag)
+///
+typedef enum {
+    MT_TENSOR = 0,                  ///< tensor (default)
+    MT_MODEL,                       ///< model object and layer store
+    MT_DATASET,                     ///< dataset object
+    MT_GRAD,                        ///< gradients
+    MT_MTUM,                        ///< optimizer momentum, velocity
+    MT_TAGS
+} t4_mtag;
+///
+/// object store counters, cheap enough to keep always on
+///
+typedef struct {
+    U64 na, nf;                     ///< blocks allocated, freed
+    U64 ba, bf;                     ///< bytes allocated, freed
+    U64 use, hwm;                   ///< bytes in use, high-water mark
+    U64 tag[MT_TAGS];               ///< data bytes in use per tag
+    U32 hist[L1_BITS];              ///< allocations by TLSF first-level class
+} t4_mstat;
+
 class MMU : public Managed {
     IU             _mutex = 0;      ///< lock (first so address aligned)
     IU             _didx  = 0;      ///< dictionary index
     IU             _midx  = 0;      ///< parameter memory index
-    IU             _fidx  = 0;      ///< index to freed tensor list
     Code           *_dict;          ///< dictionary block
+    Prim           *_xrom;          ///< primitive table, indexed by Param.ioff
     DU             *_vmss;          ///< VM data stacks
     DU             *_vmrs;          ///< VM return stacks
     U8             *_pmem;          ///< parameter memory block
-    DU             *_mark = 0;      ///< list for tensors that marked free
-    U8             *_obj  = 0;      ///< object storage block
+    IU             *_wmap;          ///< dict slot per add_word call (0: new word)
+    U32            *_wsig;          ///< running hash of built-in names per add_word call
+    U32            _nsig  = 0;      ///< running hash of built-in names so far
+    IU             _nw    = 0;      ///< add_word calls so far
+    IU             _nwx   = 0;      ///< slots to replay from snapshot (0: search)
+    IU             _nprim = 0;      ///< number of built-in words
+    bool           _snap  = false;  ///< snapshot requested (saved by host)
+    bool           _kids  = false;  ///< words being added launch child kernels
+    U8             *_simg = NULL;   ///< snapshot image staged by host
+    U64            _fhead = 0;      ///< free queue consumer index (sweep only)
+    U64            _ftail = 0;      ///< free queue producer index (atomic)
+    U64            _fcnt  = 0;      ///< number of objects swept
+    U64            _ftick = 0;      ///< cycles of last sweep
+    U64            _fmax  = 0;      ///< cycles of slowest sweep
+    bool           _cmpt  = false;  ///< compaction requested (done at sweep)
+    DU             *_fseg[T4_TFREE_SEG]; ///< free queue segments, grown on demand
 #if T4_ENABLE_OBJ    
-    TLSF           _ostore;         ///< object storage manager
+    int            _nseg  = 0;      ///< number of data segments
+    bool           _grow  = false;  ///< segment requested (added by host)
+    U8             *_ohdr;                ///< object headers, handles index it
+    TLSF           _hstore;               ///< storage manager of object headers
+    U8             *_oseg[T4_OSEG_MAX];   ///< tensor data segments
+    bool           _cold[T4_OSEG_MAX];    ///< segment backed by mmap'd file
+    TLSF           _ostore[T4_OSEG_MAX];  ///< storage manager per data segment
+    t4_mstat       _mst;                  ///< allocation counters
 #endif // T4_ENABLE_OBJ    
 
     __HOST__ MMU();
@@ -36,14 +79,27 @@ class MMU : public Managed {
     
 public:
     friend class Debug;             ///< Debug can access my private members
+    friend class Compiler;          ///< host compiler writes dict and pmem
     
     static __HOST__ MMU *get_mmu(); ///< singleton constructor/getter
     static __HOST__ void free_mmu();///< singleton destructor
     ///
-    /// function pointer conversion
+    /// dictionary and pmem snapshot (host, between kernel launches)
     ///
-    __GPU__  FPTR XT(IU ioff);      ///< function pointer from _XT0 offset 
-    __GPU__  IU   XTOFF(FPTR xt);   ///< _XT0 offset from function pointer
+    __HOST__ int  snap_load(const char *fn);    ///< stage image, replay slots in init
+    __HOST__ int  snap_restore();               ///< restore staged image after init
+    __HOST__ int  snap_save(const char *fn);    ///< write dictionary and pmem image
+    __BOTH__ bool need_snap() { return _snap; }
+    __GPU__  void snap()      { _snap = true; } ///< save at next tick
+    __HOST__ IU   snap_obj();                   ///< colon word holding an object handle
+#if T4_ENABLE_OBJ
+    __HOST__ int  grow();           ///< add a tensor data segment
+    __BOTH__ bool need_grow() { return _grow; }
+#endif // T4_ENABLE_OBJ
+    ///
+    /// primitive dispatch
+    ///
+    __GPU__  __INLINE__ void xcall(IU i, void *vm) { _xrom[i](vm); } ///< execute built-in word i on vm
     ///
     /// references to memory blocks
     ///
@@ -61,14 +117,28 @@ public:
     /// dictionary management ops
     ///
     __GPU__  void dict_validate();                                 ///< dictionary validation
+    __GPU__  void kids(bool on) { _kids = on; }                    ///< mark words that follow as CDP
     __GPU__  void status();                                        ///< display current MMU status
     __GPU__  void dict_dump();
     template <typename F>
     __GPU__  void add_word(const char *name, F &f, int im) {       ///< append or merge a new word
-        IU   w  = find(name);                                      ///< check whether word exists
-        Code &c = _dict[w ? w : _didx++];                          ///< new or exist Code object
-        c.set(name, f, im);                                        /// * hardcopy Code object
-        if (w) TRACE("*** redefined: %s\n", c.name);
+        U32  h  = (_nsig ^ (U32)HASH(name)) * 16777619U;           ///< names in order so far
+        if (_nw < _nwx && h != _wsig[_nw]) {                       /// * word list differs from snapshot
+            TRACE("*** snapshot differs at %s, searching\n", name);
+            _nwx = 0;                                              /// * no replay from here on
+        }
+        IU   w  = _nw < _nwx ? _wmap[_nw] : find(name);            ///< replay or check whether word exists
+        IU   i  = w ? w : _didx++;                                 ///< dictionary and table index
+        bool k  = w ? _dict[w].cdp : _kids;                        ///< redefined word keeps its kind
+        _xrom[i].set(f);                                           /// * closure by value
+        _dict[i].set(name, i, im);
+        _dict[i].cdp = k;
+        if (w) TRACE("*** redefined: %s\n", name);
+        if (_nw < T4_DICT_SZ * 2) {                                /// * record for snapshot
+            _wsig[_nw]   = h;
+            _wmap[_nw++] = w;
+        }
+        _nsig = h;
     }           
     __GPU__  IU   find(const char *s);                             ///< dictionary search
     ///
@@ -116,37 +186,66 @@ public:
 #if T4_ENABLE_OBJ // vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
     ///
     /// short hands for eforth tensor ucodes (for DU <-> Tensor conversion)
+    /// handle = offset/2[29:2] | type[1:0] into the header store, objects are 8-byte aligned
+    /// Note: bits 31:30 stay clear, so a handle is never a negative, NaN or Inf float
+    ///       tensor data is held by 64-bit pointers, so data segments are not bound by it
     ///
+    static_assert(T4_OHDR_SZ <= (1 << 30), "handle holds a 1G header offset");
+    __BOTH__ __INLINE__ bool _hdr(const void *p) {           ///< in the header store
+        return (U8*)p >= _ohdr && (U8*)p < _ohdr + T4_OHDR_SZ;
+    }
+    __BOTH__ __INLINE__ int _seg(const void *p) {            ///< data segment of a pointer
+        for (int i = 0; i < _nseg; i++) {
+            if ((U8*)p >= _oseg[i] && (U8*)p < _oseg[i] + T4_OSEG_SZ) return i;
+        }
+        return -1;
+    }
     __BOTH__ T4Base &du2obj(DU d) {                          ///< DU to Obj convertion
-        U32    off = DU2X(d) & ~T4_TYPE_MSK;
-        T4Base *t  = (T4Base*)(_obj + off);
+        U32    x  = DU2X(d) & ~T4_TYPE_MSK;
+        T4Base *t = (T4Base*)(_ohdr + ((U64)x << 1));
         return *t;
     }
     __BOTH__ DU     obj2du(T4Base &t) {                      ///< conver Obj to DU
-        U32 o = ((U32)((U8*)&t - _obj)) | T4_TT_OBJ;
+        if (!_hdr(&t)) {                                     /// * not in the object store
+            ERROR("mmu#obj2du unknown object %p\n", &t);
+            return DU0;
+        }
+        U32 o = (U32)(((U8*)&t - _ohdr) >> 1) | T4_TT_OBJ;
         return *(DU*)&o;
     }
     ///
     /// tensor object life-cycle methods
     ///
-    __GPU__  void   sweep();                                ///< free marked tensor
+    __GPU__  void   sweep();                                ///< free marked tensors, bounded per tick
+    __GPU__  void   compact()  { _cmpt = true; }            ///< defragment at next sweep
+    __GPU__  void   tally(bool reset=true);                 ///< report (and reset) counters
     __GPU__  void   drop(T4Base &t0);                       ///< reduce ref counter
     __GPU__  void   mark_free(DU v);                        ///< mark an object to be freed in host
-    __GPU__  Tensor &talloc(U64 sz);                        ///< allocate from tensor space
+    __GPU__  Tensor &talloc(U64 sz, t4_mtag tg=MT_TENSOR);  ///< allocate from tensor space
+    __GPU__  DU     *dalloc(U64 sz);                        ///< allocate tensor storage block
+    __GPU__  void   dfree(DU *d);                           ///< release tensor storage block
     __GPU__  Tensor &tensor(U64 sz);                        ///< create an vector
     __GPU__  Tensor &tensor(U32 h, U32 w);                  ///< create a matrix
-    __GPU__  Tensor &tensor(U32 n, U32 h, U32 w, U32 c);    ///< create a NHWC tensor
+    __GPU__  Tensor &tensor(U32 n, U32 h, U32 w, U32 c, t4_mtag tg=MT_TENSOR); ///< create a NHWC tensor
     __GPU__  void   resize(Tensor &t, U64 sz);              ///< resize the tensor storage
     __GPU__  void   free(Tensor &t);                        ///< free the tensor
-    __GPU__  Tensor &copy(Tensor &t0);                      ///< hard copy a tensor
+    __GPU__  Tensor &copy(Tensor &t0, t4_mtag tg=MT_TENSOR); ///< hard copy a tensor
     __GPU__  Tensor &slice(Tensor &t0, IU x0, IU x1, IU y0, IU y1);     ///< a slice of a tensor
 #if T4_ENABLE_NN    
     __GPU__  Dataset&dataset(U32 batch_sz);                 ///< create a NN dataset
     __GPU__  Model  &model(U32 sz=T4_NET_SZ);               ///< create a NN model
     __GPU__  void   free(Model &m);
 #endif // T4_ENABLE_NN
+private:
+    __GPU__  volatile U32 *_fslot(U64 i, bool grow);        ///< free queue slot i
+    __GPU__  void   *_malloc(U64 sz, bool obj=false);       ///< allocate an object header or data
+    __GPU__  void   _free(void *p);                         ///< free to the owning store
+    __GPU__  void   _tag(T4Base &t, int tg, S64 sz);        ///< account bytes to a site tag
+    __GPU__  void   _defrag();                              ///< relocate tensor data blocks
 #else  // !T4_ENABLE_OBJ ==========================================================
     __GPU__  void   sweep()    {}                           ///< holder for no object
+    __GPU__  void   compact()  {}
+    __GPU__  void   tally(bool reset=true) {}
     
 #endif // T4_ENABLE_OBJ ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 };
@@ -21,19 +21,51 @@ typedef enum {
     OPTI_ADAM                ///< Adam gradient
 } t4_optimizer;
 ///
-///< gradient function pointer
+///< multi-tensor apply entry, one per weight or bias tensor
+///
+typedef struct {
+    DU  *g, *dg, *m, *v;     ///< w, dw, momentum, velocity data
+    int N;                   ///< batch size (for dw average)
+    int numel;               ///< number of elements
+    int blk;                 ///< first block of this tensor in the launch
+} t4_mta;
+///
+///< gradient function pointer (one launch over the whole table)
 ///
 typedef void (*GdFunc)(
-    DU *parm, Tensor *w, Tensor *dw, Tensor *m, Tensor *v);
+    DU *parm, t4_mta *tbl, int n, int nblk);
+///
+///< layer ops launch on Model::_st, synced per op only on the default stream
+///
+#define ST_SYNC()    { if (!_st) GPU_SYNC(); }
+///
+///< SELU constants, shared by forward activation and planner recompute
+///
+#define SELU_L       1.0507      /** Selu lambda */
+#define SELU_LA      1.7581      /** Selu alpha  */
 ///
 ///< Neural Network Model class
 ///
 class Model : public T4Base {
     MMU    *_mmu;              ///< tensor storage base
     Tensor *_store;            ///< model storage - Sequential, TODO: DAG
-    Tensor *_hot  = NULL;      ///< cached dataset one-hot vector
+    Tensor *_hot  = NULL;      ///< cached one-hot or broadcast target vector
+    U32    *_lbl  = NULL;      ///< dataset labels of last batch (fused loss)
     int    _hit   = 0;         ///< hit counter
+    int    _xhit  = 0;         ///< fused kernel result, hit count
+    DU     _xsum  = DU0;       ///< fused kernel result, loss sum
     int    _iter  = 0;         ///< iteration counter (for Adam)
+    bool   _infer = false;     ///< inference mode (no gradient, ping-pong activations)
+    Tensor *_buf[2];           ///< ping-pong activation buffers (inference mode)
+    Tensor *_slot = NULL;      ///< arena slot handles (activation planner)
+    Tensor *_plan = NULL;      ///< [forward,backprop] slot per layer output
+    int    _mb    = 1;         ///< micro-batches per forward pass (1: not pipelined)
+    int    _nst   = 0;         ///< micro-batch streams created
+    STREAM _st    = 0;         ///< forward op launch stream (0: default, synced per op)
+    STREAM _mst[T4_MB_MAX];    ///< micro-batch (and replica) streams
+    int    _ndp   = 1;         ///< data-parallel replicas
+    int    _ndg   = 0;         ///< entries in _dpg
+    Tensor **_dpg = NULL;      ///< replica dw/db, [(_ndp-1) * numel * 2]
     
 public:
     int    epoch  = 0;         ///< TODO: for learning rate decay
@@ -52,6 +84,7 @@ public:
     __GPU__  Model  &npush(Tensor &t);
     __GPU__  DU     npop();
     __GPU__  int    batch_size();
+    __GPU__  bool   is_infer()  { return _infer; }
     /// @}
     /// @name main NN methods
     /// @{
@@ -61,10 +94,24 @@ public:
     __GPU__ Model  &backprop();                         ///< back propegation with default onehot vector (built during forward pass from dataset labels)
     __GPU__ Model  &backprop(Tensor &tgt);              ///< back propegation with given target vector
     /// @}
+    /// @name inference mode
+    /// @{
+    __GPU__ Model  &inference(bool on);                 ///< release/restore gradients, share activations
+    __GPU__ void   unshare();                           ///< detach layers from ping-pong buffers
+    __GPU__ Model  &plan(int mode);                     ///< activation memory planner 0:off, 1:reuse, 2:+recompute
+    __GPU__ Model  &fuse(bool on);                      ///< fuse/split conv2d+pool+activation blocks
+    __GPU__ Model  &pipe(int n);                        ///< split forward into n micro-batches on streams, 0: release
+    __GPU__ Model  &dp(int n);                          ///< n data-parallel replicas, 1: release
+    /// @}
+    /// @name INT8 quantized inference
+    /// @{
+    __GPU__ Model  &quantize();                         ///< post-training INT8 quantization of conv/linear weights
+    __GPU__ Model  &predict(Tensor &input);             ///< inference-only forward with INT8 conv/linear
+    /// @}
     /// @name loss functions
     /// @{
     __GPU__ Tensor &onehot();                           ///< get default onehot vector
-    __GPU__ Tensor &onehot(Dataset &dset);              ///< create one-hot vector from dataset labels (called in forward pass)
+    __GPU__ Tensor &onehot(Dataset &dset);              ///< fill cached one-hot vector from dataset labels
     __GPU__ int    hit(bool recalc=false);              ///< calculate hit count
     __GPU__ DU     loss(t4_loss op);                    ///< calc loss with cached one-hot vector
     __GPU__ DU     loss(t4_loss op, Tensor &tgt);       ///< calc loss from tgt vector
@@ -104,11 +151,29 @@ private:
     __GPU__ void   _ipool(Tensor &in, U16 n, t4_layer fn);          ///< pooling with nxn filter
     __GPU__ void   _ibatchnorm(Tensor &in, DU m);   ///< batch norm with momentum=m
     __GPU__ void   _iup(Tensor &in, U16 f, DU m);   ///< upsample with nxn filter
+    __GPU__ bool   _ifuse(U16 i, bool on);          ///< fuse conv2d block at layer i
+    /// @}
+    /// @name inference mode helpers
+    /// @{
+    __GPU__ U64    _igrad(Tensor &in, bool on);     ///< release/restore layer gradients
+    __GPU__ U64    _ishare(bool on);                ///< share layer outputs in ping-pong buffers
+    /// @}
+    /// @name activation planner helpers
+    /// @{
+    __GPU__ void   _unplan(bool restore);           ///< release arena slots
+    __GPU__ void   _bind(int ph);                   ///< point layer outputs to slots of a phase
+    __GPU__ bool   _keepx(U16 j, int mode);         ///< tensor j needed in backprop
+    __GPU__ void   _recompute(U16 j);               ///< regenerate checkpointed X
     /// @}
     /// @name forward ops
     /// @{
     __GPU__ void   _fstep(Tensor &in, Tensor &out);
+    __GPU__ void   _fpipe();                        ///< micro-batch pipelined layer cascade
+    __GPU__ bool   _fpipe_ok(Tensor &in);           ///< layer can run per micro-batch on a stream
+    __GPU__ void   _fcopy(Tensor &in, Tensor &out); ///< straight copy on launch stream
+    __GPU__ void   _streams(int n);                 ///< create micro-batch streams up to n
     __GPU__ int    _fconv(Tensor &in, Tensor &out);
+    __GPU__ int    _ffuse(U16 i);                   ///< conv2d+pool+activation in one pass
     __GPU__ int    _flinear(Tensor &in, Tensor &out);
     __GPU__ int    _factivate(Tensor &in, Tensor &out, t4_layer fn);
     __GPU__ int    _fpool(Tensor &in, Tensor &out, t4_layer fn);
@@ -117,13 +182,27 @@ private:
     __GPU__ int    _fbatchnorm(Tensor &in, Tensor &out);
     __GPU__ int    _fupsample(Tensor &in, Tensor &out);
     /// @}
+    /// @name INT8 ops
+    /// @{
+    __GPU__ void   _qweight(Tensor &in);
+    __GPU__ void   _qstep(Tensor &in, Tensor &out);
+    __GPU__ DU     _qinput(Tensor &in, Tensor &q, int C1, int C4);
+    __GPU__ int    _qconv(Tensor &in, Tensor &out);
+    __GPU__ int    _qlinear(Tensor &in, Tensor &out);
+    /// @}
     /// @name backward ops
     /// @{
     __GPU__ int    _bloss(Tensor &tgt);
+    __GPU__ int    _bloss();                        ///< dLoss from labels
+    __GPU__ int    _xloss(t4_loss op, DU *sum);     ///< fused loss and hit count from labels
+    __GPU__ Model  &_bprop();                       ///< backprop layers from dLoss in output
+    __GPU__ Model  &_dprop();                       ///< backprop shards on replicas, reduce dw/db
+    __GPU__ void   _dpreduce();                     ///< sum replica dw/db into the model's
     __GPU__ void   _bstep(Tensor &in, Tensor &out);
     __GPU__ int    _bconv(Tensor &in, Tensor &out);
     __GPU__ int    _blinear(Tensor &in, Tensor &out);
     __GPU__ int    _bactivate(Tensor &in, Tensor &out);
+    __GPU__ int    _bactivate_x(Tensor &in, Tensor &out);   ///< derivative from X (no mask)
     __GPU__ int    _bpool(Tensor &in, Tensor &out, t4_layer fn);
     __GPU__ int    _bupsample(Tensor &in, Tensor &out, t4_layer fn);
     __GPU__ int    _bbatchnorm(Tensor &in, Tensor &out);
@@ -136,4 +215,16 @@ private:
     /// @}
 };
 
+///
+///< view of samples [n0, n0+n) of a layer tensor in buf, storage shared
+///
+__GPU__ __INLINE__ Tensor&
+_mview(Tensor &t, U8 *buf, int n0, int n) {
+    Tensor &v = *(Tensor*)memcpy(buf, &t, sizeof(Tensor));
+    v.data  = t.slice(n0);
+    v.N()   = n;
+    v.numel = v.HWC() * n;
+    return v;
+}
+
 #endif // __MMU_MODEL_H
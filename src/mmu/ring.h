@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @brief Ring classes - bounded lock-free queues between VMs (or host threads)
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#ifndef __MMU_RING_H
+#define __MMU_RING_H
+#include "ten4_types.h"
+///
+///@name portable atomics, device or host (gcc builtins)
+///@{
+#if defined(__CUDA_ARCH__)
+#define RING_LD(p)        ({ U32 _v = *(volatile U32*)&(p); __threadfence(); _v; })
+#define RING_ST(p, v)     { __threadfence(); *(volatile U32*)&(p) = (v); }
+#define RING_CAS(p, o, n) (atomicCAS((U32*)&(p), (o), (n)) == (o))
+#define RING_PAUSE()      { U64 _t = clock64() + 256; while ((U64)clock64() < _t); }
+#else  // !__CUDA_ARCH__
+#include <sched.h>
+#define RING_LD(p)        __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define RING_ST(p, v)     __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#define RING_CAS(p, o, n) ({ U32 _o = (o);                                  \
+            __atomic_compare_exchange_n(&(p), &_o, (n), false,              \
+                __ATOMIC_ACQ_REL, __ATOMIC_RELAXED); })
+#define RING_PAUSE()      sched_yield()
+#endif // __CUDA_ARCH__
+///@}
+///
+/// SPSC - single producer, single consumer (Lamport)
+/// @brief head/tail free running, a batch is published by one release store,
+///        so n items pushed together are seen together
+///
+template<typename T, int N>                  ///< N power of 2
+struct SPSC {
+    U32 head = 0;                            ///< producer position
+    U32 tail = 0;                            ///< consumer position
+    T   q[N];
+
+    __BOTH__ void init()    { head = tail = 0; }
+    __BOTH__ int  size()    { return (int)(RING_LD(head) - RING_LD(tail)); }
+    __BOTH__ int  room()    { return N - size(); }
+
+    __BOTH__ bool try_push(const T *v, int n=1) {   ///< all n or none
+        U32 h = head;                        /// * only producer writes head
+        if (N - (int)(h - RING_LD(tail)) < n) return false;
+        for (int i = 0; i < n; i++) q[(h + i) & (N - 1)] = v[i];
+        RING_ST(head, h + n);
+        return true;
+    }
+    __BOTH__ bool try_pop(T *v, int n=1) {
+        U32 t = tail;                        /// * only consumer writes tail
+        if ((int)(RING_LD(head) - t) < n) return false;
+        for (int i = 0; i < n; i++) v[i] = q[(t + i) & (N - 1)];
+        RING_ST(tail, t + n);
+        return true;
+    }
+    __BOTH__ void push(const T *v, int n=1) { while (!try_push(v, n)) RING_PAUSE(); }
+    __BOTH__ void pop(T *v, int n=1)        { while (!try_pop(v, n))  RING_PAUSE(); }
+    ///
+    /// zero-copy consumer, read the slot in place then release it
+    ///
+    __BOTH__ T    *front() { return RING_LD(head) == tail ? NULL : &q[tail & (N - 1)]; }
+    __BOTH__ void next()   { RING_ST(tail, tail + 1); }
+};
+///
+/// MPMC - multiple producers and consumers (per-slot sequence, Vyukov)
+/// @brief a batch of n claims n consecutive slots with one CAS, so items of
+///        one message are never interleaved with another sender's
+///
+template<typename T, int N>                  ///< N power of 2
+struct MPMC {
+    struct Slot { U32 seq; T v; };
+    U32  head = 0;                           ///< next slot to claim for push
+    U32  tail = 0;                           ///< next slot to claim for pop
+    Slot q[N];
+
+    __BOTH__ void init() {
+        head = tail = 0;
+        for (U32 i = 0; i < N; i++) q[i].seq = i;
+    }
+    __BOTH__ int  size() { return (int)(RING_LD(head) - RING_LD(tail)); }
+
+    __BOTH__ bool try_push(const T *v, int n=1) {   ///< all n or none
+        if (n < 1 || n > N) return n == 0;
+        U32 p = RING_LD(head);
+        for (;;) {
+            int i = 0;                       /// * slots p..p+n-1 free?
+            for (; i < n; i++) {
+                if (RING_LD(q[(p + i) & (N - 1)].seq) != p + i) break;
+            }
+            if (i < n) {
+                Slot &s = q[(p + i) & (N - 1)];
+                if ((int)(RING_LD(s.seq) - (p + i)) < 0) return false;  /// * full
+                p = RING_LD(head);           /// * lost race, reload
+                continue;
+            }
+            if (RING_CAS(head, p, p + n)) break;
+            p = RING_LD(head);
+        }
+        for (int i = 0; i < n; i++) {
+            Slot &s = q[(p + i) & (N - 1)];
+            s.v = v[i];
+            RING_ST(s.seq, p + i + 1);       /// * publish to consumers
+        }
+        return true;
+    }
+    __BOTH__ bool try_pop(T *v, int n=1) {
+        if (n < 1 || n > N) return n == 0;
+        U32 p = RING_LD(tail);
+        for (;;) {
+            int i = 0;                       /// * slots p..p+n-1 published?
+            for (; i < n; i++) {
+                if (RING_LD(q[(p + i) & (N - 1)].seq) != p + i + 1) break;
+            }
+            if (i < n) {
+                Slot &s = q[(p + i) & (N - 1)];
+                if ((int)(RING_LD(s.seq) - (p + i + 1)) < 0) return false; /// * empty
+                p = RING_LD(tail);
+                continue;
+            }
+            if (RING_CAS(tail, p, p + n)) break;
+            p = RING_LD(tail);
+        }
+        for (int i = 0; i < n; i++) {
+            Slot &s = q[(p + i) & (N - 1)];
+            v[i] = s.v;
+            RING_ST(s.seq, p + i + N);       /// * free for next lap
+        }
+        return true;
+    }
+    __BOTH__ bool peek(T &v) {               ///< front item, single consumer only
+        Slot &s = q[tail & (N - 1)];
+        if (RING_LD(s.seq) != tail + 1) return false;
+        v = s.v;
+        return true;
+    }
+    __BOTH__ void push(const T *v, int n=1) { while (!try_push(v, n)) RING_PAUSE(); }
+    __BOTH__ void pop(T *v, int n=1)        { while (!try_pop(v, n))  RING_PAUSE(); }
+};
+#endif // __MMU_RING_H
@@ -64,15 +64,17 @@ k_var(DU *I, DU *avg, DU *var, int HW) {
 __KERN__ void
 k_matmul(
     DU *A, DU *B, DU *O,   /* O[NxHxWxC] = A[NxHxKxC] @ B[NxKxWxC] */
-    int H, int W, int K,
+    int H, int W, int K, int C,
+    U64 sA, U64 sB, U64 sO,                                ///< slice strides (sA=0 broadcast)
     t4_mm_opt opt)
 {
     const int i  = threadIdx.y + blockIdx.y * blockDim.y;  ///< H
     const int j  = threadIdx.x + blockIdx.x * blockDim.x;  ///< W
-    const int c  = blockIdx.z,  C = gridDim.z;             ///< C
+    const int c  = blockIdx.z % C, n = blockIdx.z / C;     ///< C, batch slice
     const int z0 = c + (j + i * W) * C;                    ///< output matrix index
+    A += n * sA; B += n * sB; O += n * sO;                 /// * slice n
     
-    if (i < H && j < W && c < C) {                         /// * TODO: tiled
+    if (i < H && j < W) {                                  /// * TODO: tiled
         DU  *ax, *bx;
         int ai, bi;
         if (opt & MM_A_TXP) {                              /// * transpose A
@@ -104,16 +106,18 @@ k_matmul(
 __KERN__ void
 k_gemm(
     DU *A, DU *B, DU *O,  /* O[HxWxC] = a * A[HxKxC] @ B[KxWxC] + b * O[HxWxC] */
-    int H, int W, int K,
+    int H, int W, int K, int C,
+    U64 sA, U64 sB, U64 sO,                                ///< slice strides (sA=0 broadcast)
     DU alpha, DU beta)
 {
     const int i = threadIdx.y + blockIdx.y * blockDim.y;   ///< H
     const int j = threadIdx.x + blockIdx.x * blockDim.x;   ///< W
-    const int c = blockIdx.z, C = gridDim.z;               ///< channel deep
+    const int c = blockIdx.z % C, n = blockIdx.z / C;      ///< channel deep, batch slice
     const int WC= W * C;
     const int z0= c + (j + i * W) * C;                     ///< output index
+    A += n * sA; B += n * sB; O += n * sO;                 /// * slice n
 
-    if (i < H && j < W && c < C) {                         /// * TODO: tiled
+    if (i < H && j < W) {                                  /// * TODO: tiled
         DU *ax = &A[c + i * K * C];
         DU *bx = &B[c + j * C];
         DU2 acc = DU0;                                     /// * TODO: suffle sum
@@ -124,6 +128,216 @@ k_gemm(
     }
 }
 ///
+///> blocked LU kernels (row-major A[n,n], panel width T4_LU_NB)
+///  panel factorization with partial pivoting, one block
+///
+__KERN__ void
+k_lu_panel(DU *A, DU *P, int *ns, int n, int k, int nb, bool pivot) {
+    __shared__ DU  _v[T4_WARP_SQ];                         ///< pivot candidates
+    __shared__ int _i[T4_WARP_SQ];
+    const int t = threadIdx.x, T = blockDim.x;
+
+    for (int j = k; j < k + nb; j++) {
+        int u = j;                                         ///< pivot row
+        if (pivot) {                                       /// * parallel argmax
+            DU v = -DU1; int iu = j;
+            for (int i = j + t; i < n; i += T) {
+                DU a = ABS(A[j + i * n]);
+                if (a > v) { v = a; iu = i; }
+            }
+            _v[t] = v; _i[t] = iu;
+            __syncthreads();
+            for (int s = T >> 1; s > 0; s >>= 1) {         /// * first max wins
+                if (t < s && (_v[t + s] > _v[t] ||
+                    (_v[t + s] == _v[t] && _i[t + s] < _i[t]))) {
+                    _v[t] = _v[t + s]; _i[t] = _i[t + s];
+                }
+                __syncthreads();
+            }
+            u = _i[0];
+        }
+        if (u != j) {                                      /// * swap entire rows
+            for (int c = t; c < n; c += T) {
+                DU x = A[c + j * n]; A[c + j * n] = A[c + u * n]; A[c + u * n] = x;
+            }
+            if (t == 0) {
+                DU x = P[j]; P[j] = P[u]; P[u] = x;
+                *ns += 1;
+            }
+        }
+        __syncthreads();
+        DU ra = A[j + j * n];
+        if (ABS(ra) < DU_EPS) continue;                    /// * if 0 skip the column
+        for (int i = j + 1 + t; i < n; i += T) {           /// * rank-1 update of panel
+            DU r1 = A[j + i * n] /= ra;                    /// L stored in A to save space
+            for (int c = j + 1; c < k + nb; c++) {
+                A[c + i * n] -= r1 * A[c + j * n];
+            }
+        }
+        __syncthreads();
+    }
+}
+///
+/// U12 = L11^-1 A12, one thread per column right of the panel
+///
+__KERN__ void
+k_lu_trsm(DU *A, int n, int k, int nb) {
+    const int c = k + nb + threadIdx.x + blockIdx.x * blockDim.x;
+
+    if (c < n) {
+        for (int r = k + 1; r < k + nb; r++) {             /// * unit lower triangle
+            DU acc = A[c + r * n];
+            for (int q = k; q < r; q++) acc -= A[q + r * n] * A[c + q * n];
+            A[c + r * n] = acc;
+        }
+    }
+}
+///
+/// trailing matrix update A22 -= L21 @ U12 (16x16 tiles)
+///
+__KERN__ void
+k_lu_gemm(DU *A, int n, int k, int nb) {
+    __shared__ DU _L[T4_WARP_SZ][T4_WARP_SZ];
+    __shared__ DU _U[T4_WARP_SZ][T4_WARP_SZ];
+    const int tx = threadIdx.x, ty = threadIdx.y;
+    const int j  = k + nb + tx + blockIdx.x * T4_WARP_SZ;  ///< column
+    const int i  = k + nb + ty + blockIdx.y * T4_WARP_SZ;  ///< row
+    const int k1 = k + nb;
+
+    DU acc = DU0;
+    for (int q0 = k; q0 < k1; q0 += T4_WARP_SZ) {
+        _L[ty][tx] = (i < n && q0 + tx < k1) ? A[q0 + tx + i * n] : DU0;
+        _U[ty][tx] = (j < n && q0 + ty < k1) ? A[j + (q0 + ty) * n] : DU0;
+        __syncthreads();
+        #pragma unroll
+        for (int q = 0; q < T4_WARP_SZ; q++) acc += _L[ty][q] * _U[q][tx];
+        __syncthreads();
+    }
+    if (i < n && j < n) A[j + i * n] -= acc;
+}
+///
+/// solve LU X = P B, one block per right-hand-side column
+/// Note: B=NULL for identity (i.e. inverse), P=NULL for no permutation
+///
+__KERN__ void
+k_lu_solve(DU *LU, DU *P, DU *B, DU *X, int n, int m) {
+    const int c = blockIdx.x, t = threadIdx.x, T = blockDim.x;
+
+    for (int i = t; i < n; i += T) {                       /// * X = P B
+        int r = P ? INT(P[i]) : i;
+        X[c + i * m] = B ? B[c + r * m] : (r == c ? DU1 : DU0);
+    }
+    __syncthreads();
+    for (int i = 0; i < n; i++) {                          /// * forward, unit L
+        DU xi = X[c + i * m];
+        for (int r = i + 1 + t; r < n; r += T) X[c + r * m] -= LU[i + r * n] * xi;
+        __syncthreads();
+    }
+    for (int i = n - 1; i >= 0; i--) {                     /// * backward, U
+        DU xi = X[c + i * m] / LU[i + i * n];
+        __syncthreads();
+        if (t == 0) X[c + i * m] = xi;
+        for (int r = t; r < i; r += T) X[c + r * m] -= LU[i + r * n] * xi;
+        __syncthreads();
+    }
+}
+///
+/// L^-1 (unit, below diag) and U^-1 (on and above diag) stacked, one block per column
+///
+__KERN__ void
+k_lu_tinv(DU *LU, DU *X, int n) {
+    const int c = blockIdx.x, t = threadIdx.x, T = blockDim.x;
+
+    for (int r = t; r < n; r += T) X[c + r * n] = (r == c) ? DU1 : DU0;
+    __syncthreads();
+    for (int i = c; i < n; i++) {                          /// * L x = e_c
+        DU xi = (i == c) ? DU1 : X[c + i * n];
+        for (int r = i + 1 + t; r < n; r += T) X[c + r * n] -= LU[i + r * n] * xi;
+        __syncthreads();
+    }
+    for (int i = c; i >= 0; i--) {                         /// * U y = e_c
+        DU yi = X[c + i * n] / LU[i + i * n];
+        __syncthreads();
+        if (t == 0) X[c + i * n] = yi;
+        for (int r = t; r < i; r += T) X[c + r * n] -= LU[i + r * n] * yi;
+        __syncthreads();
+    }
+}
+///
+///> batched small-matrix PLU, one block per slice in shared memory
+///  optional outputs: P permutation, D determinant (NaN if singular), I inverse
+///  slices with a zero pivot are counted in *sg, their I is left untouched
+///
+__KERN__ void
+k_bplu(DU *A, DU *P, DU *D, DU *I, int *sg, int n, bool pivot) {
+    extern __shared__ DU _a[];                             ///< slice [n,n]
+    __shared__ int _u, _ns, _sg;                           ///< pivot row, swaps, singular
+    int *pv = (int*)&_a[n * n];                            ///< permutation [n]
+    const int t = threadIdx.x, T = blockDim.x;
+    const int nn = n * n;
+    DU  *ax = &A[(U64)blockIdx.x * nn];                    ///< slice data
+
+    for (int e = t; e < nn; e += T) _a[e] = ax[e];
+    for (int z = t; z < n;  z += T) pv[z] = z;
+    if (t == 0) _ns = _sg = 0;
+    __syncthreads();
+
+    for (int z = 0; z < n; z++) {
+        if (t == 0) {                                      /// * pivot (n is small)
+            int u = z;
+            for (int i = z + 1; pivot && i < n; i++) {
+                if (ABS(_a[z + i * n]) > ABS(_a[z + u * n])) u = i;
+            }
+            _u = u;
+            if (u != z) {
+                int x = pv[z]; pv[z] = pv[u]; pv[u] = x;
+                _ns++;
+            }
+        }
+        __syncthreads();
+        const int u = _u;
+        if (u != z) {                                      /// * swap entire rows
+            for (int k = t; k < n; k += T) {
+                DU x = _a[k + z * n]; _a[k + z * n] = _a[k + u * n]; _a[k + u * n] = x;
+            }
+            __syncthreads();
+        }
+        DU   ra = _a[z + z * n];
+        bool ok = ABS(ra) >= DU_EPS;                       ///< if 0 skip the column
+        if (!ok && t == 0) _sg = 1;
+        for (int y = z + 1 + t; ok && y < n; y += T) _a[z + y * n] /= ra;
+        __syncthreads();
+        const int m = ok ? n - z - 1 : 0;                  ///< trailing size
+        for (int e = t; e < m * m; e += T) {               /// * rank-1 update
+            int y = z + 1 + e / m, k = z + 1 + e % m;
+            _a[k + y * n] -= _a[z + y * n] * _a[k + z * n];
+        }
+        __syncthreads();
+    }
+    for (int e = t; e < nn; e += T) ax[e] = _a[e];         /// * L\U in-place
+    if (P) for (int z = t; z < n; z += T) P[blockIdx.x * n + z] = pv[z];
+    if (_sg && t == 0) atomicAdd(sg, 1);
+    if (D && t == 0) {                                     /// * determinant
+        DU v = (_ns & 1) ? -DU1 : DU1;
+        for (int z = 0; z < n; z++) v *= _a[z + z * n];
+        D[blockIdx.x] = _sg ? (DU)NAN : v;
+    }
+    if (!I || _sg) return;
+    DU *ix = &I[(U64)blockIdx.x * nn];                     ///< inverse slice
+    for (int c = t; c < n; c += T) {                       /// * one column per thread
+        for (int i = 0; i < n; i++) {                      /// * forward, unit L
+            DU x = pv[i] == c ? DU1 : DU0;
+            for (int k = 0; k < i; k++) x -= _a[k + i * n] * ix[c + k * n];
+            ix[c + i * n] = x;
+        }
+        for (int i = n - 1; i >= 0; i--) {                 /// * backward, U
+            DU x = ix[c + i * n];
+            for (int k = i + 1; k < n; k++) x -= _a[k + i * n] * ix[c + k * n];
+            ix[c + i * n] = x / _a[i + i * n];
+        }
+    }
+}
+///
 /// Binary Cross-Entropy (clamps output to >= -100)
 ///
 __KERN__ void
@@ -178,12 +392,15 @@ Tensor::mm(
     }
     MM_DB("  tensor#matmul K=%d => NHWC=[%d,%d,%d,%d]\n", Ka, N, H, W, C);
     
+    const U64 sA = A.N() == N ? A.HWC() : 0;       ///< per-slice A or broadcast
     dim3 blk(T4_WARP_SZ, T4_WARP_SZ, 1);
-    dim3 grd(NGRID(W, H, C, blk));
 
-    for (int n = 0; n < N; n++) {
-        DU *da = A.data, *db = B.slice(n), *dx = O.slice(n);
-        k_matmul<<<grd,blk>>>(da, db, dx, H, W, Ka, opt);
+    for (U32 n = 0; n < N; n += T4_BATCH_Z / C) { /// * all slices in one launch
+        U32  nz = (N - n) < T4_BATCH_Z / C ? (N - n) : T4_BATCH_Z / C;
+        dim3 grd(NGRID(W, H, nz * C, blk));
+        k_matmul<<<grd,blk>>>(
+            A.data + n * sA, B.slice(n), O.slice(n),
+            H, W, Ka, C, sA, B.HWC(), O.HWC(), opt);
     }
     return O;
 }
@@ -200,12 +417,15 @@ Tensor::gemm(Tensor &A, Tensor &B, Tensor &O, DU alpha, DU beta) {
     }
     MM_DB("  tensor#gemm K=%d, a=%g, b=%g => NHWC=[%d,%d,%d,%d]\n",
           Ka, alpha, beta, N, H, W, C);
+    const U64 sA = A.N() == N ? A.HWC() : 0;       ///< per-slice A or broadcast
     dim3 blk(T4_WARP_SZ, T4_WARP_SZ, 1);
-    dim3 grd(NGRID(W, H, C, blk));
 
-    for (int n = 0; n < N; n++) {
-        DU *da = A.data, *db = B.slice(n), *dx = O.slice(n);
-        k_gemm<<<grd, blk>>>(da, db, dx, H, W, Ka, alpha, beta);
+    for (U32 n = 0; n < N; n += T4_BATCH_Z / C) { /// * all slices in one launch
+        U32  nz = (N - n) < T4_BATCH_Z / C ? (N - n) : T4_BATCH_Z / C;
+        dim3 grd(NGRID(W, H, nz * C, blk));
+        k_gemm<<<grd, blk>>>(
+            A.data + n * sA, B.slice(n), O.slice(n),
+            H, W, Ka, C, sA, B.HWC(), O.HWC(), alpha, beta);
     }
     return O;
 }
@@ -232,64 +452,62 @@ Tensor::transpose(Tensor &A, Tensor &T) {
     return T;
 }
 ///
-/// matrix inversion (Gauss-Jordan with Pivot)
-/// Note: Gauss-Jordan elimination is expensive O(N^3)
-/// TODO: CDP
+/// blocked right-looking LU, returns number of row swaps
+/// Note: A stores both L and U in-place, P (optional) is permutation vector
+///
+__GPU__ int
+Tensor::_lu(DU *da, DU *dp, int n, bool pivot) {
+    int *ns = new int(0);                    ///< per call, device heap seen by child kernels
+    for (int k = 0; k < n; k += T4_LU_NB) {
+        const int nb = (n - k) < T4_LU_NB ? (n - k) : T4_LU_NB;
+        const int nr = n - k - nb;           ///< trailing matrix size
+        k_lu_panel<<<1, T4_WARP_SQ>>>(da, dp, ns, n, k, nb, pivot);
+        if (nr <= 0) break;
+
+        dim3 blk(T4_WARP_SZ, T4_WARP_SZ, 1);
+        dim3 grd((nr + T4_WARP_SZ - 1) / T4_WARP_SZ, (nr + T4_WARP_SZ - 1) / T4_WARP_SZ, 1);
+        k_lu_trsm<<<(nr + T4_WARP_SQ - 1) / T4_WARP_SQ, T4_WARP_SQ>>>(da, n, k, nb);
+        k_lu_gemm<<<grd, blk>>>(da, n, k, nb);
+    }
+    GPU_SYNC();
+    int rst = *ns;
+    delete ns;
+    return rst;
+}
+///
+/// any zero pivot (det may under/overflow for large n)
+///
+__GPU__ __INLINE__ bool
+_singular(DU *d, U32 n) {
+    for (U32 z = 0; z < n; z++) if (ABS(d[z + z * n]) < DU_EPS) return true;
+    return false;
+}
+///
+/// matrix inversion (PLU and triangular solves)
+/// Note: A is overwritten by its LU, I receives A^-1
 ///
 __GPU__ Tensor&
 Tensor::inverse(Tensor &A, Tensor &I) {
     U32 m = A.H(), n = A.W();
     MM_DB("  tensor#inverse [%d,%d]\n", m, n);
     if (m != n) { ERROR("square matrix?"); return I; }
-    DU *da = A.data, *di = I.data;
-    auto swap_rows = [da, di, n](U32 u, U32 z) {
-        for (U32 k = 0; k < n; k++) {         ///> TODO: swap entire row
-            DU ta = da[k + z * n], ti = di[k + z * n];
-            da[k + z * n] = da[k + u * n]; da[k + u * n] = ta;
-            di[k + z * n] = di[k + u * n]; di[k + u * n] = ti;
-        }
-    };
-    auto find_max = [da, n](U32 z) {
-        int u = z;
-        for (U32 i = z + 1; i < n; i++) {    ///> TODO: CDP reduce
-            if (ABS(da[z + i * n]) > ABS(da[z + u * n])) u = i;
-        }
-        if (ABS(da[z + u * n]) < DU_EPS) {
-            ERROR("tensor#inverse sigular!\n");
-            return -1;
-        }
-        return u;
-    };
-    auto diag = [da, di, n](U32 z) {
-        DU r0 = da[z + z * n];
-        for (U32 k = 0; k < n; k++) {
-            U32 i = k + z * n;
-            di[i] /= r0;
-            da[i] /= r0;
-        }};
-    auto elim = [da, di, n](U32 z) {
-        for (U32 i = 0; i < n; i++) {
-            DU r1 = da[z + i * n];
-            for (U32 k = 0; i!=z && k < n; k++) {
-                di[k + i * n] -= r1 * di[k + z * n];
-                da[k + i * n] -= r1 * da[k + z * n];
-            }
-        }};
-    for (U32 z = 0; z < n; z++) {
-        int u = find_max(z);
-        if (u < 0) break;
-        else if (u != z) {
-            swap_rows(u, z);
-        }
-        diag(z);
-        elim(z);
+
+    DU *dp = new DU[n];                      ///< permutation vector
+    for (U32 z = 0; z < n; z++) dp[z] = z;
+    _lu(A.data, dp, n, true);
+    if (_singular(A.data, n)) {
+        ERROR("tensor#inverse sigular!\n");
     }
+    else {
+        k_lu_solve<<<n, T4_WARP_SQ>>>(A.data, dp, NULL, I.data, n, n);
+        GPU_SYNC();
+    }
+    delete[] dp;
     return I;
 }
 ///
 /// LU decomposition (no Pivot)
 /// Note: A stores both L and U in-place to save space
-/// TODO: CDP
 ///
 __GPU__ Tensor&
 Tensor::lu(Tensor &A) {
@@ -297,66 +515,45 @@ Tensor::lu(Tensor &A) {
     MM_DB("  tensor#lu [%d,%d]\n", m, n);
     if (m != n) { ERROR("square matrix?"); return A; }
 
-    DU *da = A.data;
-    auto elim = [da, n](U32 z) {
-        DU ra = da[z + z * n];
-        if (fabs(ra) < DU_EPS) return;      /// * if 0 skip the row
-        for (U32 y = z + 1; y < n; y++) {
-            DU r1 = da[z + y * n] / ra;     /// * substitution
-            for (U32 k = z; k < n; k++) {
-                da[k + y * n] -= r1 * da[k + z * n];
-            }
-            da[z + y * n] = r1;             /// L stored in A to save space
-        }
-    };
-    for (U32 z = 0; z < n; z++) {
-        elim(z);               /// * eliminate variables in upper triangle
-	}
+    _lu(A.data, NULL, n, false);
     return A;
 }
 ///
-/// LU (preprocessed) matrix inversion
-/// TODO: CDP
+/// LU (preprocessed) matrix inversion, I = L^-1\U^-1 stacked
+/// Note: A^-1 = U^-1 @ L^-1, returns -1 (I untouched) if LU is singular
 ///
-__GPU__ Tensor&
-Tensor::lu_inverse(Tensor &LU) {
+__GPU__ int
+Tensor::lu_inverse(Tensor &LU, Tensor &I) {
     U32 m = LU.H(), n = LU.W();
     MM_DB("  tensor#lu_inverse [%d,%d]\n", m, n);
-    DU *dd = LU.data;
-    auto forward = [dd, n](int z) {
-        for (int y = z + 1; y < n; y++) {
-            DU r1 = dd[z + y * n];
-            for (int k = 0; k < z; k++) {               // columns before
-                dd[k + y * n] -= dd[k + z * n] * r1;
-            }
-            dd[z + y * n] = -r1;                        // current z column
-        }};
-    auto backward = [dd, n](int z) {
-        DU r0 = RCP(dd[z + z * n]);
-        dd[z + z * n] = r0;                             // diag
-        for (int k = z + 1; k < n; k++) {               // current z row
-            dd[k + z * n] *= r0;
-        }
-        for (int y = 0; y < z; y++) {                   // factorize rows above
-            DU r1 = dd[z + y * n];
-            dd[z + y *  n] = -r1 * r0;                  // current z column
-            for (int k = z + 1; k < n; k++) {           // columns after
-                dd[k + y * n] -= dd[k + z * n] * r1;
-            }
-        }};
-    
-    if (LU.det() < DU_EPS) return LU;
-    
-    for (int z = 0; z < n - 1; z++)  forward(z);
-    for (int z = n - 1; z >= 0; z--) backward(z);
-    
-    return LU;
+    if (_singular(LU.data, n)) {
+        ERROR("tensor#lu_inverse sigular!\n");
+        return -1;
+    }
+    k_lu_tinv<<<n, T4_WARP_SQ>>>(LU.data, I.data, n);
+    GPU_SYNC();
+    return 0;
+}
+///
+/// solve A X = B with PLU of A (B vector or matrix), X receives result
+/// Note: returns -1 (X untouched) if LU is singular
+///
+__GPU__ int
+Tensor::lu_solve(Tensor &LU, Tensor &P, Tensor &B, Tensor &X) {
+    U32 n = LU.H(), m = B.rank == 1 ? 1 : B.W();
+    MM_DB("  tensor#lu_solve [%d,%d] x [%d,%d]\n", n, n, n, m);
+    if (_singular(LU.data, n)) {
+        ERROR("tensor#lu_solve sigular!\n");
+        return -1;
+    }
+    k_lu_solve<<<m, T4_WARP_SQ>>>(LU.data, P.data, B.data, X.data, n, m);
+    GPU_SYNC();
+    return 0;
 }
 ///
 /// PLU methods with permutation vector
 /// Note: A stores both L and U in-place to save space, use triu, trul to extract
 ///       P is permutation vector
-/// TODO: CDP
 ///
 __GPU__ Tensor&
 Tensor::plu(Tensor &A, Tensor &P, int *ns) {
@@ -364,50 +561,36 @@ Tensor::plu(Tensor &A, Tensor &P, int *ns) {
     MM_DB("  tensor#plu [%d,%d]\n", m, n);
     if (m != n) { ERROR("square matrix?"); return A; }
 
-    DU *da = A.data, *dp = P.data;
-    *ns = 0;                                  ///> initialize flip sign
-    auto swap_rows = [da, dp, n](U32 u, U32 z) {
-        DU t = dp[z]; dp[z] = dp[u]; dp[u] = t;
-        for (U32 k = z; k < n; k++) {         ///> TODO: swap entire row
-            t = da[k + z * n];
-            da[k + z * n] = da[k + u * n];
-            da[k + u * n] = t;
-        }
-    };
-    auto find_max = [da, n](U32 z) {
-        int u = z;
-        for (U32 i = z + 1; i < n; i++) {    ///> TODO: CDP reduce
-            if (ABS(da[z + i * n]) > ABS(da[z + u * n])) u = i;
-        }
-        if (ABS(da[z + u * n]) < DU_EPS) {
-            MM_DB("  tensor#lu sigular!\n");
-            return -1;
-        }
-        return u;
-    };
-    auto elim = [da, n](U32 z) {
-        DU ra = da[z + z * n];
-        if (fabs(ra) < DU_EPS) return;       /// * if 0 skip the row
-        for (U32 y = z + 1; y < n; y++) {
-            DU r1 = da[z + y * n] / ra;      /// * substitution
-            for (U32 k = z; k < n; k++) {
-                da[k + y * n] -= r1 * da[k + z * n];
-            }
-            da[z + y * n] = r1;              /// L stored in A to save space
-        }
-    };
+    DU *dp = P.data;
     for (U32 z = 0; z < m; z++) dp[z] = z;   /// init permutation vector
-    for (U32 z = 0; z < n; z++) {
-        int u = find_max(z);   /// * pivot to reduce rounding error
-        if (u < 0) return A;
-        if (u != z) {          /// * swapping row which has maximum xth column element
-            swap_rows(u, z);
-            *ns += 1;
-        }
-        elim(z);               /// * eliminate variables in upper triangle
-    }
+    *ns = _lu(A.data, dp, n, true);          /// * pivot to reduce rounding error
     return A;
 }
+///
+/// batched PLU of N small [n,n] slices in one launch (per-slice pivoting)
+/// Note: A overwritten by L\U slices, P [N,n], D [N], I [N,n,n] optional
+///       returns -1 if A is not [N,n,n,1], else number of singular slices
+///
+__GPU__ int
+Tensor::batch_plu(Tensor &A, Tensor *P, Tensor *D, Tensor *I, bool pivot) {
+    U32 N = A.N(), m = A.H(), n = A.W();
+    MM_DB("  tensor#batch_plu N=%d [%d,%d]\n", N, m, n);
+    if (m != n || A.C() != 1 || n > T4_BATCH_MAX) {
+        ERROR("tensor#batch_plu [N,n,n,1] with n<=%d?\n", T4_BATCH_MAX);
+        return -1;
+    }
+    const int T  = n * n < T4_WARP_SQ ? ((n * n + 31) & ~31) : T4_WARP_SQ;
+    const int sm = n * n * sizeof(DU) + n * sizeof(int);  ///< slice + permutation
+    int *sg = new int(0);                    ///< per call, device heap seen by child kernels
+    k_bplu<<<N, T, sm>>>(
+        A.data, P ? P->data : NULL, D ? D->data : NULL, I ? I->data : NULL,
+        sg, n, pivot);
+    GPU_SYNC();
+    int rst = *sg;
+    delete sg;
+    if (rst) ERROR("tensor#batch_plu %d of %d slice(s) sigular!\n", rst, N);
+    return rst;
+}
 
 ///=======================================================================
 /// tensor arithmetics
@@ -573,6 +756,7 @@ Tensor::reset(void *mem, U64 sz, t4_obj tt, t4_layer fn) {
     memcpy(shape,  h, sizeof(h));
     memcpy(grad,   t, sizeof(t));
     memcpy(mtum,   t, sizeof(t));
+    qnt[0]  = qnt[1] = NULL;
     
     return *this;
 }
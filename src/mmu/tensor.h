@@ -83,6 +83,7 @@ struct Tensor : public T4Base {
     t4_layer grad_fn   = L_NONE;    ///< grandiant funtion type
     Tensor   *grad[4];              ///< gradient and jacobian tensors
     Tensor   *mtum[4];              ///< momentum and delta tensors
+    Tensor   *qnt[2];               ///< INT8 weight and per-channel scale tensors
     ///
     /// static ops
     /// Note:
@@ -95,10 +96,13 @@ struct Tensor : public T4Base {
     static __GPU__  Tensor &gemm(Tensor &A, Tensor &B, Tensor &O, DU alpha, DU beta);
     static __GPU__  Tensor &copy(Tensor &A, Tensor &O);
     static __GPU__  Tensor &transpose(Tensor &A, Tensor &T);
-    static __GPU__  Tensor &inverse(Tensor &A, Tensor &I);  /// GaussJordan (with Pivot)
+    static __GPU__  Tensor &inverse(Tensor &A, Tensor &I);  /// PLU + triangular solves (A overwritten)
     static __GPU__  Tensor &lu(Tensor &A);                  /// LU (no Pivot)
-    static __GPU__  Tensor &lu_inverse(Tensor &LU);         /// inverse a pre-processed LU (no Pivot)
+    static __GPU__  int    lu_inverse(Tensor &LU, Tensor &I); /// L^-1\U^-1 of a pre-processed LU (no Pivot)
+    static __GPU__  int    lu_solve(Tensor &LU, Tensor &P, Tensor &B, Tensor &X); /// solve LU X = P B, -1 if singular
     static __GPU__  Tensor &plu(Tensor &A, Tensor &P, int *ns);/// LU with permutation vector
+    static __GPU__  int    _lu(DU *a, DU *p, int n, bool pivot); /// blocked LU, returns row swaps
+    static __GPU__  int    batch_plu(Tensor &A, Tensor *P, Tensor *D=NULL, Tensor *I=NULL, bool pivot=true); /// N small PLU in one launch, -1 or #singular
     ///
     /// class contructors
     ///
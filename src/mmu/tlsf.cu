@@ -74,6 +74,10 @@ TLSF::malloc(U64 sz) {
 
     _LOCK;
     U32 index       = _find_free_index(bsz);
+    if (index >= FL_SLOTS) {                    // out of memory
+        _UNLOCK;
+        return NULL;
+    }
     free_block *blk = _set_used(index);         // take the indexed block off free list
 
     _split(blk, bsz);                           // allocate the block, free up the rest
@@ -135,6 +139,7 @@ TLSF::free(void *ptr) {
     const U32 addr  = TADDR(ptr);
     free_block *blk = (free_block *)BLK_HEAD(ptr);       // get block header
     MM_DB("  tlsf#free(%x) %x:%x {\n", addr, TADDR(blk), blk->bsz);
+    CLR_OBJ(blk);                                        // unpin
     _merge_next(blk);
     _set_free(blk);
 
@@ -233,7 +238,7 @@ TLSF::_split(free_block *blk, U64 bsz) {
 
     free_block *aft  = (free_block *)BLK_AFTER(blk);                  // next adjacent block
     if (aft) {
-        aft->psz = U8POFF(aft, free) | (aft->psz & FREE_FLAG);        // backward offset (positive)
+        aft->psz = U8POFF(aft, free) | (aft->psz & BLK_FLAGS);        // backward offset (positive)
         _merge_next(free);                                            // _combine if possible
     }
     _set_free(free);            // add to free_list and set (free, tail, next, prev) fields
@@ -257,7 +262,7 @@ TLSF::_pack(free_block *b0, free_block *b1) {
     MM_DB("    tlsf#pack(%x:%x + %x:%x) => ", TADDR(b0), b0->bsz, TADDR(b1), b1->bsz);
     // merge b0 and b1, retain b0.FREE_FLAG
     used_block *b2 = (used_block *)BLK_AFTER(b1);
-    b2->psz += b1->psz & ~FREE_FLAG;    // watch for the block->flag
+    b2->psz += b1->psz & ~BLK_FLAGS;    // watch for the block->flag
     b0->bsz += b1->bsz;                 // include the block header
 
     MM_DB("%x:%x\n", TADDR(b0), b0->bsz);
@@ -370,6 +375,106 @@ TLSF::_merge_prev(free_block *b1) {
     return b0;
 }
 //================================================================
+/*! pin a block, it holds an object whose address is its handle
+*/
+__BOTH__ void
+TLSF::pin(void *p) {
+    SET_OBJ((used_block*)BLK_HEAD(p));
+}
+
+//================================================================
+/*! list object blocks (pinned, their address is an object handle)
+
+  @param  lst    output pointers to object data
+  @param  max    capacity of lst
+  @retval number of objects (may exceed max)
+*/
+__GPU__ int
+TLSF::objects(void **lst, int max) {
+    int n = 0;
+    for (used_block *p = (used_block*)_heap; p && p->bsz; p = (used_block*)BLK_AFTER(p)) {
+        if (IS_FREE(p) || !IS_OBJ_BLK(p)) continue;
+        if (n < max) lst[n] = BLK_DATA(p);
+        n++;
+    }
+    return n;
+}
+
+//================================================================
+/*! sliding compaction, moves unpinned used blocks down into the
+  free block before them, so free space gathers at the high end.
+
+  @param  own    addresses of data pointers, sorted by pointer value
+  @param  n      number of owners
+  @retval number of blocks moved
+
+  Note: a block moves only if exactly one owner points at its start
+        and none into its middle, anything else stays pinned
+*/
+__GPU__ int
+TLSF::compact(void ***own, int n) {
+    _LOCK;
+    int i = 0, nmv = 0;                                   // owner cursor, blocks moved
+    free_block *f = (free_block*)_heap;
+    while (f && f->bsz) {
+        used_block *b = (used_block*)BLK_AFTER(f);
+        if (!IS_FREE(f) || !b || !b->bsz || IS_OBJ_BLK(b)) {
+            f = (free_block*)b;
+            continue;
+        }
+        U8 *d0 = (U8*)BLK_DATA(b), *d1 = U8PADD(b, b->bsz);
+        while (i < n && (U8*)*own[i] < d0) i++;           // skip owners of earlier blocks
+        int k = i;
+        while (k < n && (U8*)*own[k] < d1) k++;           // owners inside block b
+        if (k - i != 1 || *own[i] != d0) {                // pinned, skip over
+            i = k;
+            f = (free_block*)b;
+            continue;
+        }
+        U64 fsz = f->bsz, bsz = b->bsz;
+        U32 fps = f->psz & ~BLK_FLAGS;
+        used_block *nx = (used_block*)BLK_AFTER(b);       // block after b
+        _unmap(f);
+        U64 *dst = (U64*)f, *src = (U64*)b;               // ascending, overlap safe
+        for (U64 w = 0; w < bsz / sizeof(U64); w++) dst[w] = src[w];
+        used_block *b1 = (used_block*)f;                  // b moved down
+        b1->psz = fps;                                    // used, unpinned
+        free_block *f1 = (free_block*)U8PADD(b1, bsz);    // hole moved up
+        f1->bsz = fsz;
+        f1->psz = bsz;                                    // used until _set_free
+        nx->psz = fsz | (nx->psz & BLK_FLAGS);
+        *own[i] = BLK_DATA(b1);                           // fix the owner
+        MM_DB("    tlsf#compact %x:%lx => %x\n", TADDR(b), bsz, TADDR(b1));
+        _merge_next(f1);
+        _set_free(f1);
+        i   = k;
+        f   = f1;
+        nmv++;
+    }
+    _UNLOCK;
+    return nmv;
+}
+
+//================================================================
+/*! size of an allocated block, header included
+*/
+__BOTH__ U32
+TLSF::bsize(void *p) {
+    return ((used_block*)BLK_HEAD(p))->bsz;
+}
+
+//================================================================
+/*! largest free block, payload bytes
+*/
+__BOTH__ U64
+TLSF::largest() {
+    U64 mx = 0;
+    for (used_block *p = (used_block*)_heap; p && p->bsz; p = (used_block*)BLK_AFTER(p)) {
+        if (IS_FREE(p) && p->bsz > mx) mx = p->bsz;
+    }
+    return mx ? mx - sizeof(used_block) : 0;
+}
+//================================================================
 // MMU JTAG sanity check - memory pool walker
 //
 //================================================================
@@ -379,7 +484,7 @@ TLSF::_mmu_ok()    {                         // mmu sanity check
     used_block *p1 = (used_block*)BLK_AFTER(p0);
     U32 tot = sizeof(free_block);
     while (p1) {
-        if (p0->bsz != (p1->psz&~FREE_FLAG)) {       // ERROR!
+        if (p0->bsz != (p1->psz&~BLK_FLAGS)) {       // ERROR!
             return 0;                                // memory integrity broken!
         }
         tot += p0->bsz;
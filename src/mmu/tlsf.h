@@ -20,16 +20,21 @@ typedef struct free_block {          //< 16-bytes (i.e. mininum allocation per b
 } free_block;
 
 #define FREE_FLAG       0x1
+#define OBJ_FLAG        0x2                          /**> block holds an object (pinned) */
+#define BLK_FLAGS       (FREE_FLAG | OBJ_FLAG)
 #define IS_FREE(b)      ((b)->psz & FREE_FLAG)
 #define IS_USED(b)      (!IS_FREE(b))
 #define SET_FREE(b)     ((b)->psz |=  FREE_FLAG)
 #define SET_USED(b)     ((b)->psz &= ~FREE_FLAG)
+#define IS_OBJ_BLK(b)   ((b)->psz & OBJ_FLAG)
+#define SET_OBJ(b)      ((b)->psz |=  OBJ_FLAG)
+#define CLR_OBJ(b)      ((b)->psz &= ~OBJ_FLAG)
 
 #define NEXT_FREE(b)    ((free_block*)((b)->next ? ((b)->next<0 ? U8PSUB((b), -(b)->next) : U8PADD((b), (b)->next)) : NULL))
 #define PREV_FREE(b)    ((free_block*)((b)->prev ? ((b)->prev<0 ? U8PSUB((b), -(b)->prev) : U8PADD((b), (b)->prev)) : NULL))
 
 #define BLK_AFTER(b)    (((b)->bsz           ) ? U8PADD(b, (b)->bsz             ) : NULL)        /**> following adjacent memory block  */
-#define BLK_BEFORE(b)   (((b)->psz&~FREE_FLAG) ? U8PSUB(b, ((b)->psz&~FREE_FLAG)) : NULL)        /**> prior adjacent memory block      */
+#define BLK_BEFORE(b)   (((b)->psz&~BLK_FLAGS) ? U8PSUB(b, ((b)->psz&~BLK_FLAGS)) : NULL)        /**> prior adjacent memory block      */
 #define BLK_DATA(b)     (U8PADD(b, sizeof(used_block)))                                          /**> pointer to raw data space        */
 #define BLK_HEAD(p)     (U8PSUB(p, sizeof(used_block)))                                          /**> block header from raw pointer    */
 
@@ -68,6 +73,14 @@ public:
     __GPU__  void*       realloc(void *p0, U64 sz);        ///> resize allocated memory
     __GPU__  void        free(void *ptr);                  ///> free memory block back to TLSF
     //
+    // compaction, at a safe point only (no kernel touching the heap)
+    //
+    __BOTH__ void        pin(void *p);                     ///> mark an object block
+    __GPU__  int         objects(void **lst, int max);     ///> list pinned object blocks
+    __GPU__  int         compact(void ***own, int n);      ///> slide data blocks down, fix owners
+    __BOTH__ U64         largest();                        ///> largest free block
+    __BOTH__ U32         bsize(void *p);                   ///> block size, header included
+    //
     // sanity check, JTAG
     //
     __BOTH__ void        status() { _show_stat(); _dump_freelist(); }
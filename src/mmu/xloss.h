@@ -0,0 +1,84 @@
+/** -*- c++ -*-
+ * @file
+ * @brief fused loss, dLoss and hit count straight from labels
+ *
+ * Output logits [N,HWC] are compared against integer labels, the one-hot
+ * target is implied (t_i = i==label), so nothing is materialized or
+ * allocated per step. Per-sample math is shared by device and host.
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#ifndef __MMU_XLOSS_H
+#define __MMU_XLOSS_H
+#include "tensor.h"
+
+#if defined(__CUDA_ARCH__)
+#define XL_LN(d)    __logf(d)
+#else  // host
+#define XL_LN(d)    logf(d)
+#endif // defined(__CUDA_ARCH__)
+///
+///@name fused kernels (in nn/loss.cu)
+///@{
+__KERN__ void k_xloss(t4_loss op, DU *O, U32 *L, int HWC, int N, DU *sum, int *hit);
+__KERN__ void k_xdloss(bool sub, DU *O, U32 *L, int HWC, U64 numel);
+///@}
+///
+/// label index, out of range labels go to class 0 (as onehot did)
+///
+__BOTH__ __INLINE__ int
+xl_label(const U32 *L, int n, int sz) {
+    U32 l = L[n];
+    return l < (U32)sz ? (int)l : 0;
+}
+///
+/// loss of one sample o[sz] against label l, and top-1 hit
+///
+__BOTH__ __INLINE__ DU
+xloss1(t4_loss op, const DU *o, int sz, int l, int &hit) {
+    DU  v = DU0, mx = o[0];
+    int m = 0;
+    for (int i = 0; i < sz; i++) {
+        DU y = o[i], t = i == l ? DU1 : DU0;
+        if (y > mx) { mx = y; m = i; }               /// * argmax
+        switch (op) {
+        case LOSS_MSE: v += (DU)0.5 * (y - t) * (y - t);  break;
+        case LOSS_BCE:
+            v -= t * XL_LN(y + DU_EPS) + (DU1 - t) * XL_LN(DU1 - y + DU_EPS);
+            break;
+        default: break;
+        }
+    }
+    if (op == LOSS_CE)  v = -XL_LN(o[l]);            /// * softmax input
+    if (op == LOSS_NLL) v = -o[l];                   /// * log-softmax input
+    hit = m == l;
+    return v;
+}
+///
+/// dLoss of one element k, sub: out - onehot (sigmoid/softmax/logsoftmax),
+/// otherwise onehot pass thru
+///
+__BOTH__ __INLINE__ DU
+xdloss1(bool sub, const DU *O, const U32 *L, int sz, U64 k) {
+    DU t = (int)(k % sz) == xl_label(L, (int)(k / sz), sz) ? DU1 : DU0;
+    return sub ? O[k] - t : t;
+}
+///
+/// host reference, sum of sample losses (not averaged) and hit count
+///
+__HOST__ __INLINE__ DU
+xloss_host(t4_loss op, const DU *O, const U32 *L, int sz, int N, int &hit) {
+    DU  sum = DU0;
+    hit = 0;
+    for (int n = 0; n < N; n++) {
+        int h;
+        sum += xloss1(op, &O[(U64)n * sz], sz, xl_label(L, n, sz), h);
+        hit += h;
+    }
+    return sum;
+}
+__HOST__ __INLINE__ void
+xdloss_host(bool sub, DU *O, const U32 *L, int sz, int N) {
+    for (U64 k = 0; k < (U64)N * sz; k++) O[k] = xdloss1(sub, O, L, sz, k);
+}
+#endif // __MMU_XLOSS_H
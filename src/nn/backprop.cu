@@ -5,6 +5,7 @@
  * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
  */
 #include "model.h"
+#include "xloss.h"
 #if (T4_ENABLE_OBJ && T4_ENABLE_NN)
 ///
 /// convolution filter derivatives
@@ -141,6 +142,18 @@ __KERN__ void k_dpool(
     }
 }
 
+///
+/// max/min pool backprop from argmax kept by fused forward (input never written)
+///
+__KERN__ void k_dpool_x(
+    DU *I, DU *O, int *X,                   ///< input (zeroed), output, argmax index
+    int numel                               ///< number of output elements
+    ) {
+    const int k = threadIdx.x + blockIdx.x * blockDim.x;
+
+    if (k < numel) I[X[k]] = O[k];          /// * route dY to arg cell
+}
+
 __KERN__ void k_dactivate(
     DU *I, DU *F, DU *O,                    ///< input, filter, output
     int numel                               ///< tensor element count
@@ -178,6 +191,25 @@ __KERN__ void k_dbatchnorm_2(
     if (i < HW) I[k] -= X[k] * sum[c];
 }
 ///
+/// data-parallel reduction, replica dw/db folded into the model's and zeroed
+///
+typedef struct { DU *d[T4_VM_COUNT]; } t4_dpv;     ///< replica buffers (by value)
+__KERN__ void k_dpsum(
+    DU *D, t4_dpv R, int nr,               ///< model dw/db, replica dw/db, replica count
+    int numel                              ///< tensor element count
+    ) {
+    const int k = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+
+    if (k < numel) {
+        DU v = D[k];
+        for (int r = 0; r < nr; r++) {
+            v += R.d[r][k];
+            R.d[r][k] = DU0;                               /// * ready for next batch
+        }
+        D[k] = v;
+    }
+}
+///
 /// backprop: Neural Network back propegation
 /// Note: cascade execution layer by layer backward
 ///
@@ -186,6 +218,7 @@ Model::broadcast(Tensor &tgt) {
     Tensor &out = (*this)[-1];                   ///< model output
     int    N    = out.N(), HWC = out.HWC();      ///< sample size
     if (!_hot) _hot = &_t4(N, HWC);              ///< allocate onehot vector if needed
+    _lbl = NULL;                                 /// * explicit target, not labels
     for (int n = 0; n < N; n++) {                /// * loop through batch, TODO: Kernel
         DU  v = tgt.data[n];                     ///< target vector
         DU *h = _hot->slice(n);                  ///< take a sample
@@ -196,14 +229,33 @@ Model::broadcast(Tensor &tgt) {
 
 __GPU__ Model&
 Model::backprop() {
-    if (_hot) return backprop(*_hot);            /// * use default one-hot vector
-
-    ERROR("Model#backprop missing onehot vector?\n");
-    return *this;
+    if (!_lbl) {
+        if (_hot) return backprop(*_hot);        /// * use broadcast target vector
+        ERROR("Model#backprop missing onehot vector?\n");
+        return *this;
+    }
+    if (_infer) {
+        ERROR("Model#backprop in inference mode, 0 nn.infer first\n");
+        return *this;
+    }
+    _bloss();                                    /// * dLoss straight from labels
+    return _bprop();
 }
 
 __GPU__ Model&
 Model::backprop(Tensor &tgt) {
+    if (_infer) {
+        ERROR("Model#backprop in inference mode, 0 nn.infer first\n");
+        return *this;
+    }
+    if (_bloss(tgt)) return *this;               /// * pre-calculate dLoss
+    return _bprop();
+}
+///
+/// backprop layers, dLoss already in model output
+///
+__GPU__ Model&
+Model::_bprop() {
     auto trace = [](DU t, int i, Tensor &in, Tensor &out) {
         printf("\n%6.2f:%2d> %s [%d,%d,%d,%d]\tp=%-2d <= out'Σ/n=%6.2f [%d,%d,%d,%d] ",
             t, i, d_nname(in.grad_fn),
@@ -211,12 +263,14 @@ Model::backprop(Tensor &tgt) {
             out.sum() / out.N() / out.C(),
             out.N(), out.H(), out.W(), out.C());
     };
-    if (_bloss(tgt)) return *this;               /// * pre-calculate dLoss
+    if (_ndp > 1 && !_mmu->trace() && !_infer && !_plan) return _dprop();
+    _bind(1);                                    /// * planned arena slots for backprop
     
     TRACE("\nModel#backprop starts");
     DU  t0 = _mmu->ms(), t1 = t0, tt;            ///< performance measurement
     for (U16 i = numel - 2, j = 0; i > 0; i--, j++) {
         Tensor &in = (*this)[i], &out = (*this)[i + 1];
+        _recompute(i);                           /// * checkpointed X
         if (_mmu->trace()) {
             trace((tt=_mmu->ms()) - t1, i, in, out); t1 = tt;
             _bstep(in, out);
@@ -227,6 +281,62 @@ Model::backprop(Tensor &tgt) {
     TRACE("\nModel::backprop %5.2f ms\n", _mmu->ms() - t0);
     return *this;
 }
+///
+/// data-parallel backprop, replica r walks all layers of its shard on
+/// stream r, accumulating into its own dw/db (the model's for r=0),
+/// dLoss of the whole batch is already in the output
+///
+__GPU__ Model&
+Model::_dprop() {
+    const int nb = batch_size() / _ndp;          ///< samples per replica
+    const int m  = numel * 2;                    ///< _dpg entries per replica
+    __align__(16) U8 vb[3][sizeof(Tensor)];      ///< in, out, mask views
+
+    for (int r = 0; r < _ndp; r++) {
+        _st = _mst[r];
+        for (U16 i = numel - 2; i > 0; i--) {
+            Tensor &in = (*this)[i];
+            Tensor &vi = _mview(in, vb[0], r * nb, nb);
+            Tensor &vo = _mview((*this)[i + 1], vb[1], r * nb, nb);
+            if (in.grad_fn == L_CONV || in.grad_fn == L_LINEAR) {
+                if (r) {
+                    vi.grad[2] = _dpg[(r - 1) * m + i * 2];
+                    vi.grad[3] = _dpg[(r - 1) * m + i * 2 + 1];
+                }
+            }
+            else if (in.grad[0]) {               /// * activation mask
+                vi.grad[0] = &_mview(*in.grad[0], vb[2], r * nb, nb);
+            }
+            _bstep(vi, vo);
+        }
+    }
+    _st = 0;
+    GPU_SYNC();                                  /// * join replica streams
+    _dpreduce();
+    return *this;
+}
+///
+/// fold replica dw/db into the model's, one pass over each tensor
+/// Note: weights are shared by replicas on one device, so the reduce
+///       target is the model only, no broadcast needed
+///
+__GPU__ void
+Model::_dpreduce() {
+    const int m = numel * 2;
+    const dim3 blk(T4_WARP_SQ, 1, 1);
+    for (U16 i = 1; i < numel - 1; i++) {
+        Tensor &in = (*this)[i];
+        if (in.grad_fn != L_CONV && in.grad_fn != L_LINEAR) continue;
+        for (int j = 0; j < 2; j++) {
+            Tensor &d = *in.grad[2 + j];
+            t4_dpv  R;
+            for (int r = 1; r < _ndp; r++) R.d[r - 1] = _dpg[(r - 1) * m + i * 2 + j]->data;
+            const dim3 grd((d.numel + blk.x - 1) / blk.x, 1, 1);
+            k_dpsum<<<grd, blk>>>(d.data, R, _ndp - 1, d.numel);
+        }
+    }
+    GPU_SYNC();
+}
 /// ========================================================================
 /// private methods
 ///
@@ -252,6 +362,21 @@ Model::_bloss(Tensor &tgt) {                     ///> pre-calc dLoss
     return 0;
 }
 
+__GPU__ int
+Model::_bloss() {                                ///> dLoss from labels, no one-hot
+    Tensor    &out = (*this)[-1];                ///< output layer, used as dLoss
+    t4_layer  fn   = (*this)[-2].grad_fn;        ///< final activation layer
+    bool      sub  = fn == L_SIGMOID || fn == L_SOFTMAX || fn == L_LOGSMAX;
+    dim3 blk(T4_WARP_SQ, 1, 1);
+    dim3 grd((out.numel + blk.x - 1) / blk.x, 1, 1);
+
+    k_xdloss<<<grd, blk>>>(sub, out.data, _lbl, out.HWC(), out.numel);
+    GPU_SYNC();
+    if (_mmu->trace()) out.show();               /// * display loss if trace on
+
+    return 0;
+}
+
 __GPU__ void
 Model::_bstep(Tensor &in, Tensor &out) {
     ///
@@ -261,7 +386,7 @@ Model::_bstep(Tensor &in, Tensor &out) {
     switch(fn) {
     case L_CONV:    _bconv(in, out);         break; /// * convolution
     case L_LINEAR:  _blinear(in, out);       break; /// * out = w @ in + b
-    case L_FLATTEN: in = out;                break; /// * pass dY to X
+    case L_FLATTEN: _fcopy(out, in);         break; /// * pass dY to X
     case L_RELU:
     case L_TANH:                                    /// * in = (1 - t^2)*out
     case L_SIGMOID:                                 /// * in = s*(1 - s)*out
@@ -270,7 +395,7 @@ Model::_bstep(Tensor &in, Tensor &out) {
     case L_ELU:
     case L_DROPOUT: _bactivate(in, out);     break; /// * in = msk * out
     case L_SOFTMAX:                                 /// * softmax + CrossEntropy (pass thru)
-    case L_LOGSMAX: in = out;                break; /// * log-softmax + NLL (pass thru)
+    case L_LOGSMAX: _fcopy(out, in);         break; /// * log-softmax + NLL (pass thru)
     case L_MAXPOOL:
     case L_AVGPOOL:
     case L_MINPOOL: _bpool(in, out, fn);     break;
@@ -303,17 +428,17 @@ Model::_bconv(Tensor &in, Tensor &out) {
         DU *d1 = in.slice(n), *d0 = out.slice(n);
         const int ks = w.H();                       ///< kernel size
         switch (ks) {
-        case 1: k_dconv2d<TILE1,1><<<g1,blk>>>(
+        case 1: k_dconv2d<TILE1,1><<<g1,blk,0,_st>>>(
                     d1, w.data, dw.data, db.data, d0, H, W, C0, train); break;
-        case 3: k_dconv2d<TILE3,3><<<g3,blk>>>(
+        case 3: k_dconv2d<TILE3,3><<<g3,blk,0,_st>>>(
                     d1, w.data, dw.data, db.data, d0, H, W, C0, train); break;
-        case 5: k_dconv2d<TILE5,5><<<g5,blk>>>(
+        case 5: k_dconv2d<TILE5,5><<<g5,blk,0,_st>>>(
                     d1, w.data, dw.data, db.data, d0, H, W, C0, train); break;
         default:
             ERROR("model_back#conv kernel_size %d not supported\n", ks);
             return -1;
         }
-        GPU_SYNC();
+        ST_SYNC();
     }
     if (_mmu->trace() > 1) _dump_dbdf(db, dw);
     return 0;
@@ -364,16 +489,17 @@ Model::_blinear(Tensor &in, Tensor &out) {
         dim3 blk(T4_WARP_SZ, T4_WARP_SZ, 1);        /// * (16,16,1)
         dim3 grd(NGRID(C1, C0, N, blk));            /// * (1,1,N) N samples in a grid
         if (train) {
-            k_dlinear_dwdb<<<grd, blk>>>(           /// * update dB, dW
+            k_dlinear_dwdb<<<grd, blk, 0, _st>>>(   /// * update dB, dW
                 in.data, out.data, dw.data, db.data,
                 C1, C0, E1, E0);
         }
         /// barrier for X (because we did N samples in one grid)
-        in.map(FILL, DU0);                          /// * zero out dX
-        k_dlinear_dx<<<grd, blk>>>(                 /// * update dX
+        if (_st) cudaMemsetAsync(in.data, 0, in.numel * sizeof(DU), _st);
+        else     in.map(FILL, DU0);                 /// * zero out dX
+        k_dlinear_dx<<<grd, blk, 0, _st>>>(         /// * update dX
             in.data, out.data, w.data,
             C1, C0, E1, E0);
-        GPU_SYNC();
+        ST_SYNC();
     }
     if (train && _mmu->trace() > 1) {
          _dump_db(db);
@@ -384,6 +510,13 @@ Model::_blinear(Tensor &in, Tensor &out) {
 
 __GPU__ int
 Model::_bactivate(Tensor &in, Tensor &out) {
+    if (!in.grad[0]) return _bactivate_x(in, out); /// * recompute checkpoint
+    if (_st) {                                     /// * on replica stream
+        dim3 blk(T4_WARP_SQ, 1, 1);
+        dim3 grd((in.numel + blk.x - 1) / blk.x, 1, 1);
+        k_dactivate<<<grd, blk, 0, _st>>>(in.data, in.grad[0]->data, out.data, in.numel);
+        return 0;
+    }
     Tensor::ten_op(MUL, out, *in.grad[0], in);     /// * in = msk * out
     return 0;
 }
@@ -395,15 +528,22 @@ Model::_bpool(Tensor &in, Tensor &out, t4_layer fn) {
     dim3 blk(T4_WARP_SQ, 1, 1);
     dim3 grd((H * W + blk.x - 1) / blk.x, out.C(), out.N());
 
+    if (fn != L_AVGPOOL && in.grad[0]) {          /// * fused, argmax kept
+        dim3 g1((out.numel + blk.x - 1) / blk.x, 1, 1);
+        in.map(FILL, DU0);
+        k_dpool_x<<<g1,blk>>>(in.data, out.data, (int*)in.grad[0]->data, out.numel);
+        GPU_SYNC();
+        return 0;
+    }
     const int ks = in.parm;                       ///< kernel size
     switch(ks) {
-    case 2: k_dpool<2><<<grd,blk>>>(fn, in.data, out.data, H, W); break;
-    case 3: k_dpool<3><<<grd,blk>>>(fn, in.data, out.data, H, W); break;
+    case 2: k_dpool<2><<<grd,blk,0,_st>>>(fn, in.data, out.data, H, W); break;
+    case 3: k_dpool<3><<<grd,blk,0,_st>>>(fn, in.data, out.data, H, W); break;
     default:
         ERROR("model#pooling kernel_size=%d not supported\n", ks);
         return -1;
     }
-    GPU_SYNC();
+    ST_SYNC();
 
     return 0;
 }
@@ -422,13 +562,13 @@ Model::_bupsample(Tensor &in, Tensor &out, t4_layer fn) {
     dim3 grd((H * W + blk.x - 1) / blk.x, in.C(), in.N());
 
     switch(ks) {                                        /// by kernel size
-    case 2: k_pool<2><<<grd,blk>>>(fn, out.data, in.data, H, W); break;
-    case 3: k_pool<3><<<grd,blk>>>(fn, out.data, in.data, H, W); break;
+    case 2: k_pool<2><<<grd,blk,0,_st>>>(fn, out.data, in.data, H, W); break;
+    case 3: k_pool<3><<<grd,blk,0,_st>>>(fn, out.data, in.data, H, W); break;
     default:
         ERROR("model#upsample size=%d not supported\n", ks);
         return -1;
     }
-    GPU_SYNC();
+    ST_SYNC();
 
     return 0;
 }
@@ -6,6 +6,7 @@
  */
 #include "model.h"
 #if (T4_ENABLE_OBJ && T4_ENABLE_NN)
+#include "dataset.h"
 
 ///
 /// convolution filter
@@ -121,41 +122,110 @@ __KERN__ void k_pool(
     }
 }
 
-#define SELU_L  1.0507                     /** Selu lambda */
-#define SELU_LA 1.7581                     /** Selu alpha  */
+///
+/// activation value of x, derivative returned in f
+///
+__GPU__ __INLINE__ DU
+_activate(t4_layer op, DU x, DU alpha, DU &f) {
+    f = DU0;
+    switch (op) {
+    case L_RELU:    return x > DU0 ? (f=DU1, x) : DU0;     /// * 1|0
+    case L_TANH:                                           /// * scaled to [0,1)
+        x = TANH(x);
+        f = DU1 - x*x;                                     /// * (1 - tanh^2)
+        return 0.5 * (DU1 + x);
+    case L_SIGMOID:
+        x = SIGMOID(x);
+        f = x * (DU1 - x);                                 /// * sig*(1 - sig)
+        return x;
+    case L_SELU:    return x > DU0                         /// * selu
+        ? (f = SELU_L, x)
+        : (f = SELU_LA * EXP(x)) - SELU_LA;
+    case L_LEAKYRL: return x > DU0
+        ? (f = DU1, x)
+        : (f = alpha) * x;
+    case L_ELU:     return x > DU0
+        ? (f = DU1, x)
+        : (f = alpha * EXP(x)) - alpha;
+    }
+    return x;
+}
 
 __KERN__ void k_activate(
-    t4_layer op, DU *I, DU *F, DU *O,      ///< func, input, filter, output tensors
+    t4_layer op, DU *I, DU *F, DU *O,      ///< func, input, filter (NULL in inference), output tensors
     DU alpha, int numel                    ///< number of tensor elements
     ) {
     const int k = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
 
     if (k < numel) {
         DU ik = I[k];                                      ///< use register
-        switch (op) {
-        case L_RELU:
-            O[k] = ik > DU0
-                ? (F[k]=DU1, ik) : (F[k]=DU0);      break; /// * 1|0
-        case L_TANH:
-            O[k] = 0.5 * (DU1 + (ik=TANH(ik)));            /// * scaled to [0,1)
-            F[k] = DU1 - ik*ik;                     break; /// * (1 - tanh^2)
-        case L_SIGMOID:
-            O[k] = ik = SIGMOID(ik);
-            F[k] = ik * (DU1 - ik);                 break; /// * sig*(1 - sig)
-        case L_SELU: O[k] = ik > DU0                       /// * selu
-            ? (F[k] = SELU_L, ik)
-            : (F[k] = SELU_LA * EXP(ik)) - SELU_LA; break;
-        case L_LEAKYRL: O[k] = ik > DU0
-            ? (F[k] = DU1, ik)
-            : (F[k] = alpha) * ik;                  break;
-        case L_ELU:     O[k] = ik > DU0
-            ? (F[k] = DU1, ik)
-            : (F[k] = alpha * EXP(ik)) - alpha;     break;
-        case L_DROPOUT:
-            O[k] = F[k] > alpha
-            ? (F[k]=DU1, ik) : (F[k]=DU0);          break; /// * 1|0
+        DU fk = DU0;                                       ///< derivative
+        O[k] = op == L_DROPOUT
+            ? (F[k] > alpha ? (fk=DU1, ik) : DU0)          /// * 1|0
+            : _activate(op, ik, alpha, fk);
+        if (F) F[k] = fk;                                  /// * skipped in inference
+    }
+}
+///
+/// fused conv2d + bias + activation + pooling, one thread per pooled cell
+///   a1=0: conv => pool => activation, a1=1: conv => activation => pool
+///   only the pooled output, activation mask and pool argmax are written,
+///   the pre-pool conv output never goes to memory
+///
+template<int KS, int PS>                   ///> conv kernel size, pool size
+__KERN__ void k_conv_pool(
+    t4_layer pf, t4_layer af, bool a1,     ///< pool func, activation func, activate first
+    DU *I, DU *F, DU *B, DU *O,            ///< input, filter [C1,KS,KS,C0], bias, pooled output
+    DU *M, int *X,                         ///< activation mask, pool argmax (NULL skip)
+    DU alpha, int H, int W, int C1         ///< activation alpha, conv HW (==input HW), input channels
+    ) {
+    const int W0 = W / PS, HW0 = (H / PS) * W0;           ///< pooled dimensions
+    const int k0 = threadIdx.x + blockIdx.x * blockDim.x; ///< pooled cell index
+    const int c0 = blockIdx.y, C0 = gridDim.y;            ///< output channel
+    const int n  = blockIdx.z;                            ///< batch index
+    const bool avg = (pf == L_AVGPOOL);
+
+    if (k0 >= HW0) return;
+
+    const int i0 = (k0 / W0) * PS, j0 = (k0 % W0) * PS;  ///< top-left conv cell
+    const DU  *ix = &I[n * H * W * C1];                  ///< input slice
+    DU  v  = DU0, f;                                     ///< pooled value, derivative
+    int zx = 0;                                          ///< argmax conv cell
+    #pragma unroll
+    for (int p = 0; p < PS * PS; p++) {                  /// * each cell of pool window
+        const int i = i0 + p / PS, j = j0 + p % PS;      ///< conv output coordinates
+        DU c = B[c0];                                    /// * Y = sum(W * X) + B
+        for (int y = 0; y < KS; y++) {
+            const int i1 = i + y - INT(KS / 2);
+            if (i1 < 0 || i1 >= H) continue;             /// * zero padding
+            for (int x = 0; x < KS; x++) {
+                const int j1 = j + x - INT(KS / 2);
+                if (j1 < 0 || j1 >= W) continue;
+                const DU *xp = &ix[(j1 + i1 * W) * C1];
+                const DU *fp = &F[c0 + (x + y * KS) * C0];
+                for (int c1 = 0; c1 < C1; c1++) {
+                    c += fp[c1 * KS * KS * C0] * xp[c1];
+                }
+            }
+        }
+        const int zc = c0 + (j + i * W + n * H * W) * C0;   ///< conv output index
+        if (a1) {
+            c = _activate(af, c, alpha, f);
+            if (M) M[zc] = f;
         }
+        if (avg) v += c;
+        else if (p == 0 ||
+                 (pf == L_MAXPOOL && c > v) ||
+                 (pf == L_MINPOOL && c < v)) { v = c; zx = zc; }
     }
+    const int z0 = c0 + (k0 + n * HW0) * C0;             ///< pooled output index
+    if (avg) v /= PS * PS;
+    if (!a1) {
+        v = _activate(af, v, alpha, f);
+        if (M) M[z0] = f;
+    }
+    O[z0] = v;
+    if (X) X[z0] = zx;                                   /// * for backprop
 }
 
 __KERN__ void k_batchnorm(
@@ -190,9 +260,10 @@ Model::forward(Tensor &input) {
         return *this;
     }
     n1 = input;               /// * copy dataset batch into the first layer [0,1)
+    _bind(0);                 /// * planned arena slots for forward
     ///
-    /// cascade execution layer by layer forward
-    /// TODO: model execution becomes a superscalar pipeline
+    /// cascade execution layer by layer forward,
+    /// or micro-batches flowing through layers on streams (see nn.pipe)
     ///
     auto trace = [](DU t, int i, Tensor &in, Tensor &out) {
         printf("\n%6.2f:%2d> %s Σ/n=%6.2f [%d,%d,%d,%d]\tp=%6.3f => out[%d,%d,%d,%d]",
@@ -202,24 +273,29 @@ Model::forward(Tensor &input) {
     };
     TRACE1("\nModel::forward starts");
     DU t0 = _mmu->ms(), t1 = t0, tt;             ///< performance measurement
-    for (U16 i = 1; i < numel - 1; i++) {
-        Tensor &in = (*this)[i], &out = (*this)[i + 1];
+    if (_mb > 1 && !tlvl && !_infer && !_plan) _fpipe();
+    else for (U16 i = 1; i < numel - 1; i++) {
+        const int nx = (*this)[i].fuse ? 3 : 1;  ///< layers consumed
+        Tensor &in = (*this)[i], &out = (*this)[i + nx];
         if (tlvl) {
             trace((tt=_mmu->ms()) - t1, i, in, out);
             t1 = tt;
         }
-        _fstep(in, out);
+        if (nx > 1) _ffuse(i);                   /// * fused conv block
+        else        _fstep(in, out);
         if (tlvl) out.show();
+        i += nx - 1;
     }
     ///
-    /// collect onehot vector and hit count
+    /// collect labels and hit count
     ///
     if (input.is_dataset()) {
-        if (_hot) _mmu->drop(T4Base::obj2du(*_hot));
-        _hot = &onehot((Dataset&)input);         /// * create/cache onehot vector
+        _lbl = ((Dataset&)input).label;          /// * labels, no one-hot vector
         _hit = hit(true);                        /// * recalc/cache hit count
     }
-    TRACE1("\nModel::forward %5.2f ms\n", _mmu->ms() - t0);
+    tt = _mmu->ms() - t0;
+    TRACE1("\nModel::forward %5.2f ms, %d samples/s\n",
+           tt, INT(1000.0 * n1.N() / (tt + DU_EPS)));
 
     return *this;
 }
@@ -235,7 +311,7 @@ Model::_fstep(Tensor &in, Tensor &out) {
     switch(fn) {
     case L_CONV:    _fconv(in, out);         break; ///< convolution
     case L_LINEAR:  _flinear(in, out);       break; ///< out = W @ in + B
-    case L_FLATTEN: out = in;                break; ///< straight copy
+    case L_FLATTEN: _fcopy(in, out);         break; ///< straight copy
     case L_RELU:
     case L_TANH:
     case L_SIGMOID:
@@ -243,7 +319,8 @@ Model::_fstep(Tensor &in, Tensor &out) {
     case L_LEAKYRL:
     case L_ELU:     _factivate(in, out, fn); break;
     case L_DROPOUT:                                 ///< dropout mask
-        _mmu->random(*in.grad[0], UNIFORM);         /// * randomize w, shift pct
+        if (!in.grad[0]) { _fcopy(in, out);  break; } /// * identity in inference
+        if (!_st) _mmu->random(*in.grad[0], UNIFORM); /// * randomize w, shift pct (_fpipe did it)
         _factivate(in, out, fn);             break;
     case L_SOFTMAX: _fsoftmax(in, out);      break; /// * feed to CrossEtropy
     case L_LOGSMAX: _flogsoftmax(in, out);   break; /// * feed to NLL
@@ -256,6 +333,86 @@ Model::_fstep(Tensor &in, Tensor &out) {
     }
 }
 
+///
+///> micro-batch pipeline
+///
+__GPU__ bool
+Model::_fpipe_ok(Tensor &in) {
+    if (in.fuse) return false;                      /// * pool argmax spans the batch
+    switch (in.grad_fn) {
+    case L_CONV:
+    case L_FLATTEN:
+    case L_RELU:
+    case L_TANH:
+    case L_SIGMOID:
+    case L_SELU:
+    case L_LEAKYRL:
+    case L_ELU:
+    case L_DROPOUT:
+    case L_AVGPOOL:
+    case L_MAXPOOL:
+    case L_MINPOOL:
+    case L_USAMPLE: return true;
+    case L_LINEAR:  return in.grad[0]->numel >= T4_WARP_SQ; /// * kernel path only
+    default:        return false;                   /// * softmax, batchnorm need whole batch
+    }
+}
+///
+/// a run of streamable layers is issued micro-batch by micro-batch,
+/// each on its own stream, so micro-batch m+1 starts layer 1 while
+/// micro-batch m is still in layer 2; streams join before any layer
+/// that needs the whole batch (softmax, batchnorm, fused block)
+///
+__GPU__ void
+Model::_fpipe() {
+    const int N  = batch_size();
+    const int nb = (N + _mb - 1) / _mb;             ///< samples per micro-batch
+    __align__(16) U8 vb[3][sizeof(Tensor)];         ///< in, out, mask views
+
+    for (U16 i = 1; i < numel - 1; ) {
+        U16 j = i;                                  ///< end of streamable run
+        for (; j < numel - 1 && _fpipe_ok((*this)[j]); j++) {
+            Tensor &in = (*this)[j];
+            if (in.grad_fn == L_DROPOUT && in.grad[0]) {
+                _mmu->random(*in.grad[0], UNIFORM); /// * masks drawn for whole batch
+            }
+        }
+        if (j == i) {                               /// * barrier layer
+            const int nx = (*this)[i].fuse ? 3 : 1;
+            if (nx > 1) _ffuse(i);
+            else        _fstep((*this)[i], (*this)[i + 1]);
+            i += nx;
+            continue;
+        }
+        GPU_SYNC();                                 /// * masks and prior layers ready
+        for (int m = 0; m < _mb && m * nb < N; m++) {
+            const int n0 = m * nb, n = MIN(nb, N - n0);
+            _st = _mst[m];
+            for (U16 k = i; k < j; k++) {
+                Tensor &in = (*this)[k];
+                Tensor &vi = _mview(in, vb[0], n0, n);
+                Tensor &vo = _mview((*this)[k + 1], vb[1], n0, n);
+                if (in.grad_fn != L_CONV && in.grad_fn != L_LINEAR && in.grad[0]) {
+                    vi.grad[0] = &_mview(*in.grad[0], vb[2], n0, n); /// * activation mask
+                }
+                _fstep(vi, vo);
+            }
+        }
+        _st = 0;
+        GPU_SYNC();                                 /// * join micro-batch streams
+        i = j;
+    }
+}
+///
+/// flatten and inference dropout, ordered on the launch stream
+///
+__GPU__ void
+Model::_fcopy(Tensor &in, Tensor &out) {
+    if (!_st) { out = in; return; }
+    cudaMemcpyAsync(out.data, in.data, in.numel * sizeof(DU),
+                    cudaMemcpyDeviceToDevice, _st);
+}
+
 #define TILE1    (T4_WARP_SZ)              /** 16, 1x1 conv */
 #define TILE3    (T4_WARP_SZ - 3 + 1)      /** 14, 3x3 conv */
 #define TILE5    (T4_WARP_SZ - 5 + 1)      /** 12, 5x5 conv */
@@ -280,18 +437,66 @@ Model::_fconv(Tensor &in, Tensor &out) {
         DU *f  = tf.data, *b = tb.data;
         int ks = tf.H();
         switch(ks) {                       /// * TODO: handles rectangular filters
-        case 1: k_conv2d<TILE1,1><<<g1,blk>>>(d1, f, b, d0, H, W, C1); break;
-        case 3: k_conv2d<TILE3,3><<<g3,blk>>>(d1, f, b, d0, H, W, C1); break;
-        case 5: k_conv2d<TILE5,5><<<g5,blk>>>(d1, f, b, d0, H, W, C1); break;
+        case 1: k_conv2d<TILE1,1><<<g1,blk,0,_st>>>(d1, f, b, d0, H, W, C1); break;
+        case 3: k_conv2d<TILE3,3><<<g3,blk,0,_st>>>(d1, f, b, d0, H, W, C1); break;
+        case 5: k_conv2d<TILE5,5><<<g5,blk,0,_st>>>(d1, f, b, d0, H, W, C1); break;
         default:
             ERROR("model_fwd#conv kernel_size=%d not supported\n", ks);
             return -1;
         }
-        GPU_SYNC();
+        ST_SYNC();
     }
     return 0;
 }
 
+///
+///> fused conv2d block, layers i..i+2 => tensor i+3
+///
+#define IS_ACT1(fn)  ((fn)!=L_AVGPOOL && (fn)!=L_MAXPOOL && (fn)!=L_MINPOOL)
+__GPU__ int
+Model::_ffuse(U16 i) {
+    Tensor &in = (*this)[i], &out = (*this)[i + 3];
+    Tensor &l1 = (*this)[i + 1], &l2 = (*this)[i + 2];
+    Tensor &tf = *in.grad[0], &tb = *in.grad[1];          ///< filter, bias tensors
+
+    const bool a1 = IS_ACT1(l1.grad_fn);                  ///< activate before pool
+    Tensor &ac = a1 ? l1 : l2, &pl = a1 ? l2 : l1;        ///< activation, pooling layers
+    const int H  = l1.H(), W = l1.W(), C1 = in.C();       ///< conv output HW
+    const int ks = tf.H(), ps = pl.parm;                  ///< conv, pool kernel sizes
+
+    TRACE1(" f[%d,%d,%d,%d] + %s + %s %dx%d",
+        tf.N(), tf.H(), tf.W(), tf.C(),
+        d_nname(l1.grad_fn), d_nname(l2.grad_fn), ps, ps);
+
+    DU  *msk   = ac.grad[0] ? ac.grad[0]->data : NULL;    ///< no mask in inference
+    int *idx   = pl.grad[0] ? (int*)pl.grad[0]->data : NULL;
+    DU  alpha  = 0.001 * ac.parm;
+
+    dim3 blk(T4_WARP_SQ, 1, 1);                           ///< default blocks
+    dim3 grd((out.H() * out.W() + blk.x - 1) / blk.x, out.C(), out.N());
+
+#define CONV_POOL(K, P)  k_conv_pool<K,P><<<grd,blk>>>(   \
+        pl.grad_fn, ac.grad_fn, a1,                       \
+        in.data, tf.data, tb.data, out.data, msk, idx,    \
+        alpha, H, W, C1)
+
+    switch (ks * 10 + ps) {
+    case 12: CONV_POOL(1, 2); break;
+    case 13: CONV_POOL(1, 3); break;
+    case 32: CONV_POOL(3, 2); break;
+    case 33: CONV_POOL(3, 3); break;
+    case 52: CONV_POOL(5, 2); break;
+    case 53: CONV_POOL(5, 3); break;
+    default:
+        ERROR("model#fuse conv=%d pool=%d not supported\n", ks, ps);
+        return -1;
+    }
+#undef CONV_POOL
+    GPU_SYNC();
+
+    return 0;
+}
+
 __GPU__ int
 Model::_flinear(Tensor &in, Tensor &out) {
     auto qa_calc = [&in, &out](Tensor &tw, Tensor &tb) {
@@ -324,10 +529,10 @@ Model::_flinear(Tensor &in, Tensor &out) {
         dim3 blk(T4_WARP_SZ, T4_WARP_SZ, 1);          ///< default blocks
         dim3 grd(NGRID(C1, C0, N, blk));              ///< default grids
 
-        k_linear<<<grd,blk>>>(
+        k_linear<<<grd,blk,0,_st>>>(
             in.data, out.data, tw.data, tb.data,
             C1, C0, in.HWC(), out.HWC());
-        GPU_SYNC();                                   /// * this makes it slow
+        ST_SYNC();                                   /// * this makes it slow
     }
     return 0;
 }
@@ -338,10 +543,11 @@ Model::_factivate(Tensor &in, Tensor &out, t4_layer fn) {
     dim3 grd((in.numel + blk.x - 1)/blk.x, 1, 1);
 
     DU alpha = 0.001 * in.parm;
+    DU *msk  = in.grad[0] ? in.grad[0]->data : NULL;   ///< no mask in inference
 
-    k_activate<<<grd, blk>>>(
-        fn, in.data, in.grad[0]->data, out.data, alpha, in.numel);
-    GPU_SYNC();
+    k_activate<<<grd, blk, 0, _st>>>(
+        fn, in.data, msk, out.data, alpha, in.numel);
+    ST_SYNC();
 
     return 0;
 }
@@ -355,13 +561,13 @@ Model::_fpool(Tensor &in, Tensor &out, t4_layer fn) {
     dim3 grd((H * W + blk.x - 1) / blk.x, out.C(), out.N());
 
     switch(ks) {                                        /// pooling kernel size
-    case 2: k_pool<2><<<grd,blk>>>(fn, in.data, out.data, H, W); break;
-    case 3: k_pool<3><<<grd,blk>>>(fn, in.data, out.data, H, W); break;
+    case 2: k_pool<2><<<grd,blk,0,_st>>>(fn, in.data, out.data, H, W); break;
+    case 3: k_pool<3><<<grd,blk,0,_st>>>(fn, in.data, out.data, H, W); break;
     default:
         ERROR("model#pooling kernel_size=%d not supported\n", ks);
         return -1;
     }
-    GPU_SYNC();
+    ST_SYNC();
 
     return 0;
 }
@@ -454,13 +660,13 @@ Model::_fupsample(Tensor &in, Tensor &out) {
     dim3 grd((H * W + blk.x - 1) / blk.x, in.C(), in.N());
 
     switch(ks) {
-    case 2: k_dpool<2><<<grd,blk>>>(L_USAMPLE, out.data, in.data, H, W); break;
-    case 3: k_dpool<3><<<grd,blk>>>(L_USAMPLE, out.data, in.data, H, W); break;
+    case 2: k_dpool<2><<<grd,blk,0,_st>>>(L_USAMPLE, out.data, in.data, H, W); break;
+    case 3: k_dpool<3><<<grd,blk,0,_st>>>(L_USAMPLE, out.data, in.data, H, W); break;
     default:
         ERROR("model#upsample size=%d not supported\n", ks);
         return -1;
     }
-    GPU_SYNC();
+    ST_SYNC();
 
     //_dump(in.data,  in.H(), in.W(), in.C());
     //_dump(out.data, out.H(), out.W(), out.C());
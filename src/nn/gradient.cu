@@ -9,17 +9,32 @@
 #if (T4_ENABLE_OBJ && T4_ENABLE_NN)
 #include "dataset.h"
 
+///
+/// find table entry of current block (entries sorted by first block)
+///
+__GPU__ __INLINE__ t4_mta&
+_mta(t4_mta *tbl, int n) {
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {                                      /// * binary search
+        int md = (lo + hi + 1) >> 1;
+        if (tbl[md].blk <= (int)blockIdx.x) lo = md;
+        else hi = md - 1;
+    }
+    return tbl[lo];
+}
+
 __KERN__ void k_sgd(
-    DU *G, DU *DG, DU *M,                    ///< w, dw, and momemtum tensors
-    int N, int numel,                        ///< batch size and HWC
+    t4_mta *tbl, int n,                      ///< w, dw, and momemtum tensor table
     DU lr, DU b                              ///< learn rate, beta(momemtum)
     ) {
-    const int i = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+    t4_mta &t = _mta(tbl, n);                              ///< tensor of this block
+    const int i = threadIdx.x + (blockIdx.x - t.blk) * blockDim.x;   ///< element index
     
-    if (i < numel) {
-        if (ABS(b) < DU_EPS) G[i] -= lr * DG[i] / N;
+    if (i < t.numel) {
+        DU *G = t.g, *DG = t.dg, *M = t.m;
+        if (ABS(b) < DU_EPS) G[i] -= lr * DG[i] / t.N;
         else {
-            DU dg = DG[i] / N;                             ///< dG batch avg
+            DU dg = DG[i] / t.N;                           ///< dG batch avg
             DU mi = M[i] = b * M[i] + (1.0 - b) * dg;      ///< momentum
             G[i] -= lr * mi;                               /// * update gradient
         }
@@ -28,13 +43,14 @@ __KERN__ void k_sgd(
 }
 
 __KERN__ void k_adam(
-    DU *G, DU *DG, DU *M, DU *V,            ///< w, dw, and momemtum tensors
-    int N, int numel,                       ///< batch size and HWC
+    t4_mta *tbl, int n,                     ///< w, dw, and momemtum tensor table
     DU lrc, DU b1, DU b2                    ///< corrected learn rate, beta(momemtum)
     ) {
-    const int i = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+    t4_mta &t = _mta(tbl, n);                              ///< tensor of this block
+    const int i = threadIdx.x + (blockIdx.x - t.blk) * blockDim.x;   ///< element index
     
-    if (i < numel) {
+    if (i < t.numel) {
+        DU *G = t.g, *DG = t.dg, *M = t.m, *V = t.v;
         DU dg = DG[i];                                     ///< dG (no batch avg)
         DU mi = M[i] = b1 * M[i] + (DU1 - b1) * dg;        ///< momentum
         DU vi = V[i] = b2 * V[i] + (DU1 - b2) * dg * dg;   ///< velocity
@@ -64,22 +80,22 @@ Model::grad_alloc(t4_optimizer op) {
             break;
         case OPTI_SGDM:
             if (do_w && !in.mtum[0]) {
-                in.mtum[0] = &_mmu->copy(*dw).fill(DU0); ///< m of w (zero filled)
+                in.mtum[0] = &_mmu->copy(*dw, MT_MTUM).fill(DU0); ///< m of w (zero filled)
                 in.mtum[2] = NULL;                       ///< dummy
             }
             if (do_b && !in.mtum[1]) {
-                in.mtum[1] = &_mmu->copy(*db).fill(DU0); ///< m of b (zero filled)
+                in.mtum[1] = &_mmu->copy(*db, MT_MTUM).fill(DU0); ///< m of b (zero filled)
                 in.mtum[3] = NULL;                       ///< dummy
             }
             break;
         case OPTI_ADAM:
             if (do_w && !in.mtum[0]) {
-                in.mtum[0] = &_mmu->copy(*dw).fill(DU0); ///< m of w (zeor filled)
-                in.mtum[2] = &_mmu->copy(*dw).fill(DU0); ///< v of w (zero filled)
+                in.mtum[0] = &_mmu->copy(*dw, MT_MTUM).fill(DU0); ///< m of w (zeor filled)
+                in.mtum[2] = &_mmu->copy(*dw, MT_MTUM).fill(DU0); ///< v of w (zero filled)
             }
             if (do_b && !in.mtum[1]) {
-                in.mtum[1] = &_mmu->copy(*db).fill(DU0); ///< m of b (zero filled)
-                in.mtum[3] = &_mmu->copy(*db).fill(DU0); ///< v of b (zero filled)
+                in.mtum[1] = &_mmu->copy(*db, MT_MTUM).fill(DU0); ///< m of b (zero filled)
+                in.mtum[3] = &_mmu->copy(*db, MT_MTUM).fill(DU0); ///< v of b (zero filled)
             }
             break;
         }
@@ -91,34 +107,58 @@ Model::grad_alloc(t4_optimizer op) {
 }
 ///
 ///> grandiant descent iterator
+///  @brief - all weight and bias tensors are collected into one table
+///           and updated by a single kernel launch (multi-tensor apply)
 ///
 __GPU__ Model&
 Model::gradient(const char *nm, GdFunc fn, DU *parm, t4_optimizer op) {
-    auto step = [this, fn, parm](const char n,
-            Tensor *g, Tensor *dg, Tensor *m, Tensor *v) {
-            TRACE1("\n    %c[%d,%d,%d,%d] Σ=%6.3f - %6.3f",
-                   n, g->N(), g->H(), g->W(), g->C(), g->sum(), dg->sum());
-            fn(parm, g, dg, m, v);
-            TRACE1(" => %cΣ=%6.3f", n, g->sum());
+    int tlvl = _mmu->trace();
+    auto trace = [this](int i, const char n, Tensor *g, Tensor *dg) {
+        Tensor &in = (*this)[i];
+        printf("\n  %2d> %s %c[%d,%d,%d,%d] Σ=%6.3f - %6.3f",
+               i, d_nname(in.grad_fn), n, g->N(), g->H(), g->W(), g->C(),
+               g->sum(), dg ? dg->sum() : DU0);
     };
-    TRACE1("\nModel::%s batch_sz=%d, lr=%7.4f, mtum/b1=%6.3f, b2=%6.3f\n",
+    if (tlvl) printf("\nModel::%s batch_sz=%d, lr=%7.4f, mtum/b1=%6.3f, b2=%6.3f\n",
            nm, (*this)[1].N(), parm[0], parm[1], parm[2]);
     if (_iter++==0) grad_alloc(op);               /// * allocate m & v tensors
     if (!train) return *this;                     /// * bail if not in trainning
     ///
-    /// cascade execution layer by layer forward
+    /// collect (w, dw, m, v) of all layers
     ///
-    DU t0 = _mmu->ms();                           ///< performance measurement
-    for (U16 i = 1; i < numel - 1; i++) {         /// TODO: parallel layer update
+    DU     t0  = _mmu->ms();                      ///< performance measurement
+    t4_mta *tbl = new t4_mta[(numel - 2) * 2];    ///< multi-tensor table
+    int    n = 0, nblk = 0;                       ///< table entries, total blocks
+    auto add = [tbl, &n, &nblk](Tensor *g, Tensor *dg, Tensor *m, Tensor *v) {
+        tbl[n++] = {
+            g->data, dg->data, m->data, v ? v->data : NULL,
+            g->N(), (int)g->numel, nblk
+        };
+        nblk += (g->numel + T4_WARP_SQ - 1) / T4_WARP_SQ;
+    };
+    for (U16 i = 1; i < numel - 1; i++) {
         Tensor &in = (*this)[i];
         Tensor *w  = in.grad[0], *dw = in.grad[2];
         Tensor *b  = in.grad[1], *db = in.grad[3];
         
-        TRACE1("\n  %2d> %s", i, d_nname(in.grad_fn));
-        if (in.mtum[0]) step('w', w, dw, in.mtum[0], in.mtum[2]);
-        if (in.mtum[1]) step('b', b, db, in.mtum[1], in.mtum[3]);
+        if (in.mtum[0]) {
+            if (tlvl) trace(i, 'w', w, dw);
+            add(w, dw, in.mtum[0], in.mtum[2]);
+        }
+        if (in.mtum[1]) {
+            if (tlvl) trace(i, 'b', b, db);
+            add(b, db, in.mtum[1], in.mtum[3]);
+        }
+    }
+    if (n) fn(parm, tbl, n, nblk);                /// * one launch for all layers
+    delete[] tbl;
+
+    for (U16 i = 1; tlvl && i < numel - 1; i++) { /// * sums only when tracing
+        Tensor &in = (*this)[i];
+        if (in.mtum[0]) trace(i, 'w', in.grad[0], NULL);
+        if (in.mtum[1]) trace(i, 'b', in.grad[1], NULL);
     }
-    TRACE1("\nModel::%s %5.2f ms\n", nm, _mmu->ms() - t0);
+    if (tlvl) printf("\nModel::%s %d tensors %5.2f ms\n", nm, n, _mmu->ms() - t0);
     return *this;
 }
 ///
@@ -128,31 +168,25 @@ Model::gradient(const char *nm, GdFunc fn, DU *parm, t4_optimizer op) {
 ///
 __GPU__ Model&
 Model::sgd(DU lr, DU b) {                          /// a=momentum
-    auto update = [](DU *parm, Tensor *g, Tensor *dg, Tensor *m, Tensor *v) {
-        const int numel = g->numel;
+    auto update = [](DU *parm, t4_mta *tbl, int n, int nblk) {
         const dim3 blk(T4_WARP_SQ, 1, 1);          ///< default blocks
-        const dim3 grd((numel + blk.x - 1) / blk.x, 1, 1);
+        const dim3 grd(nblk, 1, 1);                ///< blocks of all tensors
 
-        k_sgd<<<grd,blk>>>(
-            g->data, dg->data, m->data,
-            g->N(), numel, parm[0], parm[1]);
+        k_sgd<<<grd,blk>>>(tbl, n, parm[0], parm[1]);
         GPU_SYNC();
     };
-    DU parm[2] = { lr, _iter ? b : DU0 };
+    DU parm[3] = { lr, _iter ? b : DU0, DU0 };
 
     return gradient("sgd", update, parm, ABS(b) < DU_EPS ? OPTI_SGD : OPTI_SGDM);
 }
 
 __GPU__ Model&
 Model::adam(DU lr, DU b1, DU b2) {
-    auto update = [](DU *parm, Tensor *g, Tensor *dg, Tensor *m, Tensor *v) {
-        const int numel = g->numel;
+    auto update = [](DU *parm, t4_mta *tbl, int n, int nblk) {
         const dim3 blk(T4_WARP_SQ, 1, 1);         ///< default blocks
-        const dim3 grd((numel + blk.x - 1) / blk.x, 1, 1);
+        const dim3 grd(nblk, 1, 1);               ///< blocks of all tensors
 
-        k_adam<<<grd,blk>>>(
-            g->data, dg->data, m->data, v->data,
-            g->N(), numel, parm[0], parm[1], parm[2]);
+        k_adam<<<grd,blk>>>(tbl, n, parm[0], parm[1], parm[2]);
         GPU_SYNC();
     };
     DU parm[3] = {
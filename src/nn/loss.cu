@@ -8,9 +8,50 @@
 
 #if (T4_ENABLE_OBJ && T4_ENABLE_NN)
 #include "dataset.h"
+#include "xloss.h"
+///
+/// fused loss and hit count, one thread per sample, warp reduced
+///
+__KERN__ void k_xloss(
+    t4_loss op, DU *O, U32 *L,             ///< loss op, output logits, labels
+    int HWC, int N,                        ///< sample size, batch size
+    DU *sum, int *hit                      ///< results (accumulated)
+    ) {
+    const int n = threadIdx.x + blockIdx.x * blockDim.x;   ///< sample index
+    DU  v = DU0;
+    int h = 0;
+    if (n < N) v = xloss1(op, &O[(U64)n * HWC], HWC, xl_label(L, n, HWC), h);
+    for (int d = 16; d > 0; d >>= 1) {
+        v += __shfl_down_sync(0xffffffff, v, d);
+        h += __shfl_down_sync(0xffffffff, h, d);
+    }
+    if ((threadIdx.x & 31) == 0) { atomicAdd(sum, v); atomicAdd(hit, h); }
+}
+///
+/// dLoss or one-hot vector from labels, element-wise
+///
+__KERN__ void k_xdloss(
+    bool sub, DU *O, U32 *L,               ///< out - onehot or onehot, output, labels
+    int HWC, U64 numel
+    ) {
+    const U64 k = threadIdx.x + (U64)blockIdx.x * blockDim.x;  ///< element index
+    if (k < numel) O[k] = xdloss1(sub, O, L, HWC, k);
+}
 
 __GPU__ Tensor&
 Model::onehot() {
+    if (_lbl) {                                     /// * materialized on request only
+        Tensor &out = (*this)[-1];
+        if (!_hot || _hot->numel != out.numel) {
+            if (_hot) _mmu->drop(T4Base::obj2du(*_hot));
+            _hot = &_t4(out.N(), out.HWC());
+        }
+        int  HWC = out.HWC();
+        dim3 blk(T4_WARP_SQ, 1, 1);
+        dim3 grd((_hot->numel + blk.x - 1) / blk.x, 1, 1);
+        k_xdloss<<<grd, blk>>>(false, _hot->data, _lbl, HWC, _hot->numel);
+        GPU_SYNC();
+    }
     if (_hot) return *_hot;
     
     ERROR("ERROR: Model.onehot not provided by dataset, input onehot tensor!\n");
@@ -21,50 +62,50 @@ Model::onehot() {
 ///
 __GPU__ Tensor&
 Model::onehot(Dataset &dset) {
-    auto show = [](DU *h, int n, int sz) {
-        printf("Model::onehot[%d]={", n);
-        for (int i = 0; i < sz; i++) {
-            printf("%2.0f", h[i]);
-        }
-        printf(" }\n");
-    };
-    Tensor &out = (*this)[-1];                      ///< model output
-    int    N    = out.N(), HWC = out.HWC();         ///< sample size
-    Tensor &hot = _t4(N, HWC).fill(DU0);            ///< one-hot vector
-    for (int n = 0; n < N; n++) {                   /// * loop through batch
-        DU *h = hot.slice(n);                       ///< take a sample
-        U16 i = dset.label[n];                      ///< label index
-        h[i < HWC ? i : 0] = DU1;                   /// * mark hot by index
-        if (_mmu->trace() > 1) show(h, n, HWC);
-    }
-    return hot;
+    _lbl = dset.label;
+    return onehot();
 }
 
 __GPU__ int
 Model::hit(bool recalc) {
     if (!recalc) { return _hit; }                   /// * return current hit count
+    if (!_lbl)   { return 0;    }                   /// * no labels, no hits
     
-    auto argmax = [](DU *h, int sz) {
-        DU  mx = *h;
-        int m  = 0;
-        for (int i = 1; i < sz; i++) {              /// * CDP 
-            if (h[i] > mx) { mx = h[i]; m = i; }
-        }
-        return m;
-    };
-    Tensor &out = (*this)[-1];                      ///< model output
-    int cnt = 0;
-    for (int n = 0; n < out.N(); n++) {             ///< loop through batch
-        int  m = argmax(out.slice(n), out.HWC());
-        cnt += INT(_hot->slice(n)[m]);              /// * compare to onehot vector
-    }
+    DU  sum;
+    int cnt = _xloss(LOSS_NLL, &sum);               /// * cheapest loss, hits only
     TRACE1("Model::hit=%d\n", cnt);
     return cnt;
 }
 
 __GPU__ DU
 Model::loss(t4_loss op) {
-    return loss(op, *_hot);                         /// * use default one-hot vector
+    static const char *opn[] = { "MSE", "BCE", "CE", "NLL" };
+    if (!_lbl) return loss(op, *_hot);              /// * use broadcast target vector
+
+    DU sum;
+    _xloss(op, &sum);                               /// * no one-hot, no temp copy
+    sum /= (*this)[-1].N();                         /// * mini-batch average
+    TRACE1("Model#loss: %s=%6.3f\n", opn[op], sum);
+    
+    return SCALAR(sum);
+}
+///
+/// fused loss sum and hit count against dataset labels
+///
+__GPU__ int
+Model::_xloss(t4_loss op, DU *sum) {
+    Tensor &out = (*this)[-1];                      ///< model output
+    int    N    = out.N();
+    dim3   blk(T4_WARP_SQ, 1, 1);
+    dim3   grd((N + blk.x - 1) / blk.x, 1, 1);
+
+    _xsum = DU0;
+    _xhit = 0;
+    k_xloss<<<grd, blk>>>(op, out.data, _lbl, out.HWC(), N, &_xsum, &_xhit);
+    GPU_SYNC();
+
+    *sum = _xsum;
+    return _xhit;
 }
 
 __GPU__ DU
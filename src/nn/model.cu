@@ -36,6 +36,15 @@ Model::reset(MMU *mmu, Tensor &store) {
     _store = &store;
     data   = store.data;                    /// * cached entries
     train  = 1;
+    _infer = false;
+    _buf[0] = _buf[1] = NULL;
+    _slot  = _plan = NULL;
+    _mb    = 1;
+    _nst   = 0;
+    _st    = 0;
+    _ndp   = 1;
+    _ndg   = 0;
+    _dpg   = NULL;
     npush(store);                           /// * model.data[0] = store
 }
 __GPU__ Model&
@@ -56,10 +65,13 @@ __GPU__ int    Model::batch_size()     { return (*this)[1].N(); }
 ///
 __GPU__ Model&
 Model::add(t4_layer fn, U16 n, DU bias, U16 *opt) {
+    if (_plan) { ERROR("Model#add after nn.plan\n"); return *this; }
     Tensor &in = (*this)[-1];
     if (in.grad_fn != L_NONE) return *this;    /// * tensor already setup
 
     for (int i=0; i<4; i++) in.grad[i] = in.mtum[i] = NULL;
+    in.qnt[0] = in.qnt[1] = NULL;
+    in.grad_fn = fn;                           /// * set layer function name
     switch(fn) {
     case L_CONV:    _iconv(in, n, bias, opt);   break;
     case L_LINEAR:  _ilinear(in, n, bias);      break;
@@ -80,19 +92,19 @@ Model::add(t4_layer fn, U16 n, DU bias, U16 *opt) {
     case L_USAMPLE: _iup(in, n, bias);          break;
     default: ERROR("Model#add layer %d not supported\n", fn);
     }
-    in.grad_fn = fn;                           /// * set layer function name
-    
+    if (numel > 4) _ifuse(numel - 4, true);    /// * conv2d block completed?
+    if (_infer) _ishare(true);                 /// * attach new output to ping-pong buffers
     return *this;
 }
 ///
 /// internal tensor constructors
 /// 
 __GPU__ Tensor&
-Model::_vec(U16 sz)       { return _mmu->tensor(sz); }
+Model::_vec(U16 sz)       { return _mmu->talloc(sz, MT_MODEL); }
 __GPU__ Tensor&
-Model::_t4(U16 n, U16 h)  { return _mmu->tensor(n, h, 1, 1); }
+Model::_t4(U16 n, U16 h)  { return _mmu->tensor(n, h, 1, 1, MT_MODEL); }
 __GPU__ Tensor&
-Model::_t4(U16 n, U16 h, U16 w, U16 c) { return _mmu->tensor(n, h, w, c); }
+Model::_t4(U16 n, U16 h, U16 w, U16 c) { return _mmu->tensor(n, h, w, c, MT_MODEL); }
 ///
 /// Convolution and Linear ops
 ///
@@ -115,9 +127,8 @@ Model::_iconv(Tensor &in, U16 C0, DU bias, U16 *opt) {
     /// TODO: filters's 5th dimension is stored in parm field for now
     ///
     Tensor *f  = in.grad[0] = &_t4(C1, Hf, Wf, C0);                ///> f
-    Tensor *df = in.grad[2] = &_t4(C1, Hf, Wf, C0).map(FILL, DU0); ///> df
     Tensor *b  = in.grad[1] = &_vec(C0);                           ///> b
-    Tensor *db = in.grad[3] = &_vec(C0).map(FILL, DU0);            ///> db
+    if (!_infer) _igrad(in, true);                                 ///> df, db
 
     DU k = SQRT(RCP(Hf * Wf * C1));              /// * filter default range
     _mmu->random(*f, UNIFORM, -0.5, 2.0 * k);    /// * randomize f [-k, k)
@@ -134,9 +145,8 @@ __GPU__ void
 Model::_ilinear(Tensor &in, U16 C0, DU bias) {
     U16 N1 = in.N(), C1 = in.HWC();
     Tensor *w  = in.grad[0] = &_t4(1, C0, C1, 1);                 ///> w
-    Tensor *dw = in.grad[2] = &_t4(1, C0, C1, 1).map(FILL, DU0);  ///> dw
     Tensor *b  = in.grad[1] = &_vec(C0);                          ///> b
-    Tensor *db = in.grad[3] = &_vec(C0).map(FILL, DU0);           ///> db
+    if (!_infer) _igrad(in, true);                                ///> dw, db
     
     in.parm = INT(bias * 1000.0);                /// * keep for persistence
     
@@ -167,15 +177,15 @@ Model::_iflatten(Tensor &in) {
 ///
 __GPU__ void
 Model::_icopy(Tensor &in, t4_layer fn) {
-    Tensor &out = _mmu->copy(in);                ///> output tensor sizing
+    Tensor &out = _mmu->copy(in, MT_MODEL);      ///> output tensor sizing
     TRACE1("model#add %s\n", d_nname(fn));
     npush(out);                                  /// * stage for next stage
 }
 
 __GPU__ void
 Model::_iactivate(Tensor &in, DU alpha, t4_layer fn) {
-    Tensor &out = _mmu->copy(in);
-    Tensor *msk = in.grad[0] = &_mmu->copy(in);  ///> activation mask
+    Tensor &out = _mmu->copy(in, MT_MODEL);
+    if (!_infer) _igrad(in, true);               ///> activation mask
 
     in.parm = INT(1000.0 * alpha);               /// * bias * 1000
     TRACE1("model#add %s (alpha=%6.3f)\n", d_nname(fn), alpha);
@@ -208,7 +218,7 @@ Model::_ibatchnorm(Tensor &in, DU m) {
     in.grad[0] = &_vec(C*2).map(FILL, DU0);      ///> weight/gamma, bias/beta
     in.grad[1] = &_vec(C*2);                     ///> tmp storage
     in.grad[2] = &_vec(C*2).map(FILL, DU0);      ///> d_gamma, d_beta
-    in.grad[3] = &_mmu->copy(in);                ///> x_hat (same as in)
+    in.grad[3] = &_mmu->copy(in, MT_GRAD);       ///> x_hat (same as in)
 
     for (int c=0; c < C; c++) {                  /// * default gamma=1.0, beta=0.0
         in.grad[0]->data[c] = DU1;
@@ -216,7 +226,7 @@ Model::_ibatchnorm(Tensor &in, DU m) {
     in.parm = INT(1000.0 * m);                   ///> default EMA momentum = 0.1
     TRACE1("model#add batchnorm m=%5.3f\n", m);
     
-    Tensor &out = _mmu->copy(in);                /// * retain dimensions
+    Tensor &out = _mmu->copy(in, MT_MODEL);      /// * retain dimensions
     npush(out);
 }
 
@@ -236,6 +246,275 @@ Model::_iup(Tensor &in, U16 f, DU method) {
     Tensor &out = _t4(in.N(), H0, W0, in.C());
     npush(out);                                  /// * stage for next stage
 }
+///
+/// Layer fusion
+/// @brief - conv2d => pool => activation (or conv2d => activation => pool)
+///          runs as one kernel, pre-pool conv output is never written.
+///          max/min pool keeps argmax in grad[0] for backprop
+///
+#define IS_POOL(fn) ((fn)==L_AVGPOOL || (fn)==L_MAXPOOL || (fn)==L_MINPOOL)
+#define IS_ACT(fn)  ((fn)==L_RELU || (fn)==L_TANH || (fn)==L_SIGMOID || \
+                     (fn)==L_SELU || (fn)==L_LEAKYRL || (fn)==L_ELU)
+__GPU__ bool
+Model::_ifuse(U16 i, bool on) {
+    Tensor &in = (*this)[i];
+    if (in.grad_fn != L_CONV || i + 3 >= numel) return false;
+
+    Tensor &l1 = (*this)[i + 1], &l2 = (*this)[i + 2];
+    const bool a1 = IS_ACT(l1.grad_fn);               ///< activate before pool
+    Tensor &ac = a1 ? l1 : l2, &pl = a1 ? l2 : l1;    ///< activation, pooling layers
+    if (!IS_ACT(ac.grad_fn) || !IS_POOL(pl.grad_fn) ||
+        l1.H() != in.H() || l1.W() != in.W()) return false;  /// * stride 1, same padding only
+
+    if (on && !in.fuse) {
+        if (pl.grad_fn != L_AVGPOOL) {                /// * argmax of pooling
+            pl.grad[0] = &_mmu->talloc((*this)[a1 ? i + 3 : i + 2].numel, MT_GRAD);
+        }
+        TRACE1("model#fuse %s + %s + %s\n",
+               d_nname(in.grad_fn), d_nname(l1.grad_fn), d_nname(l2.grad_fn));
+    }
+    else if (!on && in.fuse && pl.grad[0]) {
+        _mmu->free(*pl.grad[0]);
+        pl.grad[0] = NULL;
+    }
+    in.fuse = on;
+    return true;
+}
+///
+/// fuse (or split) all conv2d blocks of the model
+///
+__GPU__ Model&
+Model::fuse(bool on) {
+    if (_plan) { ERROR("Model::fuse before nn.plan\n"); return *this; }
+    int n = 0;
+    for (U16 i = 1; i + 3 < numel; i++) {
+        if (_ifuse(i, on)) n++;
+    }
+    INFO("Model::fuse %s, %d conv2d block(s)\n", on ? "on" : "off", n);
+    return *this;
+}
+///
+/// micro-batch pipeline, n streams are created on first use and kept
+/// until the model is freed (n=0)
+///
+__GPU__ Model&
+Model::pipe(int n) {
+    if (n < 0 || n > T4_MB_MAX) {
+        ERROR("Model::pipe n=%d not in 0..%d\n", n, T4_MB_MAX);
+        return *this;
+    }
+    if (n == 0) {                                /// * release streams
+        for (int i = 0; i < _nst; i++) cudaStreamDestroy(_mst[i]);
+        _nst = 0;
+        _mb  = 1;
+        return *this;
+    }
+    _streams(n);
+    _mb = n;
+    INFO("Model::pipe %d micro-batch(es)%s\n", n,
+         (_infer || _plan) && n > 1 ? ", off with nn.infer/nn.plan" : "");
+    return *this;
+}
+///
+/// data-parallel replicas, replica r takes samples [r*N/n, (r+1)*N/n)
+/// of every batch and backprops them on stream r into its own dw/db,
+/// weights are shared so only dw/db are reduced before sgd/adam
+///
+__GPU__ Model&
+Model::dp(int n) {
+    if (n < 1 || n > T4_VM_COUNT) {
+        ERROR("Model::dp n=%d not in 1..%d\n", n, T4_VM_COUNT);
+        return *this;
+    }
+    if (_dpg) {                                  /// * release replicas
+        for (int k = 0; k < _ndg; k++) {
+            if (_dpg[k]) _mmu->free(*_dpg[k]);
+        }
+        free(_dpg);
+        _dpg = NULL;
+        _ndg = 0;
+        _mb  = 1;                                /// * shard forward off too
+    }
+    _ndp = 1;
+    if (n == 1) return *this;
+
+    const int N = batch_size();
+    if (N % n) {
+        ERROR("Model::dp batch size %d not divisible by %d\n", N, n);
+        return *this;
+    }
+    if (_infer || _plan) {
+        ERROR("Model::dp not with nn.infer or nn.plan\n");
+        return *this;
+    }
+    for (U16 i = 1; i < numel - 1; i++) {       /// * every layer per shard
+        Tensor   &in = (*this)[i];
+        t4_layer fn  = in.grad_fn;
+        if (!in.fuse && (_fpipe_ok(in) || fn == L_SOFTMAX || fn == L_LOGSMAX)) continue;
+        ERROR("Model::dp layer %d %s not replicable%s\n", i, d_nname(fn),
+              in.fuse ? ", 0 nn.fuse first" : "");
+        return *this;
+    }
+    _streams(n);
+    const int m = numel * 2;                     ///< entries per replica
+    _ndg = (n - 1) * m;
+    _dpg = (Tensor**)malloc(sizeof(Tensor*) * _ndg);
+    U64 sz = 0;
+    for (int r = 1; r < n; r++) {
+        for (U16 i = 0; i < numel; i++) {
+            Tensor &in = (*this)[i];
+            Tensor **g = &_dpg[(r - 1) * m + i * 2];
+            g[0] = g[1] = NULL;
+            if (i == 0 || i == numel - 1) continue;
+            if (in.grad_fn != L_CONV && in.grad_fn != L_LINEAR) continue;
+            g[0] = &_mmu->copy(*in.grad[2], MT_GRAD).fill(DU0);  ///< dw
+            g[1] = &_mmu->copy(*in.grad[3], MT_GRAD).fill(DU0);  ///< db
+            sz  += (g[0]->numel + g[1]->numel) * sizeof(DU);
+        }
+    }
+    _ndp = n;
+    _mb  = n;                                    /// * replica r also forwards shard r
+    INFO("Model::dp %d replicas x %d samples, dw/db +%ld bytes\n", n, N / n, sz);
+    return *this;
+}
+///
+/// non-blocking streams are created on demand and kept until pipe(0)
+///
+__GPU__ void
+Model::_streams(int n) {
+    for (; _nst < n; _nst++) {
+        cudaStreamCreateWithFlags(&_mst[_nst], cudaStreamNonBlocking);
+    }
+}
+
+///
+/// Inference mode
+/// @brief - gradients and activation masks are released (or never allocated),
+///          layer outputs share two ping-pong buffers instead of one each
+///
+__GPU__ Model&
+Model::inference(bool on) {
+    if (on == _infer) return *this;
+    if (on) plan(0);                             /// * ping-pong replaces planner
+
+    U64 sz = 0;                                  ///< bytes released (or restored)
+    for (U16 i = 1; i < numel - 1; i++) {
+        sz += _igrad((*this)[i], !on);
+    }
+    sz += _ishare(on);
+    _infer = on;
+    train  = !on;                                /// * inference is never trainable
+    _iter  = 0;                                  /// * realloc m & v on next gradient
+    INFO("Model::inference %s, %s %ld bytes\n",
+         on ? "on" : "off", on ? "released" : "restored", sz);
+
+    return *this;
+}
+///
+/// detach layers from ping-pong buffers or arena slots (i.e. before freeing the model)
+///
+__GPU__ void
+Model::unshare() {
+    if (_plan) _unplan(false);
+    if (!_buf[0]) return;
+    for (U16 i = 2; i < numel; i++) (*this)[i].data = NULL;
+    _mmu->free(*_buf[0]);
+    _mmu->free(*_buf[1]);
+    _buf[0] = _buf[1] = NULL;
+}
+///
+/// release or restore gradient tensors of a layer, return bytes involved
+///
+__GPU__ U64
+Model::_igrad(Tensor &in, bool on) {
+    auto drop = [this](Tensor **t) {
+        if (!*t) return (U64)0;
+        U64 sz = (*t)->numel * sizeof(DU);
+        _mmu->free(**t);
+        *t = NULL;
+        return sz;
+    };
+    U64 sz = 0;
+    switch (in.grad_fn) {
+    case L_CONV:
+    case L_LINEAR:
+        if (on) {
+            Tensor &w = *in.grad[0], &b = *in.grad[1];
+            if (!in.grad[2]) {
+                in.grad[2] = &_mmu->copy(w, MT_GRAD).fill(DU0); ///> dw, df
+                in.grad[3] = &_mmu->copy(b, MT_GRAD).fill(DU0); ///> db
+                sz += (w.numel + b.numel) * sizeof(DU);
+            }
+            break;
+        }
+        for (int i = 0; i < 4; i++) {                     /// * momentum tensors
+            if (in.mtum[i] == in.grad[i]) in.mtum[i] = NULL; /// * dummy for SGD
+            else sz += drop(&in.mtum[i]);
+        }
+        sz += drop(&in.grad[3]);
+        sz += drop(&in.grad[2]);
+        break;
+    case L_RELU:
+    case L_TANH:
+    case L_SIGMOID:
+    case L_SELU:
+    case L_LEAKYRL:
+    case L_ELU:
+    case L_DROPOUT:
+        if (!on)              sz += drop(&in.grad[0]);
+        else if (!in.grad[0]) {
+            in.grad[0] = &_mmu->copy(in, MT_GRAD);        ///> activation mask
+            sz += in.numel * sizeof(DU);
+        }
+        break;
+    }
+    return sz;
+}
+///
+/// move layer outputs into (or out of) two shared ping-pong buffers
+///
+__GPU__ U64
+Model::_ishare(bool on) {
+    U64 sz = 0, mx = 0;
+    if (!on) {
+        if (!_buf[0]) return 0;
+        for (U16 i = 2; i < numel; i++) {             /// * private storage again
+            Tensor &t = (*this)[i];
+            DU     *d = t.data;
+            t.data = _mmu->dalloc(t.numel);
+            memcpy(t.data, d, t.numel * sizeof(DU));
+            sz += t.numel * sizeof(DU);
+        }
+        sz -= (_buf[0]->numel + _buf[1]->numel) * sizeof(DU);
+        _mmu->free(*_buf[0]);
+        _mmu->free(*_buf[1]);
+        _buf[0] = _buf[1] = NULL;
+        return sz;
+    }
+    if (numel < 3) return 0;                          /// * no layer yet
+    for (U16 i = 2; i < numel; i++) {                 ///< layer outputs only
+        Tensor &t = (*this)[i];
+        if (t.numel > mx) mx = t.numel;
+        sz += t.numel * sizeof(DU);
+    }
+    DU *b0 = _buf[0] ? _buf[0]->data : NULL;          ///< current buffers, if any
+    DU *b1 = _buf[1] ? _buf[1]->data : NULL;
+    if (!_buf[0] || mx > _buf[0]->numel) {            /// * first time or grown by add
+        if (_buf[0]) {
+            _mmu->free(*_buf[0]);
+            _mmu->free(*_buf[1]);
+        }
+        _buf[0] = &_mmu->tensor(mx);
+        _buf[1] = &_mmu->tensor(mx);
+    }
+    else mx = _buf[0]->numel;
+    for (U16 i = 2; i < numel; i++) {                 /// * alternate buffers
+        Tensor &t = (*this)[i];
+        if (t.data != b0 && t.data != b1) _mmu->dfree(t.data);  /// * private block only
+        t.data = _buf[i & 1]->data;
+    }
+    return sz - mx * 2 * sizeof(DU);
+}
 
 #endif  // (T4_ENABLE_OBJ && T4_ENABLE_NN)
 //==========================================================================
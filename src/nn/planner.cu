@@ -0,0 +1,215 @@
+/** -*- c++ -*-
+ * @file
+ * @brief Model class - activation memory planner implementation
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "model.h"
+#if (T4_ENABLE_OBJ && T4_ENABLE_NN)
+///
+/// Timeline of a model with L layers (tensor j is input of layer j)
+///   forward  step k at t = k            (reads j=k,   writes j=k+1)
+///   loss            at t = L + 1        (tensor L+1)
+///   backprop step k at t = 2L + 2 - k   (reads j=k+1, writes dX into j=k)
+/// A tensor lives [j-1, j] in forward and [2L+2-j, 2L+3-j] in backprop,
+/// or [j-1, 2L+3-j] when its layer needs X (conv, linear, max/min pool)
+/// the output of a fused conv2d block (head j-3) is written at t = j-3
+///
+typedef struct {
+    U16 j;                 ///< tensor (layer) index
+    U16 ph;                ///< phase 0=forward, 1=backprop
+    S16 t0, t1;            ///< live interval [t0, t1]
+    U64 sz;                ///< number of elements
+    int slot;              ///< assigned arena slot
+} t4_live;
+
+#define IS_RELU(fn)  ((fn)==L_RELU || (fn)==L_LEAKYRL || (fn)==L_ELU || (fn)==L_SELU)
+#define IS_MPOOL(fn) ((fn)==L_MAXPOOL || (fn)==L_MINPOOL)
+#define IN_FUSE(j)   ((*this)[(j) - 1].fuse || ((j) > 2 && (*this)[(j) - 2].fuse))
+///
+/// backprop of relu family from X (recompute checkpoint, no mask)
+///
+__KERN__ void k_dactivate_x(
+    t4_layer op, DU *I, DU *O,             ///< func, input X => dX, output dY
+    DU alpha, int numel                    ///< number of tensor elements
+    ) {
+    const int k = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+
+    if (k < numel) {
+        DU x = I[k], f = DU1;                              ///< derivative
+        if (x <= DU0) {
+            switch (op) {
+            case L_RELU:    f = DU0;               break;
+            case L_LEAKYRL: f = alpha;             break;
+            case L_ELU:     f = alpha * EXP(x);    break;
+            case L_SELU:    f = SELU_LA * EXP(x);  break;
+            }
+        }
+        else if (op == L_SELU) f = SELU_L;
+        I[k] = f * O[k];                                   /// * dX = f'(X) * dY
+    }
+}
+///
+///> activation memory planner
+///  @brief - mode 0: private storage per layer (default)
+///           mode 1: liveness based arena slots
+///           mode 2: + relu checkpoints (mask recomputed from X in backprop)
+///
+__GPU__ Model&
+Model::plan(int mode) {
+    if (_infer) { ERROR("Model::plan not in inference mode\n"); return *this; }
+    if (_plan) _unplan(true);                    /// * restore private storage
+    if (!mode || numel < 3) return *this;
+
+    const int L = numel - 2;                     ///< number of layers
+    t4_live *lv = new t4_live[L * 2];            ///< live intervals
+    int     n   = 0;
+    U64     sz0 = 0;                             ///< storage before
+    for (U16 j = 2; j <= L + 1; j++) {
+        Tensor &t = (*this)[j];
+        S16    t0 = (j > 3 && (*this)[j - 3].fuse)  ///< fused block writes at its head
+            ? j - 3 : j - 1;
+        sz0 += t.numel;
+        if (j == L + 1 || _keepx(j, mode)) {
+            lv[n++] = { j, 0, t0, (S16)(2*L + 3 - j), t.numel, -1 };
+            continue;
+        }
+        lv[n++] = { j, 0, t0,                 (S16)j,             t.numel, -1 };
+        lv[n++] = { j, 1, (S16)(2*L + 2 - j), (S16)(2*L + 3 - j), t.numel, -1 };
+    }
+    for (int i = 1; i < n; i++) {                /// * sort by start time
+        t4_live v = lv[i];
+        int k = i - 1;
+        for (; k >= 0 && lv[k].t0 > v.t0; k--) lv[k + 1] = lv[k];
+        lv[k + 1] = v;
+    }
+    ///
+    /// greedy interval coloring, best-fit by size
+    ///
+    S16 *end = new S16[n];                       ///< slot busy until
+    U64 *ssz = new U64[n];                       ///< slot size
+    int ns   = 0;                                ///< number of slots
+    for (int i = 0; i < n; i++) {
+        int fit = -1, big = -1;
+        for (int s = 0; s < ns; s++) {
+            if (end[s] >= lv[i].t0) continue;    /// * still in use
+            if (ssz[s] >= lv[i].sz && (fit < 0 || ssz[s] < ssz[fit])) fit = s;
+            if (big < 0 || ssz[s] > ssz[big]) big = s;
+        }
+        int s = fit >= 0 ? fit : big;            ///< grow largest free slot
+        if (s < 0) { s = ns++; ssz[s] = 0; }     /// * or open a new one
+        if (ssz[s] < lv[i].sz) ssz[s] = lv[i].sz;
+        end[s]     = lv[i].t1;
+        lv[i].slot = s;
+    }
+    ///
+    /// allocate arena slots, release private storage
+    ///
+    U64 sz1 = 0;                                 ///< storage after
+    _slot = &_mmu->tensor(ns);                   ///< slot handles
+    _plan = &_mmu->tensor((U64)numel * 2);       ///< [fwd,bwd] slot per tensor
+    for (int s = 0; s < ns; s++) {
+        _slot->data[s] = T4Base::obj2du(_mmu->tensor(ssz[s]));
+        sz1 += ssz[s];
+    }
+    for (int i = 0; i < n; i++) {                /// * sorted, forward comes first
+        DU *p = &_plan->data[lv[i].j * 2];
+        p[1] = I2D(lv[i].slot);                  /// * continuous unless split
+        if (lv[i].ph == 0) p[0] = p[1];
+    }
+    for (U16 j = 2; j <= L + 1; j++) _mmu->dfree((*this)[j].data);
+    U64 msk = 0;                                 ///< masks dropped by checkpoints
+    for (U16 j = 1; mode > 1 && j <= L; j++) {
+        Tensor &in = (*this)[j];
+        if (!IS_RELU(in.grad_fn) || !in.grad[0] || IN_FUSE(j)) continue;
+        msk += in.grad[0]->numel;
+        _mmu->free(*in.grad[0]);
+        in.grad[0] = NULL;
+    }
+    _bind(0);
+
+    delete[] ssz;
+    delete[] end;
+    delete[] lv;
+
+    INFO("Model::plan activations %ld => %ld bytes in %d slots, masks -%ld bytes\n",
+         sz0 * sizeof(DU), sz1 * sizeof(DU), ns, msk * sizeof(DU));
+    return *this;
+}
+///
+/// release arena slots, optionally restore private storage and masks
+///
+__GPU__ void
+Model::_unplan(bool restore) {
+    for (U16 j = 2; j < numel; j++) {
+        Tensor &t = (*this)[j];
+        t.data = restore ? _mmu->dalloc(t.numel) : NULL;
+    }
+    for (U16 j = 1; restore && j < numel - 1; j++) {
+        Tensor &in = (*this)[j];
+        if (IS_RELU(in.grad_fn)) _igrad(in, true);   /// * mask back
+    }
+    for (int s = 0; s < _slot->numel; s++) {
+        _mmu->free((Tensor&)T4Base::du2obj(_slot->data[s]));
+    }
+    _mmu->free(*_slot);
+    _mmu->free(*_plan);
+    _slot = _plan = NULL;
+}
+///
+/// point layer outputs to their arena slots for a phase (0=forward, 1=backprop)
+///
+__GPU__ void
+Model::_bind(int ph) {
+    if (!_plan) return;
+    for (U16 j = 2; j < numel; j++) {
+        int    s = INT(_plan->data[j * 2 + ph]);
+        Tensor &a = (Tensor&)T4Base::du2obj(_slot->data[s]);
+        (*this)[j].data = a.data;
+    }
+}
+///
+/// whether tensor j must keep its forward value until backprop step j
+///
+__GPU__ bool
+Model::_keepx(U16 j, int mode) {
+    t4_layer fn = (*this)[j].grad_fn;
+    switch (fn) {
+    case L_MAXPOOL:
+    case L_MINPOOL:
+        if (IN_FUSE(j)) return false;            /// * argmax kept by fused forward
+        /* fall through */
+    case L_CONV:
+    case L_LINEAR:  return true;                 /// * dW or argmax need X
+    case L_RELU:
+    case L_LEAKYRL:
+    case L_ELU:
+    case L_SELU:
+        if (mode < 2 || IN_FUSE(j)) return false;/// * mask kept
+        return !IS_MPOOL((*this)[j - 1].grad_fn);/// * X recomputed by pooling
+    default: return false;
+    }
+}
+///
+/// recompute checkpoint: regenerate X of layer j from max/min pool input
+///
+__GPU__ void
+Model::_recompute(U16 j) {
+    Tensor &in = (*this)[j], &px = (*this)[j - 1];
+    if (!_plan || in.grad[0] || !IS_RELU(in.grad_fn)) return;
+    if (IS_MPOOL(px.grad_fn)) _fpool(px, in, px.grad_fn);
+}
+
+__GPU__ int
+Model::_bactivate_x(Tensor &in, Tensor &out) {
+    dim3 blk(T4_WARP_SQ, 1, 1);                  ///< default blocks
+    dim3 grd((in.numel + blk.x - 1) / blk.x, 1, 1);
+
+    k_dactivate_x<<<grd, blk>>>(
+        in.grad_fn, in.data, out.data, 0.001 * in.parm, in.numel);
+    GPU_SYNC();
+
+    return 0;
+}
+#endif  // (T4_ENABLE_OBJ && T4_ENABLE_NN)
+//==========================================================================
@@ -0,0 +1,299 @@
+/** -*- c++ -*-
+ * @file
+ * @brief Model class - INT8 post-training quantization and inference implementation
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "model.h"
+#if (T4_ENABLE_OBJ && T4_ENABLE_NN)
+#include "dataset.h"
+
+#define Q8_MAX   ((DU)127.0)               /** symmetric INT8 range          */
+#define Q8(t)    ((S8*)(t)->data)          /** INT8 view of a tensor storage */
+///
+/// quantize F32 weights into INT8 with per-output-channel scales
+/// Note: linear w[C0,C1] rows are zero padded to C4 for 4-byte dot products
+///       conv   f[C1,KS,KS,C0] keeps its layout (channel = i % C0)
+///
+__KERN__ void k_qweight(
+    DU *W, S8 *Q, DU *S,                   ///< F32 weights, INT8 weights, scales
+    int C0, int C1, int C4,                ///< output channels, row size, padded row size
+    bool lin, int numel                    ///< linear layout, number of INT8 elements
+    ) {
+    const int i = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+
+    if (i < numel) {
+        if (lin) {
+            const int c0 = i / C4, c1 = i % C4;
+            Q[i] = c1 < C1 ? (S8)D2I(W[c1 + c0 * C1] / S[c0]) : 0;
+        }
+        else Q[i] = (S8)D2I(W[i] / S[i % C0]);
+    }
+}
+///
+/// absolute max of a tensor (non-negative floats compare as ints)
+///
+__KERN__ void k_absmax(DU *I, DU *mx, int numel) {
+    const int i = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+
+    if (i < numel) atomicMax((int*)mx, __float_as_int(ABS(I[i])));
+}
+///
+/// quantize activations with a per-tensor scale (rows padded from C1 to C4)
+///
+__KERN__ void k_qinput(
+    DU *I, S8 *Q, DU rs,                   ///< F32 input, INT8 output, 1/scale
+    int C1, int C4, int numel              ///< row size, padded row size, N * C4
+    ) {
+    const int i = threadIdx.x + blockIdx.x * blockDim.x;   ///< element index
+
+    if (i < numel) {
+        const int n = i / C4, c = i % C4;
+        Q[i] = c < C1 ? (S8)D2I(I[c + n * C1] * rs) : 0;
+    }
+}
+///
+/// INT8 dense layer, 4-way byte dot product with INT32 accumulation
+///
+__KERN__ void k_qlinear(
+    S8 *I, S8 *W, DU *S, DU *B, DU *O,     ///< INT8 input, weight, F32 scales, bias, output
+    DU sx, int C4, int C0, int HWC0        ///< input scale, padded C1, output channels
+    ) {
+    const int c0 = threadIdx.x + blockIdx.x * blockDim.x;  ///< output channel
+    const int n  = blockIdx.y;                             ///< batch index
+
+    if (c0 < C0) {
+        const int *w = (const int*)&W[c0 * C4];
+        const int *x = (const int*)&I[n * C4];
+        int acc = 0;                                       ///< INT32 accumulator
+        for (int k = 0; k < C4 / 4; k++) {
+            acc = __dp4a(w[k], x[k], acc);                 /// * acc += 4 x (S8 * S8)
+        }
+        O[c0 + n * HWC0] = acc * S[c0] * sx + B[c0];       /// * dequantize, Y = WX + B
+    }
+}
+///
+/// INT8 convolution filter (same tiling as k_conv2d)
+///
+template<int TS, int KS>         ///> tile size, kernel size
+__KERN__ void k_qconv2d(
+    S8 *I, S8 *F, DU *S, DU *B, DU *O, ///> INT8 input, filter, F32 scales, bias, output
+    DU sx, int H, int W, int C1        ///< input scale, (H0==H1, W0==W1), input channels
+    ) {
+    __shared__ S8 _I[T4_WARP_SQ];                    ///< shared memory [16x16]
+
+    const int tx = threadIdx.x, j0 = tx + blockIdx.x * TS;   ///< output coordinates
+    const int ty = threadIdx.y, i0 = ty + blockIdx.y * TS;
+    const int c0 = blockIdx.z,  C0 = gridDim.z;      ///< channel deep
+    const int z0 = c0 + (j0 + i0 * W) * C0;          ///< output array index
+    const int xy = tx + ty * T4_WARP_SZ;             ///< tile index
+    const int i1 = i0 - INT(KS / 2);                 ///< input coordinates
+    const int j1 = j0 - INT(KS / 2);
+
+    auto g = cg::this_thread_block();                ///< all threads of block
+    int acc = 0;                                     ///< INT32 accumulator
+    for (int c1 = 0; c1 < C1; c1++) {                ///< each input channel
+        const int z1 = c1 + (j1 + i1 * W) * C1;
+        _I[xy] =                                     /// * cache input data
+            (i1 >= 0 && i1 < H && j1 >= 0 && j1 < W) /// * with zero padding
+            ? I[z1] : 0;
+        g.sync();                                    /// * smem write barrier
+
+        const int zf = c0 + c1 * KS * KS * C0;       ///< filter index [C1,KS,KS,C0]
+        if (tx < TS && ty < TS) {                    /// * each tile
+            S8 *fx = &F[zf], *ix = &_I[xy];
+            #pragma unroll
+            for (int y = 0; y < KS; y++) {           /// * process one KS * KS cell
+                for (int x = 0; x < KS; x++) {
+                    acc += (int)(*fx) * ix[x];       /// Y += W * X
+                    fx  += C0;
+                }
+                ix += T4_WARP_SZ;                    /// next row of tile
+            }
+        }
+        g.sync();
+    }
+    if (tx < TS && ty < TS && i0 < H && j0 < W) {
+        O[z0] = acc * S[c0] * sx + B[c0];            /// * dequantize with bias
+    }
+}
+///
+///> post-training quantization
+///  @brief - keep F32 weights (for comparison), add INT8 copies, freeze model
+///
+__GPU__ Model&
+Model::quantize() {
+    TRACE1("\nModel::quantize starts");
+    for (U16 i = 1; i < numel - 1; i++) {
+        Tensor &in = (*this)[i];
+        switch (in.grad_fn) {
+        case L_CONV:
+        case L_LINEAR: _qweight(in); break;
+        }
+    }
+    train = 0;                                   /// * frozen weights
+    TRACE1("\nModel::quantize done\n");
+    return *this;
+}
+///
+///> inference-only forward pass, INT8 for quantized conv/linear layers
+///
+__GPU__ Model&
+Model::predict(Tensor &input) {
+    Tensor &n1 = (*this)[1];  ///< reference model input layer
+    if (input.numel != n1.numel) {
+        ERROR("Model::predict dataset wrong shape[%d,%d,%d,%d] != model input[[%d,%d,%d,%d]\n",
+            input.N(), input.H(), input.W(), input.C(),
+            n1.N(), n1.H(), n1.W(), n1.C());
+        return *this;
+    }
+    n1 = input;               /// * copy dataset batch into the first layer
+    _bind(0);                 /// * planned arena slots for forward
+
+    TRACE1("\nModel::predict starts");
+    DU t0 = _mmu->ms();                          ///< performance measurement
+    for (U16 i = 1; i < numel - 1; i++) {
+        _qstep((*this)[i], (*this)[i + 1]);
+    }
+    if (input.is_dataset()) {
+        _lbl = ((Dataset&)input).label;          /// * labels, no one-hot vector
+        _hit = hit(true);                        /// * recalc/cache hit count
+    }
+    TRACE1("\nModel::predict %5.2f ms\n", _mmu->ms() - t0);
+
+    return *this;
+}
+/// ========================================================================
+/// private methods
+///
+__GPU__ void
+Model::_qweight(Tensor &in) {
+    Tensor &w  = *in.grad[0];                    ///< F32 weight/filter tensor
+    bool   lin = in.grad_fn == L_LINEAR;
+    const int C0 = lin ? w.H() : w.C();          ///< output channels
+    const int C1 = lin ? w.W() : w.numel / C0;   ///< weights per channel
+    const int C4 = lin ? ALIGN4(C1) : C1;        ///< padded row size
+    const int sz = C0 * C4;                      ///< number of INT8 weights
+
+    if (in.qnt[0]) {                             /// * requantize
+        _mmu->free(*in.qnt[0]);
+        _mmu->free(*in.qnt[1]);
+    }
+    Tensor &q = *(in.qnt[0] = &_mmu->tensor((sz + 3) / 4));   ///< packed INT8
+    Tensor &s = *(in.qnt[1] = &_vec(C0));                     ///< scales
+    DU     *d = w.data;
+    for (int c0 = 0; c0 < C0; c0++) {            /// * absmax per output channel
+        DU mx = DU0;
+        for (int k = 0; k < C1; k++) {
+            DU v = lin ? d[k + c0 * C1] : d[c0 + k * C0];
+            mx = MAX(ABS(v), mx);
+        }
+        s.data[c0] = mx > DU_EPS ? mx / Q8_MAX : DU1;
+    }
+    dim3 blk(T4_WARP_SQ, 1, 1);                  ///< default blocks
+    dim3 grd((sz + blk.x - 1) / blk.x, 1, 1);
+
+    k_qweight<<<grd, blk>>>(d, Q8(&q), s.data, C0, C1, C4, lin, sz);
+    GPU_SYNC();
+
+    TRACE1("\n  %s w[%d,%d] => int8[%d,%d]", d_nname(in.grad_fn), C0, C1, C0, C4);
+}
+
+__GPU__ void
+Model::_qstep(Tensor &in, Tensor &out) {
+    switch (in.grad_fn) {
+    case L_CONV:    if (in.qnt[0]) _qconv(in, out);   else _fstep(in, out); break;
+    case L_LINEAR:  if (in.qnt[0]) _qlinear(in, out); else _fstep(in, out); break;
+    case L_DROPOUT: out = in;                         break;  ///< identity in inference
+    default:        _fstep(in, out);
+    }
+}
+///
+///> quantize input activations into q, return dequantize scale
+///
+__GPU__ DU
+Model::_qinput(Tensor &in, Tensor &q, int C1, int C4) {
+    DU *mx = q.data; *mx = DU0;                  ///< per call, q storage as scratch
+
+    dim3 blk(T4_WARP_SQ, 1, 1);                  ///< default blocks
+    dim3 g1((in.numel + blk.x - 1) / blk.x, 1, 1);
+    k_absmax<<<g1, blk>>>(in.data, mx, in.numel);
+    GPU_SYNC();
+
+    DU  sx = *mx > DU_EPS ? *mx / Q8_MAX : DU1;  ///< input scale (before k_qinput overwrites)
+    int sz = in.N() * C4;                        ///< number of INT8 inputs
+    dim3 g2((sz + blk.x - 1) / blk.x, 1, 1);
+    k_qinput<<<g2, blk>>>(in.data, Q8(&q), RCP(sx), C1, C4, sz);
+    GPU_SYNC();
+
+    return sx;
+}
+
+#define TILE1    (T4_WARP_SZ)              /** 16, 1x1 conv */
+#define TILE3    (T4_WARP_SZ - 3 + 1)      /** 14, 3x3 conv */
+#define TILE5    (T4_WARP_SZ - 5 + 1)      /** 12, 5x5 conv */
+
+__GPU__ int
+Model::_qconv(Tensor &in, Tensor &out) {
+    Tensor &tf = *in.grad[0];                             ///< F32 filter (for shape)
+    Tensor &tb = *in.grad[1];                             ///< bias tensor
+
+    const int N = out.N(), H = out.H(), W = out.W();      ///< outpt dimensions
+    const int C0 = out.C(), C1 = in.C();                  ///< output, input channel deep
+    const int HWC = in.HWC();                             ///< input sample size
+
+    Tensor &q  = _mmu->tensor(((U64)N * HWC + 3) / 4);    ///< INT8 input
+    DU     sx  = _qinput(in, q, HWC, HWC);                ///< per-tensor input scale
+    S8     *f  = Q8(in.qnt[0]);
+    DU     *s  = in.qnt[1]->data, *b = tb.data;
+
+    dim3 blk(T4_WARP_SZ, T4_WARP_SZ, 1);                  ///< default blocks
+    dim3 g1((W + TILE1 - 1) / TILE1, (H + TILE1 - 1) / TILE1, C0);
+    dim3 g3((W + TILE3 - 1) / TILE3, (H + TILE3 - 1) / TILE3, C0);
+    dim3 g5((W + TILE5 - 1) / TILE5, (H + TILE5 - 1) / TILE5, C0);
+
+    int rst = 0;
+    for (int n = 0; n < N && !rst; n++) {
+        S8 *d1 = Q8(&q) + (U64)n * HWC;
+        DU *d0 = out.slice(n);
+        switch(tf.H()) {
+        case 1: k_qconv2d<TILE1,1><<<g1,blk>>>(d1, f, s, b, d0, sx, H, W, C1); break;
+        case 3: k_qconv2d<TILE3,3><<<g3,blk>>>(d1, f, s, b, d0, sx, H, W, C1); break;
+        case 5: k_qconv2d<TILE5,5><<<g5,blk>>>(d1, f, s, b, d0, sx, H, W, C1); break;
+        default:
+            ERROR("model_qnt#conv kernel_size=%d not supported\n", tf.H());
+            rst = -1;
+        }
+    }
+    GPU_SYNC();
+    _mmu->free(q);                                        /// * release INT8 input
+
+    return rst;
+}
+
+__GPU__ int
+Model::_qlinear(Tensor &in, Tensor &out) {
+    Tensor &tw = *in.grad[0];                             ///< F32 weight (for shape)
+    Tensor &tb = *in.grad[1];                             ///< bias tensor
+
+    const int N  = out.N();                               ///< batch size
+    const int C0 = tw.H(), C1 = tw.W(), C4 = ALIGN4(C1);  ///< dense layer dims
+
+    Tensor &q  = _mmu->tensor(((U64)N * C4 + 3) / 4);     ///< INT8 input
+    DU     sx  = _qinput(in, q, C1, C4);                  ///< per-tensor input scale
+
+    TRACE1(" = q8[%d,%d] @ in[%d,%d] + b[%d]", C0, C4, N, C1, tb.numel);
+
+    dim3 blk(T4_WARP_SQ, 1, 1);                           ///< default blocks
+    dim3 grd((C0 + blk.x - 1) / blk.x, N, 1);
+
+    k_qlinear<<<grd, blk>>>(
+        Q8(&q), Q8(in.qnt[0]), in.qnt[1]->data, tb.data, out.data,
+        sx, C4, C0, out.HWC());
+    GPU_SYNC();
+    _mmu->free(q);                                        /// * release INT8 input
+
+    return 0;
+}
+#endif  // (T4_ENABLE_OBJ && T4_ENABLE_NN)
+//==========================================================================
@@ -11,6 +11,7 @@ struct Options {
     int   verbose         = 0;
     int   device_id       = 0;
     bool  help            = false;
+    bool  resident        = false;         ///< keep VMs in a persistent kernel
     float problem_size[3] = {1024, 512, 2048};
     float alpha           = 1.0;
     float beta            = 0.0;
@@ -35,9 +36,10 @@ struct Options {
         };
         */
         char opt;
-        while ((opt = getopt(argc, argv, "hv:d:y:x:k:n:i:a:b:")) != -1) {
+        while ((opt = getopt(argc, argv, "hpv:d:y:x:k:n:i:a:b:")) != -1) {
             switch (opt) {
             case 'h': help      = true;         break;
+            case 'p': resident  = true;         break;
             case 'v': verbose   = atoi(optarg); break;
             case 'd': device_id = atoi(optarg); break;
             case 'y': problem_size[0] = atoi(optarg); break;
@@ -180,10 +182,12 @@ struct Options {
             << "Options:\n"
             << "  -h        list all GPUs and this usage statement.\n"
             << "  -d <int>  GPU device id\n"
+            << "  -p        keep VMs resident, lines fed thru a command ring (no tensor words)\n"
             << "  -v <int>  Verbosity level, 0: default, 1: mmu debug, 2: more details\n\n"
             << "Examples:\n"
             << "$ ./tests/ten4 -h    ;# display help\n"
             << "$ ./tests/ten4 -d 0  ;# use device 0\n"
+            << "$ ./tests/ten4 -p    ;# persistent VMs, no sync per line\n"
             << "$ ./tests/ten4 -v 1  ;# set verbosity to level 1\n";
         return out;
     }
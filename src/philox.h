@@ -0,0 +1,151 @@
+/** -*- c++ -*-
+ * @file
+ * @brief Philox4x32-10 counter-based random number generator
+ *
+ * Stateless, keyed by (seed, stream, element index), so a fill gives the
+ * same numbers regardless of launch geometry. Only IEEE round-to-nearest
+ * operations are used, so host and device results are bit-identical
+ * provided the host compiler does not fuse multiply-adds (-ffp-contract=off,
+ * set in NVCC_FLAGS).
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#ifndef __PHILOX_H
+#define __PHILOX_H
+#include "ten4_types.h"
+
+#define PHILOX_M0   0xD2511F53U            /**< round multipliers      */
+#define PHILOX_M1   0xCD9E8D57U
+#define PHILOX_W0   0x9E3779B9U            /**< Weyl key increments    */
+#define PHILOX_W1   0xBB67AE85U
+///
+///@name round-to-nearest float ops (no FMA contraction on device)
+///@{
+#if defined(__CUDA_ARCH__)
+#define RN_ADD(a,b) __fadd_rn(a,b)
+#define RN_MUL(a,b) __fmul_rn(a,b)
+#define RN_DIV(a,b) __fdiv_rn(a,b)
+#define RN_SQRT(a)  __fsqrt_rn(a)
+#else  // host
+#define RN_ADD(a,b) ((F32)(a) + (F32)(b))
+#define RN_MUL(a,b) ((F32)(a) * (F32)(b))
+#define RN_DIV(a,b) ((F32)(a) / (F32)(b))
+#define RN_SQRT(a)  sqrtf(a)
+#endif // defined(__CUDA_ARCH__)
+///@}
+typedef struct { U32 x[4]; } philox4;      ///< counter or output block
+
+__BOTH__ __INLINE__ U32
+_mulhilo(U32 a, U32 b, U32 &hi) {
+    U64 p = (U64)a * b;                    /// * exact on both sides
+    hi = (U32)(p >> 32);
+    return (U32)p;
+}
+///
+/// 10 rounds of Philox4x32 on counter c with key (k0, k1)
+///
+__BOTH__ __INLINE__ philox4
+philox(philox4 c, U32 k0, U32 k1) {
+    #pragma unroll
+    for (int r = 0; r < 10; r++) {
+        U32 h0, h1;
+        U32 l0 = _mulhilo(PHILOX_M0, c.x[0], h0);
+        U32 l1 = _mulhilo(PHILOX_M1, c.x[2], h1);
+        c = {{ h1 ^ c.x[1] ^ k0, l1, h0 ^ c.x[3] ^ k1, l0 }};
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    return c;
+}
+///
+/// uniform in (0, 1], 24-bit resolution (exact conversion)
+///
+__BOTH__ __INLINE__ F32
+philox_u01(U32 v) {
+    return (F32)((v >> 8) + 1) * (1.0f / 16777216.0f);
+}
+///
+/// ln(u) for u in (0, 1], exponent split + atanh series
+///
+__BOTH__ __INLINE__ F32
+_philox_log(F32 u) {
+    union { F32 f; U32 i; } b = { u };
+    int e = (int)((b.i >> 23) & 0xff) - 127;            ///< unbiased exponent
+    b.i   = (b.i & 0x7fffff) | 0x3f800000;              ///< mantissa in [1, 2)
+    F32 s = RN_DIV(RN_ADD(b.f, -1.0f), RN_ADD(b.f, 1.0f));
+    F32 s2 = RN_MUL(s, s);
+    F32 p  = 1.0f / 13.0f;                              /// * 2*atanh(s) = ln(m)
+    p = RN_ADD(1.0f / 11.0f, RN_MUL(p, s2));
+    p = RN_ADD(1.0f / 9.0f,  RN_MUL(p, s2));
+    p = RN_ADD(1.0f / 7.0f,  RN_MUL(p, s2));
+    p = RN_ADD(1.0f / 5.0f,  RN_MUL(p, s2));
+    p = RN_ADD(1.0f / 3.0f,  RN_MUL(p, s2));
+    p = RN_ADD(1.0f,         RN_MUL(p, s2));
+    return RN_ADD(RN_MUL((F32)e, 0.69314718f), RN_MUL(2.0f, RN_MUL(s, p)));
+}
+///
+/// sin and cos of 2*pi*v for v in [0, 1), quadrant split + Taylor
+///
+__BOTH__ __INLINE__ void
+_philox_sincos(F32 v, F32 &sn, F32 &cs) {
+    F32 q = RN_MUL(v, 4.0f);
+    int k = (int)q;                                     ///< quadrant
+    F32 t = RN_MUL(RN_ADD(q, -(F32)k), 1.57079633f);    ///< [0, pi/2)
+    F32 t2 = RN_MUL(t, t);
+    F32 s = -1.0f / 39916800.0f, c = 1.0f / 479001600.0f;
+    s = RN_ADD( 1.0f / 362880.0f, RN_MUL(s, t2));
+    s = RN_ADD(-1.0f / 5040.0f,   RN_MUL(s, t2));
+    s = RN_ADD( 1.0f / 120.0f,    RN_MUL(s, t2));
+    s = RN_ADD(-1.0f / 6.0f,      RN_MUL(s, t2));
+    s = RN_MUL(t, RN_ADD(1.0f,    RN_MUL(s, t2)));
+    c = RN_ADD(-1.0f / 3628800.0f, RN_MUL(c, t2));
+    c = RN_ADD( 1.0f / 40320.0f,  RN_MUL(c, t2));
+    c = RN_ADD(-1.0f / 720.0f,    RN_MUL(c, t2));
+    c = RN_ADD( 1.0f / 24.0f,     RN_MUL(c, t2));
+    c = RN_ADD(-0.5f,             RN_MUL(c, t2));
+    c = RN_ADD( 1.0f,             RN_MUL(c, t2));
+    switch (k & 3) {
+    case 0: sn =  s; cs =  c; break;
+    case 1: sn =  c; cs = -s; break;
+    case 2: sn = -s; cs = -c; break;
+    case 3: sn = -c; cs =  s; break;
+    }
+}
+///
+/// fill elements [4i, 4i+4) of d (sz elements) from block i of a stream
+///   normal pairs by Box-Muller
+///
+__BOTH__ __INLINE__ void
+philox_fill4(
+    DU *d, U64 sz, U64 i,                  ///< data, numel, block index
+    U64 seed, U32 stream,                  ///< key, call counter
+    rand_opt ntype, DU bias, DU scale) {
+    philox4 c = {{ (U32)i, (U32)(i >> 32), stream, 0 }};
+    philox4 r = philox(c, (U32)seed, (U32)(seed >> 32));
+    F32 v[4];
+    for (int k = 0; k < 4; k++) v[k] = philox_u01(r.x[k]);
+    if (ntype == NORMAL) {
+        for (int k = 0; k < 4; k += 2) {
+            F32 m = RN_SQRT(RN_MUL(-2.0f, _philox_log(v[k])));
+            F32 sn, cs;
+            _philox_sincos(RN_ADD(v[k + 1], -(1.0f / 16777216.0f)), sn, cs);
+            v[k]     = RN_MUL(m, cs);
+            v[k + 1] = RN_MUL(m, sn);
+        }
+    }
+    U64 x = i * 4;
+    for (int k = 0; k < 4 && x + k < sz; k++) {
+        d[x + k] = RN_MUL((F32)scale, RN_ADD((F32)bias, v[k]));
+    }
+}
+///
+/// host reference fill, bit-identical to System::rand on device
+///
+__HOST__ __INLINE__ void
+philox_fill(DU *d, U64 sz, U64 seed, U32 stream,
+            rand_opt ntype, DU bias=DU0, DU scale=DU1) {
+    for (U64 i = 0; i < (sz + 3) / 4; i++) {
+        philox_fill4(d, sz, i, seed, stream, ntype, bias, scale);
+    }
+}
+#endif // __PHILOX_H
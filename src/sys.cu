@@ -9,49 +9,30 @@
 
 System *_sys = NULL;
 ///
-/// random number generator setup
-/// Note: kept here because curandStates stays in CUDA memory
+/// random number generator, one thread per 4 elements
+/// Note: stateless Philox, result is independent of launch geometry
 ///
 __KERN__ void
-k_rand_init(curandState *st, U64 seed) {
-    int x = threadIdx.x + blockIdx.x * blockDim.x;
-    curand_init(seed, x, 0, &st[x]);
-}
-
-__KERN__ void
-k_rand(DU *mat, int sz, DU bias, DU scale, curandState *st, rand_opt ntype) {
-    int tx = threadIdx.x;             ///< thread idx
-    int n  = (sz / blockDim.x) + 1;   ///< loop counter
+k_rand(DU *mat, U64 sz, DU bias, DU scale, U64 seed, U32 stream, rand_opt ntype) {
+    U64 i = threadIdx.x + (U64)blockIdx.x * blockDim.x;  ///< block of 4 elements
     
-    curandState s = st[tx];           /// * cache state into local register
-    for (int i=0, x=tx; i<n; i++, x+=blockDim.x) {  /// * scroll through pages
-        if (x < sz) {
-            mat[x]= scale * (
-                bias + (ntype==NORMAL ? curand_normal(&s) : curand_uniform(&s))
-                );
-        }
-    }
-    st[tx] = s;                      /// * copy state back to global memory
+    if (i * 4 < sz) philox_fill4(mat, sz, i, seed, stream, ntype, bias, scale);
 }
 ///
 /// Forth Virtual Machine operational macros to reduce verbosity
 ///
 __HOST__
 System::System(h_istr &i, h_ostr &o, int khz, int verbo)
-    : _khz(khz), _istr(new Istream()), _ostr(new Ostream()), _trace(verbo) {
+    : _khz(khz), _istr(new Istream(T4_ICHUNK_SZ)), _ostr(new Ostream()), _trace(verbo) {
     mu = MMU::get_mmu();             ///> instantiate memory manager
     io = AIO::get_io(i, o, verbo);   ///> instantiate async IO manager
     db = Debug::get_db(mu, io);      ///> tracing instrumentation
+    MM_ALLOC(&_lit, T4_IBUF_SZ / 2 * sizeof(DU)); ///> literal staging, one per 2 chars max
         
 #if (T4_ENABLE_OBJ && T4_ENABLE_NN)
     Loader::init(verbo);
 #endif
-    ///
-    ///> setup randomizer
-    ///
-    MM_ALLOC(&_seed, sizeof(curandState) * T4_RAND_SZ);
-    k_rand_init<<<1, T4_RAND_SZ>>>(_seed, time(NULL));  /// serialized randomizer
-    GPU_CHK();
+    seed(time(NULL));                ///> setup randomizer
     
     INFO("\\ System OK\n");
 }
@@ -60,7 +41,7 @@ __HOST__
 System::~System() {
     GPU_SYNC();
     
-    MM_FREE(_seed);
+    MM_FREE(_lit);
     AIO::free_io();
     Debug::free_db();
     MMU::free_mmu();
@@ -77,7 +58,11 @@ __HOST__ void    System::free_sys() { if (_sys) delete _sys; }
 
 __GPU__ DU
 System::rand(DU d, rand_opt n) {
-    if (!IS_OBJ(d)) return d * curand_uniform(&_seed[threadIdx.x]);
+    if (!IS_OBJ(d)) {                                   /// * one number, own stream
+        DU v;
+        philox_fill4(&v, 1, 0, _seed, atomicAdd(&_rctr, 1), UNIFORM, DU0, DU1);
+        return d * v;
+    }
 #if T4_ENABLE_OBJ
     T4Base &t = mu->du2obj(d);
     rand(t.data, t.numel, n);
@@ -88,7 +73,9 @@ __GPU__ void
 System::rand(DU *d, U64 sz, rand_opt n, DU bias, DU scale) {
     DEBUG("sys#rand(T%d) numel=%ld bias=%.2f, scale=%.2f\n",
           t.rank, t.numel, bias, scale);
-    k_rand<<<1, T4_RAND_SZ>>>(d, sz, bias, scale, _seed, n);
+    U64 nb = (sz + 3) / 4;                              ///< 4 elements per thread
+    k_rand<<<(nb + T4_RAND_SZ - 1) / T4_RAND_SZ, T4_RAND_SZ>>>(
+        d, sz, bias, scale, _seed, atomicAdd(&_rctr, 1), n);
 }
 ///
 ///> feed device input stream with a line from host input
@@ -96,17 +83,30 @@ System::rand(DU *d, U64 sz, rand_opt n, DU bias, DU scale) {
 #include <string.h>
 __HOST__ int
 System::readline() {
-    _istr->clear();                          /// * clear device inpugt stream
-    char *tib = _istr->rdbuf();              ///< device input buffer
+    return readline(tib());                  /// * feed cleared device input buffer
+}
+
+__HOST__ int
+System::readline(char *tib) {
+    if (_istr->stopped()==2) io->incl_abort();  /// * error, drop included files
+    if (io->getline(tib, T4_IBUF_SZ)) return 1; /// * included files first
     io->fin.getline(tib, T4_IBUF_SZ, '\n');  /// * feed input buffer
     return !io->fin.eof();                   /// * end of file
 }
+///
+///> feed device input stream with a chunk of included files
+///
+__HOST__ int
+System::chunk() {
+    if (_istr->stopped()==2) io->incl_abort();  /// * error, drop included files
+    return io->chunk(*_istr);
+}
 
 #define NEXT_EVENT(n) ((io_event*)((char*)&ev->data[0] + ev->sz))
 
 __HOST__ io_event*
 System::process_event(io_event *ev) {
-    GPU_SYNC();                     /// * make sure data is completely written
+    if (!_resident) GPU_SYNC();     /// * make sure data is completely written
 
     char   *v    = (char*)ev->data; ///< fetch payload in buffered print node
     h_ostr &fout = io->fout;        ///< host output stream
@@ -135,6 +135,10 @@ System::process_event(io_event *ev) {
         case OP_SEE:   db->see((IU)o->i, (int)o->m);       break;
         case OP_DUMP:  db->mem_dump((IU)o->i, UINT(o->n)); break;
         case OP_SS:    db->ss_dump((IU)o->i>>10, (int)o->i&0x3ff, o->n, (int)o->m); break;
+        case OP_INCL:
+            ev = NEXT_EVENT(ev);                              ///< get file name
+            io->included((char*)ev->data, *_istr);
+            break;
 #if T4_ENABLE_OBJ // vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
         case OP_TSAVE:
             ev = NEXT_EVENT(ev);
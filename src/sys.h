@@ -6,18 +6,23 @@
  */
 #ifndef __SYS_H
 #define __SYS_H
-#include <curand_kernel.h>
 #include "debug.h"                              ///< include mmu/mmu.h, io/aio.h
+#include "philox.h"                             ///< counter-based randomizer
 ///
 ///@name System Manager Class
 ///@{
 class System : public Managed {                 ///< singleton class
     int            _khz;                        ///< GPU clock speed
-    curandState    *_seed;                      ///< for random number generator
+    U64            _seed;                       ///< random number generator key
+    U32            _rctr;                       ///< random stream counter (one per fill)
     Istream        *_istr;                      ///< managed input stream
     Ostream        *_ostr;                      ///< managed output stream
     int            _trace;
+    bool           _resident = false;           ///< VMs in a persistent kernel
     char           _pad[T4_STRBUF_SZ];          ///< terminal input buffer
+    DU             *_lit;                       ///< literals of current line parsed on host
+    int            _nlit = 0;                   ///< number of literals staged
+    int            _ilit = 0;                   ///< next literal to take
     
     __HOST__ System(h_istr &i, h_ostr &o, int khz, int verbo);
     __HOST__ ~System();
@@ -34,8 +39,16 @@ public:
     /// System functions
     ///
     __HOST__ int       readline();
+    __HOST__ int       readline(char *tib);    ///< into a host buffer
+    __HOST__ int       chunk();                ///< included files, many lines a round
+    __HOST__ char      *tib() { return _istr->clear().rdbuf(); } ///< cleared device input buffer
     __HOST__ io_event  *process_event(io_event *ev);
     __HOST__ void      flush();
+    __HOST__ void      resident(bool r) { _resident = r; } ///< no device sync in flush
+    __BOTH__ bool      is_resident()    { return _resident; }
+    __HOST__ DU        *lits(int n) {          ///< staging for n literals of a new line
+        _nlit = n; _ilit = 0; return _lit;
+    }
     __GPU__  __INLINE__ Ostream &ostr()     { return *_ostr; }
     ///
     /// debuging controls
@@ -56,6 +69,7 @@ public:
     __GPU__  DU   ms() { return static_cast<double>(clock64()) / _khz; }
     __GPU__  DU   rand(DU d, rand_opt n);                 ///< randomize a tensor
     __GPU__ void  rand(DU *d, U64 sz, rand_opt n, DU bias=DU0, DU scale=DU1);
+    __BOTH__ void seed(U64 s) { _seed = s; _rctr = 0; }   ///< restart random streams
     ///
     /// input stream handler
     ///
@@ -68,7 +82,18 @@ public:
     __GPU__  char *fetch() {                              ///< fetch next idiom
         return (*_istr >> _pad) ? _pad : NULL;
     }
-    __GPU__  void clrbuf() { _istr->clear(); }
+    __GPU__  void clrbuf() { _istr->clear(); _istr->stop(2); } ///< also aborts included
+    __GPU__  void hold()   { _istr->stop(1); }            ///< rest of input after included file
+    __GPU__  DU   *lit(int n) {                           ///< take n staged literals
+        if (n < 1 || _ilit + n > _nlit) return NULL;
+        DU *v = &_lit[_ilit]; _ilit += n; return v;
+    }
+    __GPU__  void load(const volatile char *s) {          ///< new line from host command ring
+        char *tib = _istr->clear().rdbuf();
+        int  i    = 0;
+        while (i < T4_IBUF_SZ - 1 && (tib[i] = s[i])) i++;
+        tib[i] = '\0';
+    }
     ///
     /// output methods
     ///
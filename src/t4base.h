@@ -30,11 +30,13 @@ struct T4Base : public Managed {
             U32   rank : 3;  ///< rank of tensor 2:matrix, 4:NHWC tensor
             U32   train: 1;  ///< trainable
             U32   dunit: 1;  ///< size of data element, F32=0, F64=1
-            U32   xx1  : 8;  ///< reserved 1
-            U32   nref : 16; ///< reference counter (reserved)
+            U32   fuse : 1;  ///< head of a fused layer block (NN)
+            U32   mtag : 3;  ///< allocation site tag (t4_mtag, MMU statistics)
+            U32   xx1  : 20; ///< reserved 1
             S32   parm;      ///< extra parameter storage
         };
     };
+    U32 nref = 0; ///< reference counter, own word (atomic, see ref_inc)
     DU  *data;    ///< managed memory block pointer (Note: instead of from TLSF)
     ///
     /// class contructors
@@ -62,23 +64,28 @@ struct T4Base : public Managed {
         ttype = tt;
         dunit = DUNIT;
         rank  = rnk;
+        fuse  = 0;
+        mtag  = 0;
         nref  = 1;
         parm  = 0;
         data  = NULL;
     }
     __BOTH__ __INLINE__ DU   &operator[](int i) { return data[i]; }
-    __BOTH__ __INLINE__ int  ref_inc() {
-        int r = ++nref;                     /// TODO: atomicAdd
-//        printf("nref=%d\n", r);
-        return r;
+    ///
+    /// atomic reference counting, nref is kept apart from the attr bitfields
+    /// so that a plain bitfield store cannot overwrite a concurrent update
+    ///
+    __BOTH__ __INLINE__ int  _ref_add(int d) {    ///< returns prior nref
+#if defined(__CUDA_ARCH__)
+        return (int)atomicAdd(&nref, (U32)d);
+#else  // host
+        return (int)__atomic_fetch_add(&nref, (U32)d, __ATOMIC_ACQ_REL);
+#endif // defined(__CUDA_ARCH__)
     }
-    __BOTH__ __INLINE__ int  ref_dec() {
-        if (nref > 1) {
-            int r = --nref;                 /// TODO: atomicSub
-//            printf("nref=%d\n", r);
-            return r;
-        }
-        return 0;
+    __BOTH__ __INLINE__ int  ref_inc() { return _ref_add(1) + 1; }
+    __BOTH__ __INLINE__ int  ref_dec() {          ///< 0 if the last reference
+        int r = _ref_add(-1) - 1;
+        return r > 0 ? r : 0;
     }
     __BOTH__ __INLINE__ bool is_tensor()  { return ttype == T4_TENSOR;  }
     __BOTH__ __INLINE__ bool is_model()   { return ttype == T4_MODEL;   }
@@ -12,7 +12,7 @@
  *    + 14.1 ms - 32-bit IU, nest with primitive, indirect threading (with offset)
  */
 #include <iostream>          // cin, cout
-#include <signal.h>
+#include <chrono>            // time to first prompt
 #include "ten4.h"            // wrapper
 
 using namespace std;
@@ -45,23 +45,66 @@ k_vm_done(VM_Handle *pool) {
 }
 ///
 /// check VM status (using warp-level collectives)
+/// Note: no VM is running, tasker resolves parked (WAIT) VMs here
 ///
-
-__KERN__ void
-k_ten4_tally(System *sys, int *vmst_cnt, VM_Handle *pool) {
-    const auto g  = cg::this_thread_block();   ///< all blocks in grid
+__GPU__ void
+_tally(System *sys, int *vmst_cnt, VM_Handle *pool) {
+    const auto g  = cg::this_thread_block();   ///< threads of one block
     const int  id = g.thread_rank();           ///< VM id
 
-    if (id==0) sys->mu->sweep();               ///< clear marked free tensors
+    if (id < T4_VM_COUNT) {                    /// * parked in last round
+        pool[id].park = pool[id].vm->state==WAIT;
+    }
     g.sync();
     
-    if (id < 4) vmst_cnt[id] = 0;
+    if (id==0) {
+        sys->mu->sweep();                      ///< clear marked free tensors
+#if DO_MULTITASK
+        ForthVM::tasker();                     ///< wake joined/received VMs
+#endif // DO_MULTITASK
+    }
+    g.sync();
+    
+    if (id < VM_STATES) vmst_cnt[id] = 0;
     g.sync();
 
     if (id < T4_VM_COUNT) {
-        vm_state s = pool[id].vm->state;
+        VM *vm = pool[id].vm;
+        vm_state s = vm->state;
         atomicAdd(&vmst_cnt[s], 1);
+        pool[id].state = s;                    /// * for host dispatcher
+#if DO_MULTITASK
+        pool[id].pid   = vm->pid;
+#else  // !DO_MULTITASK
+        pool[id].pid   = -1;
+#endif // DO_MULTITASK
     }
+    g.sync();
+}
+
+__KERN__ void
+k_ten4_tally(System *sys, int *vmst_cnt, VM_Handle *pool) {
+    _tally(sys, vmst_cnt, pool);
+}
+///
+/// run VM outer loop once with its stacks in shared memory ss, rs
+/// Note: single-threaded, dynamic parallelism when needed
+///
+__GPU__ void
+_exec0(VM *vm, DU *ss, DU *rs) {
+    DU *s0 = vm->ss.v;
+    DU *r0 = vm->rs.v;
+    MEMCPY(ss, s0, sizeof(DU) * T4_SS_SZ);     /// * TODO: parallel sync issue
+    MEMCPY(rs, r0, sizeof(DU) * T4_RS_SZ);     /// * see _exec1 below
+    vm->ss.v = ss;
+    vm->rs.v = rs;
+    
+    vm->outer();                               /// * enter VM outer loop
+    
+    MEMCPY(s0, ss, sizeof(DU) * T4_SS_SZ);
+    MEMCPY(r0, rs, sizeof(DU) * T4_RS_SZ);
+    vm->ss.v = s0;
+    vm->rs.v = r0;
 }
 
 __KERN__ void
@@ -75,22 +118,56 @@ k_vm_exec0(VM *vm) {
     const int  i = g.thread_rank();                 ///< thread id -> ss[i]
     ///
     /// * enter ForthVM outer loop
-    /// * Note: single-threaded, dynamic parallelism when needed
     ///
-    if (i == 0) {
-        DU *s0 = vm->ss.v;
-        DU *r0 = vm->rs.v;
-        MEMCPY(ss, s0, sizeof(DU) * T4_SS_SZ);     /// * TODO: parallel sync issue
-        MEMCPY(rs, r0, sizeof(DU) * T4_RS_SZ);     /// * see _exec1 below
-        vm->ss.v = ss;
-        vm->rs.v = rs;
-        
-        vm->outer();                               /// * enter VM outer loop
+    if (i == 0) _exec0(vm, ss, rs);
+}
+///
+/// resident VMs - launched once (cooperative), 1 block per VM, each round
+///   1. block 0 polls the command ring while VM0 waits for a line
+///   2. every runnable VM runs its outer loop in its own block
+///   3. block 0 tallies and runs the tasker, posts done when VM0 is not parked
+/// Note: host polls ctl->done, the grid idles in (1) while host flushes
+///
+__KERN__ void
+k_vm_resident(System *sys, int *vmst_cnt, VM_Handle *pool, VM_Ctl *ctl) {
+    __shared__ DU ss[T4_SS_SZ];
+    __shared__ DU rs[T4_RS_SZ];
+
+    const auto grid = cg::this_grid();
+    const auto g    = cg::this_thread_block();
+    const int  id   = blockIdx.x;                   ///< VM id
+    const int  i    = g.thread_rank();
+
+    for (;;) {
+        if (id == 0 && i == 0 && (!pool[0].park || !ctl->more)) {  /// * VM0 wants a line
+            VM_Cmd *c;
+            while (!(c = ctl->cmd.front())) RING_PAUSE();
+            ctl->op = *(volatile int*)&c->op;
+            if (ctl->op == CMD_LINE) sys->load(c->line);
+            ctl->cmd.next();                        /// * slot back to host
+        }
+        grid.sync();
+        if (ctl->op == CMD_QUIT) break;
+
+        if (i == 0) {
+            int st = pool[id].state;
+            if (st != STOP && st != WAIT) _exec0(pool[id].vm, ss, rs);
+        }
+        grid.sync();
         
-        MEMCPY(s0, ss, sizeof(DU) * T4_SS_SZ);
-        MEMCPY(r0, rs, sizeof(DU) * T4_RS_SZ);
-        vm->ss.v = s0;
-        vm->rs.v = r0;
+        if (id == 0) {
+            _tally(sys, vmst_cnt, pool);
+            bool idle = vmst_cnt[STOP] + vmst_cnt[WAIT] == T4_VM_COUNT;
+            if (i == 0 && (!pool[0].park || idle)) {
+                if (idle && pool[0].state == WAIT) {
+                    ERROR("VM[0] parked, no runnable task (deadlock)\n");
+                }
+                ctl->more = !idle;
+                __threadfence_system();             /// * output, states visible
+                ctl->done = ctl->done + 1;          /// * to host, no sync
+            }
+        }
+        grid.sync();
     }
 }
 
@@ -135,7 +212,7 @@ k_vm_exec1(VM *vm) {
         if ((n+i) < T4_RS_SZ) r0[n+i] = rs[n+i];
 }
 
-TensorForth::TensorForth(int device, int verbose) {
+TensorForth::TensorForth(int device, int verbose, h_istr &i, h_ostr &o) {
     ///
     /// set active device
     ///
@@ -154,19 +231,22 @@ TensorForth::TensorForth(int device, int verbose) {
          << " at "     << khz/1000 << "MHz"
          << ", dict["  << T4_DICT_SZ << "]"
          << ", pmem="  << T4_PMEM_SZ/1024 << "K"
+         << ", ohdr="  << T4_OHDR_SZ/1024/1024 << "M"
          << ", ostor=" << T4_OSTORE_SZ/1024/1024 << "M"
+         << "+"        << T4_OSEG_SZ/1024/1024 << "M*" << T4_OSEG_MAX
          << ", vmss["  << T4_SS_SZ << "*" << T4_VM_COUNT << "]"
          << ", vmrs["  << T4_RS_SZ << "*" << T4_VM_COUNT << "]"
          << endl;
     ///
     /// allocate tensorForth system memory blocks
     ///
-    sys = System::get_sys(cin, cout, khz, T4_VERBOSE);
+    sys = System::get_sys(i, o, khz, T4_VERBOSE);
     ///
     /// allocate VM handle pool
     ///
     MM_ALLOC(&vm_pool, sizeof(VM_Handle) * T4_VM_COUNT);
-    MM_ALLOC(&vmst_cnt, sizeof(int) * 4);
+    MM_ALLOC(&vmst_cnt, sizeof(int) * VM_STATES);
+    cc = new Compiler(*sys);
 }
 
 __HOST__ void
@@ -176,9 +256,30 @@ TensorForth::setup() {
         GPU_ERR(cudaStreamCreate(&h->st));          /// * allocate stream
         GPU_ERR(cudaEventCreate(&h->t0));           /// * allocate timers
         GPU_ERR(cudaEventCreate(&h->t1));
+        h->state = STOP;
+        h->pid   = -1;
+        h->home  = -1;
+        h->park  = 0;
     }
+    ///
+    /// with T4_SNAP_FILE set, first boot saves dictionary and pmem,
+    /// later boots replay word slots in init and restore the image
+    ///
+    const char *fn = getenv("T4_SNAP_FILE");
+    auto t0   = std::chrono::high_resolution_clock::now();
+    int  warm = fn && sys->mu->snap_load(fn);
+    
     k_vm_init<<<1, WARP(T4_VM_COUNT)>>>(sys, vm_pool);         /// * initialize all VMs
     GPU_CHK();
+#if T4_HOST_COMPILE
+    cc->setup();                                               /// * built-in names to host
+#endif // T4_HOST_COMPILE
+    
+    if (warm)       warm = sys->mu->snap_restore();
+    if (!warm && fn) sys->mu->snap_save(fn);                  /// * first boot or stale image
+    auto t1 = std::chrono::high_resolution_clock::now();
+    cout << "\\ VM init " << std::chrono::duration<double, std::milli>(t1 - t0).count()
+         << " ms (" << (warm ? "snapshot" : "cold") << ")" << endl;
 }
 ///
 /// collect VM states into vmst_cnt
@@ -187,21 +288,66 @@ __HOST__ int
 TensorForth::more_job() {
     k_ten4_tally<<<1, WARP(T4_VM_COUNT)>>>(sys, vmst_cnt, vm_pool);
     GPU_CHK();
-    return vmst_cnt[STOP] < T4_VM_COUNT;          /// * number of STOP VM
+#if T4_ENABLE_OBJ
+    if (sys->mu->need_grow()) sys->mu->grow();    /// * spare object store segment
+#endif // T4_ENABLE_OBJ
+    if (sys->mu->need_snap()) sys->mu->snap_save(getenv("T4_SNAP_FILE"));
+    if (vmst_cnt[STOP] + vmst_cnt[WAIT] < T4_VM_COUNT) return 1;
+    if (vmst_cnt[WAIT] && vm_pool[0].state==WAIT) {
+        ERROR("VM[0] parked, no runnable task (deadlock)\n");
+    }
+    return 0;                                     /// * nothing to dispatch
+}
+///
+/// dispatch VM v onto the stream of worker w
+///
+__HOST__ void
+TensorForth::_launch(int v, int w) {
+    VM_Handle *h  = &vm_pool[v];
+    STREAM    st  = vm_pool[w].st;
+    
+    cudaEventRecord(h->t0, st);                   /// * record start clock
+    k_vm_exec0<<<1, 1, 0, st>>>(h->vm);
+    cudaEventRecord(h->t1, st);                   /// * record end clock
+    h->home = w;
 }
 
 __HOST__ void
 TensorForth::run() {
     ///
-    ///> execute VM per stream
+    ///> queue runnable VMs (not STOP, not parked) on the worker they ran on
+    ///> last, a new task on its creator's worker
     ///
+    int n = 0;
+    for (int w=0; w<T4_VM_COUNT; w++) rq[w].clear();
     for (int i=0; i<T4_VM_COUNT; i++) {
-        VM_Handle *h  = &vm_pool[i];
-        VM        *vm = h->vm;
-        
-        cudaEventRecord(h->t0, h->st);            /// * record start clock
-        k_vm_exec0<<<1, 1, 0, h->st>>>(vm);
-        cudaEventRecord(h->t1, h->st);            /// * record end clock
+        VM_Handle *h = &vm_pool[i];
+        if (h->state==STOP || h->state==WAIT) {
+            if (h->state==STOP) h->home = -1;     /// * slot free for next task
+            continue;
+        }
+        if (h->home < 0) {
+            h->home = (h->pid >= 0 && vm_pool[h->pid].home >= 0)
+                ? vm_pool[h->pid].home : i;
+        }
+        rq[h->home].push(i);
+        n++;
+    }
+    ///
+    ///> each worker takes one VM per turn from its own tail,
+    ///> an idle worker steals the head of the longest deque
+    ///
+    while (n) {
+        for (int w=0; w<T4_VM_COUNT && n; w++) {
+            if (rq[w].size()) { _launch(rq[w].pop(), w); n--; continue; }
+            int x = 0;
+            for (int k=1; k<T4_VM_COUNT; k++) {
+                if (rq[k].size() > rq[x].size()) x = k;
+            }
+            if (!rq[x].size()) continue;
+            _launch(rq[x].steal(), w);
+            nsteal++; n--;
+        }
     }
     GPU_CHK();
 }
@@ -211,9 +357,9 @@ TensorForth::profile() {
     int t = sys->trace();
     if (t==0) return;
 
-    INFO("VM.state[STOP,HOLD,QUERY,NEST]=[");
-    for (int i = 0; i < 4; i++) INFO(" %d", vmst_cnt[i]);
-    INFO(" ]\n");
+    INFO("VM.state[STOP,HOLD,QUERY,NEST,WAIT]=[");
+    for (int i = 0; i < VM_STATES; i++) INFO(" %d", vmst_cnt[i]);
+    INFO(" ], stolen=%d\n", nsteal);
     if (t > 1) {
         int m0 = (int)sys->mu->here() - 0x80;
         sys->db->mem_dump(m0 < 0 ? 0 : m0, 0x80);
@@ -221,8 +367,11 @@ TensorForth::profile() {
     INFO("VM.dt=[ ");
     for (int i=0; i<T4_VM_COUNT; i++) {
         VM_Handle *h  = &vm_pool[i];
-        float dt;
-        cudaEventElapsedTime(&dt, h->t0, h->t1);
+        float dt = 0;
+        if (cudaEventElapsedTime(&dt, h->t0, h->t1) != cudaSuccess) {
+            cudaGetLastError();                   /// * VM not dispatched yet
+            dt = 0;
+        }
         INFO("%0.2f ", dt);
     }
     INFO("]\n");
@@ -232,8 +381,16 @@ __HOST__ int
 TensorForth::main_loop() {
 //    sys->db->self_tests();
     int i = 0;
-    while (more_job() && sys->readline()) {    /// * with loop guard
-        if (++i > 200) break;
+    while (more_job()) {
+        if (!vm_pool[0].park) {                /// * keep tib till VM0 resumes
+            if (sys->chunk()) {}               /// * included files, one launch a chunk
+#if T4_HOST_COMPILE
+            else if (!cc->readline(sys->tib())) break; /// * colon words done on host
+#else  // !T4_HOST_COMPILE
+            else if (!sys->readline()) break;
+#endif // T4_HOST_COMPILE
+            if (++i > 200) break;              /// * with loop guard
+        }
         run();
         sys->flush();                          /// * flush output buffer
         profile();
@@ -241,6 +398,68 @@ TensorForth::main_loop() {
     return 0;
 }
 
+///
+/// VMs stay resident, a line goes in thru the command ring and
+/// completion comes back in ctl->done, GPU is synced only at quit
+///
+__HOST__ int
+TensorForth::main_resident() {
+    int dev, coop = 0, cma = 0;
+    GPU_ERR(cudaGetDevice(&dev));
+    GPU_ERR(cudaDeviceGetAttribute(&coop, cudaDevAttrCooperativeLaunch, dev));
+    GPU_ERR(cudaDeviceGetAttribute(&cma,  cudaDevAttrConcurrentManagedAccess, dev));
+    if (!coop || !cma) {
+        INFO("\\ resident mode not supported by GPU %d, use default\n", dev);
+        return main_loop();
+    }
+    if (!more_job()) return 0;                    /// * initial states and park
+    
+    VM_Ctl *ctl = new VM_Ctl;
+    ctl->cmd.init();
+    ctl->op   = 0;
+    ctl->done = 0;
+    ctl->more = 1;
+    sys->resident(true);
+    
+    STREAM st;
+    GPU_ERR(cudaStreamCreateWithFlags(&st, cudaStreamNonBlocking));
+    void *args[] = { (void*)&sys, (void*)&vmst_cnt, (void*)&vm_pool, (void*)&ctl };
+    K_RUN((void*)k_vm_resident, dim3(T4_VM_COUNT), dim3(WARP_SZ), args, 0, st);
+
+    VM_Cmd *c  = new VM_Cmd;
+    U32    n   = 0;
+    double dt  = 0;
+    while (ctl->more) {
+        c->op = CMD_LINE;
+        if (!sys->readline(c->line)) break;
+        if (n >= 200) break;                      /// * with loop guard
+        
+        auto t0 = std::chrono::high_resolution_clock::now();
+        ctl->cmd.push(c);
+        ++n;
+        while (ctl->done != n) RING_PAUSE();      /// * poll, no device sync
+        dt += std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - t0).count();
+        
+        sys->flush();                             /// * grid idle, waits for next line
+#if T4_ENABLE_OBJ
+        if (sys->mu->need_grow()) sys->mu->grow();
+#endif // T4_ENABLE_OBJ
+        if (sys->mu->need_snap()) sys->mu->snap_save(getenv("T4_SNAP_FILE"));
+        profile();
+    }
+    c->op = CMD_QUIT;
+    ctl->cmd.push(c);
+    GPU_CHK();
+    sys->resident(false);
+    if (n) INFO("\\ resident: %d lines, %.1f us/line round trip\n", n, dt / n);
+    
+    GPU_ERR(cudaStreamDestroy(st));
+    delete c;
+    delete ctl;
+    return 0;
+}
+
 __HOST__ void
 TensorForth::teardown(int sig) {
     cout << "\\ VM[] ";
@@ -256,56 +475,8 @@ TensorForth::teardown(int sig) {
     }
     MM_FREE(vmst_cnt);           /// * release ten4 Managed memory
     MM_FREE(vm_pool);
+    delete cc;
     
     System::free_sys();          /// * release system
     cudaDeviceReset();
 }
-///
-/// main program
-///
-void sigsegv_handler(int sig, siginfo_t *si, void *arg) {
-    cout << "Exception caught at: " << si->si_addr << endl;
-    exit(1);
-}
-
-void sigtrap() {
-    struct sigaction sa;
-    memset(&sa, 0, sizeof(struct sigaction));
-    sigemptyset(&sa.sa_mask);
-    sa.sa_sigaction = sigsegv_handler;
-    sa.sa_flags     = SA_SIGINFO;
-    sigaction(SIGSEGV, &sa, NULL);
-}
-
-#include "opt.h"
-int main(int argc, char**argv) {
-    sigtrap();
-    
-    Options opt;
-    opt.parse(argc, argv);
-    
-    GPU_ERR(cudaDeviceSetLimit(cudaLimitStackSize, T4_PER_THREAD_STACK));
-    // GPU_ERR(cudaDeviceSetLimit(cudaLimitMallocHeapSize, 16*1024*1024));
-    
-    if (opt.help) {
-        opt.print_usage(cout);
-        opt.check_devices(cout);
-        cout << "\nRecommended GPU: " << opt.device_id << endl;
-        return 0;
-    }
-    else opt.check_devices(cout, false);
-
-    cout << T4_APP_NAME << endl;
-
-    TensorForth *f = new TensorForth(opt.device_id, opt.verbose);
-    f->setup();
-    f->main_loop();
-    f->teardown();
-    
-    cout << T4_APP_NAME << " done." << endl;
-
-    return 0;
-}
-
-
-    
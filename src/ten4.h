@@ -8,7 +8,9 @@
 #include "vm/eforth.h"       // just eForth
 #include "vm/tenvm.h"        // tensor/matrix set, or
 #include "vm/netvm.h"        // neural network set,
+#include "vm/compiler.h"     // colon words compiled on host
 #include "ldr/loader.h"      // default dataset loader
+#include "mmu/ring.h"        // command ring for resident VMs
 
 #if T4_ENABLE_NN
 typedef NetVM     VM_TYPE;
@@ -26,15 +28,57 @@ struct VM_Handle : public Managed {
     STREAM  st;
     EVENT   t0;
     EVENT   t1;
+    int     state;                          ///< VM state, by k_ten4_tally
+    int     pid;                            ///< task creator VM, -1 none
+    int     home;                           ///< worker (stream) last ran on
+    int     park;                           ///< parked (WAIT) in last round
+};
+///
+/// per-worker deque of runnable VMs for a dispatch round, the worker
+/// pops its own tail (last ran there), idle workers steal the head
+///
+struct VM_Deque {
+    int q[T4_VM_COUNT];
+    int head = 0, tail = 0;
+    
+    __HOST__ void clear()    { head = tail = 0; }
+    __HOST__ int  size()     { return tail - head; }
+    __HOST__ void push(int v){ q[tail++] = v; }
+    __HOST__ int  pop()      { return q[--tail]; }
+    __HOST__ int  steal()    { return q[head++]; }
+};
+
+///
+/// resident (persistent kernel) mode, host feeds input lines thru a
+/// managed command ring and polls status words, no device sync per line
+/// Note: a cooperative launch cannot start child kernels nor sync the device,
+///       so words marked cdp (tensor and NN words) are refused in this mode
+///
+typedef enum { CMD_LINE = 1, CMD_QUIT } vm_cmd_op;
+struct VM_Cmd {
+    int  op;                                ///< CMD_LINE, CMD_QUIT
+    char line[T4_IBUF_SZ];                  ///< input line for VM0
+};
+struct VM_Ctl : public Managed {
+    SPSC<VM_Cmd, 2> cmd;                    ///< host -> VM0, one line ahead
+    int             op;                     ///< current command, all blocks
+    volatile U32    done;                   ///< status, lines completed
+    volatile int    more;                   ///< status, any VM runnable
 };
 
 class TensorForth {
     System    *sys;
+    Compiler  *cc;                           ///< host-side colon compiler
     VM_Handle *vm_pool;                      ///< CUDA stream per VM
     int       *vmst_cnt;
+    VM_Deque  rq[T4_VM_COUNT];               ///< run queue per worker (stream)
+    int       nsteal = 0;                    ///< VMs stolen by idle workers
+    
+    __HOST__ void  _launch(int v, int w);    ///< dispatch VM v on worker w
     
 public:
-    TensorForth(int device=0, int verbose=0);
+    TensorForth(int device=0, int verbose=0,
+                h_istr &i=std::cin, h_ostr &o=std::cout); ///< tests feed a script
     ~TensorForth();
 
     __HOST__ void  setup();
@@ -42,6 +86,7 @@ public:
     __HOST__ void  run();                    ///< run (and profile) VMs once
     __HOST__ void  profile();                ///< profile VM elapse
     __HOST__ int   main_loop();              ///< execute tensorForth main loop
+    __HOST__ int   main_resident();          ///< main loop with VMs kept resident
     __HOST__ void  teardown(int sig=0);
 };
 #endif // __TEN4_H_
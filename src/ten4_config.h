@@ -31,6 +31,13 @@
 ///@name Virtual machine instance controls
 ///@{
 #define T4_VM_COUNT         4        /**< number of VMs         */
+#define DO_MULTITASK        1        /**< VM tasks, send/recv   */
+#define T4_MBOX_SZ          64       /**< VM inbox (power of 2) */
+#define T4_HOST_COMPILE     1        /**< colon words on host   */
+#define T4_BULK_LIT         8        /**< literal run parsed on host, 0 off */
+#define T4_LIT_MARK         '\x01'   /**< leads a bulk literal block idiom  */
+#define T4_INLINE_CACHE     1        /**< operand kinds per call site, 0 off */
+#define T4_IC_SZ            256      /**< inline cache entries per VM (2^n)  */
 #define T4_EXP_STACK        8        /**< exception stack depth */
 #define T4_REGFILE_SZ       128      /**< register file size    */
 ///@}
@@ -60,12 +67,24 @@
 #define T4_NET_SZ    32        /**< size of network DAG          */
 #define T4_DICT_SZ   1024      /**< number of dictionary entries */
 #define T4_IBUF_SZ   1024      /**< host input buffer size       */
+#define T4_ICHUNK_SZ (256*1024) /**< device input, included chunk */
+#define T4_INCL_DEPTH 8        /**< nested included files        */
 #define T4_OBUF_SZ   8192      /**< device output buffer size    */
 #define T4_STRBUF_SZ 128       /**< temp string buffer size      */
-#define T4_OSTORE_SZ (1024*1024*1024) /**< object storage size   */ 
-#define T4_TFREE_SZ  T4_NET_SZ /**< size of tensor free queue    */
-#define T4_RAND_SZ   256       /**< number of random seeds       */
+#define T4_OHDR_SZ   (64*1024*1024) /**< object headers, <= 1G (handle) */
+#define T4_OSTORE_SZ (1024*1024*1024) /**< initial tensor data storage */
+#define T4_OSEG_SZ   (1024*1024*1024) /**< data segment, < 2G (TLSF)  */
+#define T4_OSEG_MAX  64        /**< max data segments            */
+#define T4_OSEG_HOT  2         /**< device segments before mmap  */
+#define T4_TFREE_SZ  256       /**< tensor free queue segment    */
+#define T4_TFREE_SEG 64        /**< max free queue segments      */
+#define T4_SWEEP_MAX 256       /**< max objects released per tick */
+#define T4_RAND_SZ   256       /**< random fill threads per block */
 #define T4_WARP_SZ   16        /**< CUDA GPU warp 16x16 threads  */
 #define T4_WARP_SQ   (T4_WARP_SZ * T4_WARP_SZ)
+#define T4_LU_NB     32        /**< blocked LU panel width       */
+#define T4_BATCH_MAX 64        /**< max batched small matrix size */
+#define T4_BATCH_Z   65535     /**< max grid.z of batched launch */
+#define T4_MB_MAX    8         /**< max micro-batches (streams) per forward */
 ///@}
 #endif // __TEN4_CONFIG_H_
@@ -76,6 +76,7 @@ namespace cg = cooperative_groups;
 
 #define __GPU__
 #define __HOST__
+#define __BOTH__
 #define __KERN__
 #define __INLINE__          inline
 typedef int                 STREAM;
@@ -99,6 +100,7 @@ typedef uintptr_t   UFP;                    ///< function pointer type
 typedef int64_t     S64;                    ///< 64-bit signed integer
 typedef int32_t     S32;                    ///< 32-bit signed integer
 typedef int16_t     S16;                    ///< 16-bit signed integer
+typedef int8_t      S8;                     ///< 8-bit  signed integer
 
 typedef double      F64;                    ///< double precision float
 typedef float       F32;                    ///< single precision float
@@ -181,7 +183,8 @@ typedef enum {
     OP_DATA,
     OP_FETCH,
     OP_NSAVE,
-    OP_NLOAD
+    OP_NLOAD,
+    OP_INCL
 } OP;
 ///@}
 ///>name File Access Mode for IO Event
@@ -306,7 +306,7 @@ d_itoa(int v, char *s, int base) {
   @param  base  n base.
   @return   result.
 */
-__GPU__ long
+__BOTH__ long
 d_strtol(const char *s, char** p, int base) {
     long ret  = 0;
     bool sign = 0;
@@ -330,7 +330,7 @@ d_strtol(const char *s, char** p, int base) {
     return (sign) ? -ret : ret;
 }
 
-__GPU__ double
+__BOTH__ double
 d_strtof(const char *s, char** p) {
     int  sign = 1, esign = 1, state=0;
     int  r = 0,  e = 0;
@@ -114,8 +114,8 @@ __GPU__ char*        d_strcut(const char *s, int n);                     // take
 ///@name Numeric conversion
 ///@{
 __GPU__ int          d_itoa(int v, char *s, int base=10);
-__GPU__ long         d_strtol(const char *s, char **p, int base=10);
-__GPU__ double       d_strtof(const char *s, char **p);
+__BOTH__ long        d_strtol(const char *s, char **p, int base=10);  // host compiler parses alike
+__BOTH__ double      d_strtof(const char *s, char **p);
 __GPU__ int          d_hash(const char *s);
 ///@}
 ///@name Tensor ops (kernel mode)
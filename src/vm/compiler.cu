@@ -0,0 +1,396 @@
+/** -*- c++ -*-
+ * @file
+ * @brief Compiler class - host-side colon word compiler implementation
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ *
+ * Device outer interpreter runs parse(), find() and number() single-threaded
+ * per token. Here, a colon definition is tokenized on host, resolved against
+ * a hashed mirror of the dictionary and emitted straight into pmem. Long runs
+ * of literals (tensor bodies) are parsed here too and staged in System
+ */
+#include <chrono>
+#include "compiler.h"
+///
+/// built-in immediate words the host compiles the same way ForthVM does
+///
+typedef enum {
+    C_SEMI = 0, C_IF, C_ELSE, C_THEN, C_BEGIN, C_AGAIN, C_UNTIL, C_WHILE,
+    C_REPEAT, C_FOR, C_NEXT, C_AFT, C_DO, C_LOOP, C_KEY, C_PAREN, C_BSLASH,
+    C_DOTQ, C_STR
+} cc_op;
+static const char *_cc_word[] = {
+    ";", "if", "else", "then", "begin", "again", "until", "while",
+    "repeat", "for", "next", "aft", "do", "loop", "key", "(", "\\",
+    ".\"", "s\""
+};
+///
+/// copy names of built-in words (in device memory) into managed buffer
+///
+__KERN__ void
+k_dict_names(MMU *mu, char *buf, int sz, IU n) {
+    char *p = buf, *e = buf + sz - 1;
+    for (IU i = 0; i < n && p < e; i++) {
+        const char *s = mu->dict(i)->name;
+        while (p < e && (*p++ = *s++));
+    }
+    *p = '\0';
+}
+
+__HOST__ void
+Compiler::setup() {
+    const int sz = T4_DICT_SZ * 32;
+    char *buf;
+    MM_ALLOC(&buf, sz);
+    k_dict_names<<<1, 1>>>(mu, buf, sz, mu->_didx);
+    GPU_CHK();
+
+    char *p = buf, *e = buf + sz - 1;
+    for (IU i = 0; i < mu->_didx; i++) {
+        if (p >= e) { _pnm.clear(); break; }      /// * too long, stay on device
+        _pnm.push_back(p);
+        p += strlen(p) + 1;
+    }
+    MM_FREE(buf);
+    if (_pnm.empty()) return;
+
+    _sync();
+    for (int op = C_SEMI; op <= C_STR; op++) {    /// * by index, user words excluded
+        IU w = _find(_cc_word[op]);
+        if (w && mu->dict(w)->imm) _imm[w] = op;
+    }
+    TRACE("\\ Compiler: %ld built-in names, %ld immediate on host\n",
+          (long)_pnm.size(), (long)_imm.size());
+}
+
+__HOST__ std::string
+Compiler::_name(IU w) {
+    return w < _pnm.size() ? _pnm[w] : std::string(mu->dict(w)->name);  ///< colon names in pmem
+}
+///
+/// mirror new entries, rebuild after forget or redefinition by device
+///
+__HOST__ void
+Compiler::_sync() {
+    IU n = mu->_didx;
+    if (n < _nsync || (_nsync && _name(_nsync - 1) != _last)) {
+        _map.clear();
+        _nsync = 0;
+    }
+    if (n == _nsync) return;
+    for (IU i = _nsync ? _nsync : 1; i < n; i++) {    /// * dict[0] not searched
+        std::string k = _name(i);
+#if !T4_CASE_SENSITIVE
+        for (auto &c : k) c = tolower(c);
+#endif // !T4_CASE_SENSITIVE
+        _map[k] = i;                                  /// * newest wins, as MMU::find
+    }
+    _nsync = n;
+    _last  = _name(n - 1);
+}
+
+__HOST__ IU
+Compiler::_find(const std::string &s) {
+#if T4_CASE_SENSITIVE
+    auto w = _map.find(s);
+#else  // !T4_CASE_SENSITIVE
+    std::string k = s;
+    for (auto &c : k) c = tolower(c);
+    auto w = _map.find(k);
+#endif // T4_CASE_SENSITIVE
+    return w == _map.end() ? 0 : w->second;
+}
+///
+/// same rules as ForthVM::number, with the same parsers
+///
+__HOST__ bool
+Compiler::_number(const std::string &t, DU &n) {
+    const char *s = t.c_str();
+    int  b = *mu->pmem(0);                            ///< VM0 base
+    switch (*s) {
+    case '%': b = 2;  s++; break;
+    case '&':
+    case '#': b = 10; s++; break;
+    case '$': b = 16; s++; break;
+    }
+    char *p;
+    DU2 d2 = (b==10 && strchr(s, '.'))
+        ? d_strtof(s, &p)
+        : d_strtol(s, &p, b);
+    if (*p != '\0') return false;
+    n = (DU)d2;
+#if T4_ENABLE_OBJ
+    SCALAR(n);                                        /// * as TensorVM::process
+#endif // T4_ENABLE_OBJ
+    return true;
+}
+
+__HOST__ void
+Compiler::_add(const void *v, int sz) {
+    if (mu->_midx + sz > T4_PMEM_SZ) { _ovf = true; return; }
+    memcpy(mu->pmem(mu->_midx), v, sz);
+    mu->_midx += sz;
+}
+
+__HOST__ void
+Compiler::_add_str(const std::string &s) {
+    char buf[T4_IBUF_SZ + 4] = { 0 };
+    int  sz = ALIGN((int)s.size() + 1);
+    memcpy(buf, s.c_str(), s.size());
+    _add(buf, sz);
+}
+///
+/// line handling, lines given back to device go first
+///
+__HOST__ int
+Compiler::_getline(std::string &s) {
+    if (_pend.size()) {
+        s = _pend.front();
+        _pend.pop_front();
+        return 1;
+    }
+    if (_eof) return 0;
+    char buf[T4_IBUF_SZ];
+    if (sys.readline(buf)) { s = buf; return 1; }
+    _eof = true;                                      /// * last partial line dropped, as before
+    return 0;
+}
+///
+/// next blank delimited idiom (as Istream), more=true reads on
+///
+__HOST__ bool
+Compiler::_token(Src &s, std::string &t, bool more) {
+    for (;;) {
+        std::string &l = s.cur();
+        size_t i = s.i;
+        auto   ws = [](char c) { return c==' ' || c=='\t' || c=='\r'; };
+        while (i < l.size() && ws(l[i])) i++;
+        size_t j = i;
+        while (j < l.size() && !ws(l[j])) j++;
+        s.i = j;
+        if (j > i) { t = l.substr(i, j - i); return true; }
+        if (!more) return false;
+
+        s.ln.emplace_back();
+        s.i = 0;
+        if (!_getline(s.cur())) { s.ln.pop_back(); return false; }
+    }
+}
+///
+/// up to delim on current line, as System::scan
+///
+__HOST__ bool
+Compiler::_scan(Src &s, char delim, std::string &t) {
+    std::string &l = s.cur();
+    size_t q = l.find(delim, s.i);
+    if (q == std::string::npos) return false;         /// * device keeps stale pad
+    t   = l.substr(s.i, q - s.i);
+    s.i = q + 1;
+    return true;
+}
+///
+/// compile `name ... ;` after the colon, false to leave it to device
+///
+__HOST__ bool
+Compiler::_colon(Src &s) {
+    std::string nm, t, x;
+    if (!_token(s, nm, false)) return false;          /// * name? reported by device
+    IU w0 = _find(nm);
+    ///
+    /// header, as MMU::colon
+    ///
+    _ovf = false;
+    mu->_midx += (-mu->_midx & 0x3);                  /// * nfa 32-bit aligned
+    IU   di = mu->_didx++;
+    Code &c = *mu->dict(di);
+    c.xt   = 0;
+    c.didx = di;
+    c.nfa  = mu->_midx;
+    c.name = (const char*)mu->pmem(mu->_midx);
+    c.udf  = 1;
+    _add_str(nm);
+    c.pfa  = mu->_midx;
+    ///
+    /// body, branch targets kept on a host stack (ForthVM uses ss)
+    ///
+    std::vector<IU> cs;
+    auto pop = [&cs](IU &v) {
+        if (cs.empty()) return false;
+        v = cs.back(); cs.pop_back();
+        return true;
+    };
+    for (;;) {
+        if (!_token(s, t, true) || _ovf) return false;
+#if T4_CASE_SENSITIVE
+        IU w = t == nm ? di : _find(t);               /// * itself, found by device too
+#else  // !T4_CASE_SENSITIVE
+        IU w = strcasecmp(t.c_str(), nm.c_str()) ? _find(t) : di;
+#endif // T4_CASE_SENSITIVE
+        if (!w) {                                     /// * literal
+            DU n;
+            if (!_number(t, n)) return false;         /// * error message by device
+            _add_lit(n);
+            continue;
+        }
+        if (!mu->dict(w)->imm) { _add_w(w); continue; }
+
+        auto op = _imm.find(w);
+        if (op == _imm.end()) return false;           /// * to, is, user immediate words
+        IU a, b;
+        switch (op->second) {
+        case C_SEMI:
+            _add_p(EXIT);
+            if (_ovf || !cs.empty()) return false;    /// * unbalanced, as device would leave it
+            if (w0) sys.io->fout << nm << " reDef? " << std::endl;
+            _sync();                                  /// * mirror the new word
+            return true;
+        case C_IF:     cs.push_back(mu->here()); _add_p(ZBRAN);           break;
+        case C_ELSE:
+            if (!pop(a)) return false;
+            b = mu->here(); _add_p(BRAN); _setjmp(a); cs.push_back(b);    break;
+        case C_THEN:   if (!pop(a)) return false; _setjmp(a);             break;
+        case C_BEGIN:  cs.push_back(mu->here());                          break;
+        case C_AGAIN:  if (!pop(a)) return false; _add_p(BRAN, a);        break;
+        case C_UNTIL:  if (!pop(a)) return false; _add_p(ZBRAN, a);       break;
+        case C_WHILE:  cs.push_back(mu->here()); _add_p(ZBRAN);           break;
+        case C_REPEAT:
+            if (!pop(b) || !pop(a)) return false;
+            _add_p(BRAN, a); _setjmp(b);                                  break;
+        case C_FOR:    _add_p(FOR); cs.push_back(mu->here());             break;
+        case C_NEXT:   if (!pop(a)) return false; _add_p(NEXT, a);        break;
+        case C_AFT:
+            if (!pop(a)) return false;
+            b = mu->here(); _add_p(BRAN);
+            cs.push_back(mu->here()); cs.push_back(b);                    break;
+        case C_DO:     _add_p(DO); cs.push_back(mu->here());              break;
+        case C_LOOP:   if (!pop(a)) return false; _add_p(LOOP, a);        break;
+        case C_KEY:    _add_p(KEY);                                       break;
+        case C_PAREN:  if (!_scan(s, ')', x)) return false;               break;
+        case C_BSLASH: s.i = s.cur().size();                              break;
+        case C_DOTQ:
+        case C_STR:
+            if (!_scan(s, '"', x)) return false;
+            x = x.substr(1);                          /// * skip first blank
+            _add_p(op->second==C_DOTQ ? DOTQ : STR, ALIGN((IU)x.size() + 1));
+            _add_str(x);                                                  break;
+        }
+    }
+}
+///
+/// device compile mode, from `:` to `;` of what it is fed
+///
+__HOST__ void
+Compiler::_devc_scan(const std::string &l) {
+    Src s;
+    s.ln.push_back(l);
+    std::string t, x;
+    while (_token(s, t, false)) {
+        if      (t == ":")  _devc = true;
+        else if (t == ";")  _devc = false;
+        else if (t == "\\")                break;     /// * comment, body goes on
+        else if (t == "(")  _scan(s, ')', x);
+        else if (t == ".(") _scan(s, ')', x);
+        else if (t == ".\"" || t == "s\"") _scan(s, '"', x);
+    }
+}
+///
+/// runs of T4_BULK_LIT or more literals inside a tensor literal body
+/// (vector{, matrix{, ={ ... }, across lines) are parsed in one pass, staged
+/// in System and replaced by one T4_LIT_MARK idiom which TensorVM::pre takes
+/// as a block (into tensor storage, pmem or the stack as process would)
+/// Note: numbers are read in VM0's base at the start of the line, any word
+///       other than a body opener or brace (hex, base !, user words, ...)
+///       may change it, so the scan ends there and the device takes the rest
+///
+__HOST__ void
+Compiler::_bulk(std::string &l) {
+    static const char *_open[] = { "vector{", "matrix{", "={" };
+    auto opener = [](const std::string &t) {
+        for (int i = 0; i < 3; i++) if (t == _open[i]) return true;
+        return false;
+    };
+    std::vector<DU> v;
+    std::string     r, t, x;
+    size_t cp = 0, rs = 0, re = 0;                    ///< copied upto, run span
+    int    rn = 0;                                    ///< literals in run
+    auto flush = [&]() {
+        if (rn >= T4_BULK_LIT) {
+            r.append(l, cp, rs - cp);
+            r += T4_LIT_MARK;
+            r += std::to_string(rn);
+            cp = re;
+        }
+        else v.resize(v.size() - rn);                 /// * short run, device parses
+        rn = 0;
+    };
+    _sync();                                          /// * words added by device
+    Src s;
+    s.ln.push_back(l);
+    while (_token(s, t, false)) {
+        DU   n;
+        bool num = _number(t, n) && !_find(t);        ///< not a word, as process
+        if (num && _tlvl > 0) {
+            if (!rn) rs = s.i - t.size();
+            re = s.i;
+            rn++;
+            v.push_back(n);
+            continue;
+        }
+        flush();
+        if (num) continue;                            /// * outside a body, device parses
+        if (opener(t))                     _tlvl = 1;
+        else if (t == "{" && _tlvl > 0)    _tlvl++;
+        else if (t == "}" && _tlvl > 0)    _tlvl--;
+        else if (t == "(" || t == ".(")    _scan(s, ')', x);
+        else if (t == ".\"" || t == "s\"") _scan(s, '"', x);
+        else if (t == "\\")                break;     /// * comment, body goes on
+        else { _tlvl = 0; break; }                    /// * may change base
+    }
+    flush();
+    if (!v.size()) { sys.lits(0); return; }
+    r.append(l, cp, std::string::npos);
+    l = r;
+    memcpy(sys.lits((int)v.size()), v.data(), v.size() * sizeof(DU));
+    nlit += v.size();
+}
+///
+/// leading definitions of a line compiled on host, the rest to tib
+///
+__HOST__ int
+Compiler::readline(char *tib) {
+    Src s;
+    s.ln.emplace_back();
+    if (!_getline(s.cur())) return 0;
+
+    if (!_devc && _pnm.size()) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        _sync();                                      /// * words added by device
+        std::string t;
+        for (;;) {
+            size_t k = s.ln.size(), i = s.i;          ///< where device would start
+            if (!_token(s, t, false)) break;
+            if (t != ":") { s.i = i; break; }
+
+            IU d0 = mu->_didx, m0 = mu->_midx;
+            if (_colon(s)) { nword++; continue; }
+
+            mu->_didx = d0;                           /// * roll back, device compiles it
+            mu->_midx = m0;
+            for (size_t j = s.ln.size(); j > k; j--) _pend.push_front(s.ln[j - 1]);
+            s.ln.resize(k);
+            s.i = i;
+            nback++;
+            break;
+        }
+        us += std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - t0).count();
+    }
+    std::string r = s.cur().substr(s.i < s.cur().size() ? s.i : s.cur().size());
+    _devc_scan(r);
+#if T4_ENABLE_OBJ && T4_BULK_LIT
+    if (_pnm.size()) _bulk(r);                        /// * TensorVM takes literal blocks
+#endif // T4_ENABLE_OBJ && T4_BULK_LIT
+    strncpy(tib, r.c_str(), T4_IBUF_SZ - 1);
+    tib[T4_IBUF_SZ - 1] = '\0';
+    return 1;
+}
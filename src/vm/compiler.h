@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @brief Compiler class - host-side colon word compiler
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#ifndef __VM_COMPILER_H
+#define __VM_COMPILER_H
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include "sys.h"                        ///< System, MMU, Code
+#include "param.h"                      ///< Parameter field
+///
+///@name Host compiler class
+///@brief leading `: name ... ;` definitions of an input line are compiled
+///       on host into _pmem and _dict (same Param encoding as ForthVM),
+///       the rest of the line goes to the device which only executes
+///@note  anything the host cannot compile exactly (user immediate words,
+///       to, is, unknown idioms, ...) is handed back to the device as is
+///@{
+class Compiler {
+    System  &sys;
+    MMU     *mu;
+    std::unordered_map<std::string, IU> _map;  ///< host mirror of dict, name => newest index
+    std::unordered_map<IU, int>         _imm;  ///< built-in immediate words handled on host
+    std::vector<std::string>            _pnm;  ///< built-in word names (copied from device)
+    std::deque<std::string>             _pend; ///< lines handed back to device
+    IU          _nsync = 0;             ///< dict entries mirrored
+    std::string _last;                  ///< name of last mirrored entry
+    bool        _devc  = false;         ///< device is compiling (host gave up a word)
+    bool        _eof   = false;         ///< host input ended
+    bool        _ovf   = false;         ///< pmem full, word left to device
+    int         _tlvl  = 0;             ///< tensor literal body depth, across lines
+    ///
+    /// line cursor, a definition can span lines
+    ///
+    struct Src {
+        std::vector<std::string> ln;    ///< lines taken for current definition
+        size_t                   i = 0; ///< position in last line
+        std::string &cur() { return ln.back(); }
+    };
+    __HOST__ int   _getline(std::string &s);             ///< pending first, then input
+    __HOST__ bool  _token(Src &s, std::string &t, bool more);
+    __HOST__ bool  _scan(Src &s, char delim, std::string &t);
+    __HOST__ void  _sync();                              ///< catch up with device dict
+    __HOST__ std::string _name(IU w);                    ///< host copy of a word name
+    __HOST__ IU    _find(const std::string &s);
+    __HOST__ bool  _number(const std::string &s, DU &n);
+    __HOST__ bool  _colon(Src &s);                       ///< compile one definition
+    __HOST__ void  _devc_scan(const std::string &s);     ///< track device compile mode
+    __HOST__ void  _bulk(std::string &s);                ///< tensor literal bodies parsed on host
+    ///
+    /// pmem emitters, same layout as ForthVM add_*
+    ///
+    __HOST__ void  _add(const void *v, int sz);
+    __HOST__ void  _add_str(const std::string &s);      ///< zero padded, aligned
+    __HOST__ void  _add_p(prim_op op, IU ix=0, bool u=false, bool x=false) {
+        Param p(op, ix, u, x);
+        _add(&p.pack, sizeof(IU));
+    }
+    __HOST__ void  _add_w(IU w) {
+        Code &c = *mu->dict(w);
+        _add_p(MAX_OP, c.pfa, c.udf);
+    }
+    __HOST__ void  _add_lit(DU v) { _add_p(LIT); _add(&v, sizeof(DU)); }
+    __HOST__ void  _setjmp(IU a)  { ((Param*)mu->pmem(a))->ioff = mu->here(); }
+
+public:
+    U64     nword  = 0;                 ///< words compiled on host
+    U64     nback  = 0;                 ///< definitions handed back to device
+    U64     nlit   = 0;                 ///< literals parsed on host
+    double  us     = 0;                 ///< host compile time
+
+    __HOST__ Compiler(System &sys) : sys(sys), mu(sys.mu) {}
+    __HOST__ ~Compiler() {
+        TRACE("\\   Compiler: %ld words, %ld literals on host (%.1f us), %ld to device\n",
+              nword, nlit, us, nback);
+    }
+    __HOST__ void  setup();             ///< after VM init, copy built-in names
+    __HOST__ int   readline(char *tib); ///< compile leading definitions, rest to tib
+};
+///@}
+#endif // __VM_COMPILER_H
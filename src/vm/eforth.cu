@@ -6,21 +6,38 @@
  */
 #include "eforth.h"
 
+#if DO_MULTITASK
+__GPU__ ForthVM *_vm[T4_VM_COUNT];              ///< VM pool, for tasker and peers
+__GPU__ int     _io_owner = -1;                 ///< VM holding IO lock, -1 free
+#endif // DO_MULTITASK
+
 __GPU__
 ForthVM::ForthVM(int id, System &sys) : VM(id, sys) {
     dict = mmu.dict(0);
     base = id;                                  /// * pmem[id], 0..USER_AREA-1 reserved
     *MEM(base) = 10;
+#if DO_MULTITASK
+    _vm[id] = this;
+    mq.init();
+#endif // DO_MULTITASK
     TRACE("\\  ::ForthVM[%d]\n", id);
 }
 ///
-/// resume suspended task
+/// resume suspended task or word parked in the middle
+/// @return 1 - done with this dispatch, 0 - VM0 back to outer interpreter
 ///
 __GPU__ int
 ForthVM::resume() {
-    TRACE("VM[%d] resumed at ip=%x\n", id, ip);
-    nest();           /// * will set state to VM_READY
-    return 1;         /// * OK, continue to outer loop
+    if (ip) {
+        TRACE("VM[%d] resumed at ip=%x\n", id, ip);
+        nest();                               /// * until done or parked again
+    }
+    if (state==WAIT) return 1;                /// * parked on join/send/recv/lock
+    if (!id) return 0;                        /// * VM0 continues with tib
+#if DO_MULTITASK
+    stop();                                   /// * task word returned
+#endif // DO_MULTITASK
+    return 1;
 }
 ///
 /// ForthVM Outer interpreter
@@ -53,7 +70,7 @@ ForthVM::process(char *idiom) {
 __GPU__ int
 ForthVM::post() {
     DEBUG("%d> VM.state=%d\n", id, state);
-    if (state!=HOLD && !compile) {
+    if (state!=HOLD && state!=WAIT && !compile) {
         sys.op(OP_SS, *BASE, tos, SS2I);
     }
     return 0;
@@ -72,7 +89,7 @@ ForthVM::nest() {
     ///
     /// when ip != 0, it resumes paused VM
     ///
-    while (ip) {                                     /// * try no recursion
+    while (ip && state!=WAIT) {                      /// * try no recursion, or parked
         Param &ix = *(Param*)MEM(ip);
         VM_HDR(":%x", ix.op);
         ip += sizeof(IU);
@@ -113,7 +130,7 @@ ForthVM::nest() {
                 rs.push(ip);                         /// * setup call frame
                 ip = ix.ioff;                        /// * ip = word.pfa
             }
-            else (*mmu.XT(ix.ioff))());              /// * execute built-in word
+            else _xcall(ix));                        /// * execute built-in word
         }
         VM_TLR(" => SS=%d, RS=%d, ip=%x", ss.idx, rs.idx, ip);
     }
@@ -124,14 +141,208 @@ ForthVM::nest() {
 __GPU__ __INLINE__ void ForthVM::call(IU w) {
     Code &c = dict[w];                               /// * code reference
     DEBUG(" => cal(%s)\n", c.name);
+    if (c.cdp && sys.is_resident()) {                /// * i.e. exec of a ticked word
+        ERROR("%s: not with resident VMs\n", c.name);
+        return;
+    }
+#if T4_INLINE_CACHE
+    _site = 0;                                       /// * no call site, no feedback
+#endif // T4_INLINE_CACHE
     if (c.udf) {                                     /// * userd defined word
         rs.push(ip);
         ip = c.pfa;
         nest();                                      /// * Forth inner loop
     }
-    else (*(FPTR)((UFP)c.xt & MSK_XT))();            /// * execute function
+    else mmu.xcall(c.pfa, this);                     /// * execute function
+}
+#if DO_MULTITASK
+///
+///@name Multitasking
+///@brief messages go thru lock-free inboxes, a blocking op that finds the
+///       queue full/empty parks the VM (WAIT, wop) and tasker() retries it
+///       while all VMs are idle between dispatch rounds, so a parked VM
+///       is never launched and its stacks are safe to touch
+///@{
+__GPU__ int
+ForthVM::task_create(IU pfa) {
+    for (int i = 1; i < T4_VM_COUNT; i++) {          /// * VM0 runs the console
+        ForthVM &t = *_vm[i];
+        if (atomicCAS((int*)&t.state, STOP, WAIT) != STOP) continue;
+        t.reset(pfa, id);                            /// * STOP only set by tasker
+        return i;
+    }
+    ERROR("VM[%d] task: no idle VM\n", id);
+    return -1;
+}
+__GPU__ void
+ForthVM::task_start(int tid) {
+    if (tid < 1 || tid >= T4_VM_COUNT || _vm[tid]->wop != W_NEW) {
+        ERROR("VM[%d] start: %d not a new task\n", id, tid);
+        return;
+    }
+    _vm[tid]->_wake();                               /// * dispatched next round
+}
+__GPU__ void
+ForthVM::reset(IU pfa, int p) {
+    DU v;
+    for (int i = 0; i < ss.idx; i++) DROP(ss[i]);   /// * left over by last task
+    DROP(tos);
+    while (mq.try_pop(&v)) DROP(v);                  /// * and unread messages
+    ss.clear(); rs.clear();
+    rs.push(DU0);                                    /// * EXIT of task word => ip=0
+    tos     = -DU1;
+    ip      = pfa;
+    compile = false;
+    pid     = p;
+    _park(W_NEW);
+}
+__GPU__ void
+ForthVM::join(int tid) {
+    if (tid < 1 || tid >= T4_VM_COUNT || tid == (int)id) {
+        ERROR("VM[%d] join: task %d?\n", id, tid);
+        return;
+    }
+    _park(W_JOIN, tid);
+}
+__GPU__ void
+ForthVM::stop() {
+    if (_io_owner == (int)id) atomicExch(&_io_owner, -1);
+    _park(W_DONE);                                   /// * tasker sets STOP
+}
+__GPU__ void
+ForthVM::send(int tid, int n) {
+    if (tid < 0 || tid >= T4_VM_COUNT || tid == (int)id ||
+        n < 0 || n > ss.idx || n >= T4_MBOX_SZ) {
+        ERROR("VM[%d] send: task %d, n=%d?\n", id, tid, n);
+        return;
+    }
+    if (!_mq_send(*_vm[tid], n)) _park(W_SEND, tid, n);
+}
+__GPU__ void
+ForthVM::recv() {
+    if (!_mq_recv()) _park(W_RECV);
+}
+__GPU__ void
+ForthVM::bcast(int n) {                              /// * tasker delivers to all
+    if (n < 0 || n > ss.idx || n >= T4_MBOX_SZ) {
+        ERROR("VM[%d] bcast: n=%d?\n", id, n);
+        return;
+    }
+    _park(W_SEND, -1, n);
+}
+///
+/// message [n v1 .. vn] claimed in one go, items moved (no refcount change)
+///
+__GPU__ bool
+ForthVM::_mq_send(ForthVM &d, int n) {
+    DU m[T4_MBOX_SZ];
+    m[0] = I2D(n);
+    for (int i = 1; i <= n; i++) m[i] = (i < n) ? ss[i - n] : tos;
+    if (!d.mq.try_push(m, n + 1)) return false;
+    for (int i = 0; i < n; i++) POP();
+    return true;
+}
+__GPU__ bool
+ForthVM::_mq_recv() {
+    DU m[T4_MBOX_SZ];
+    if (!mq.peek(m[0])) return false;
+    int n = D2I(m[0]);
+    if (!mq.try_pop(m, n + 1)) return false;         /// * still being written
+    for (int i = 1; i <= n; i++) PUSH(m[i]);
+    return true;
+}
+__GPU__ void
+ForthVM::pull(int tid, int n) {
+    if (tid < 1 || tid >= T4_VM_COUNT || tid == (int)id || n < 0) {
+        ERROR("VM[%d] pull: task %d, n=%d?\n", id, tid, n);
+        return;
+    }
+    _park(W_PULL, tid, n);
+}
+__GPU__ void
+ForthVM::io_lock() {
+    if (atomicCAS(&_io_owner, -1, (int)id) != -1) _park(W_LOCK);
+}
+__GPU__ void
+ForthVM::io_unlock() {
+    if (_io_owner == (int)id) atomicExch(&_io_owner, -1);
+}
+///
+/// copy top n items of src onto dst (tos of src last), objects shared
+///
+__GPU__ void
+ForthVM::_ss_dup(ForthVM &dst, ForthVM &src, int n) {
+    for (int i = n - 1; i >= 0; i--) {
+        DU v = i ? src.ss[-i] : src.tos;
+        dst.PUSH(src.DUP(v));
+    }
+}
+__GPU__ void
+ForthVM::_ss_drop(ForthVM &src, int n) {
+    for (int i = 0; i < n; i++) src.DROP(src.POP());
 }
 ///
+/// tasker - called by thread 0 of k_ten4_tally, no VM is running
+///
+__GPU__ void
+ForthVM::tasker() {
+    for (int i = 0; i < T4_VM_COUNT; i++) {          /// * ended tasks first
+        ForthVM &v = *_vm[i];
+        if (v.state == WAIT && v.wop == W_DONE) { v.wop = W_NONE; v.state = STOP; }
+    }
+    for (int i = 0; i < T4_VM_COUNT; i++) {
+        ForthVM &v = *_vm[i];
+        if (v.state != WAIT) continue;
+        switch (v.wop) {
+        case W_JOIN:
+            if (_vm[v.wid]->state == STOP) v._wake();
+            break;
+        case W_PULL: {
+            ForthVM &t = *_vm[v.wid];
+            if (t.state != STOP) break;
+            int n = v.wn < t.ss.idx ? v.wn : t.ss.idx;
+            _ss_dup(v, t, n);
+            _ss_drop(t, n);
+            v._wake();
+        } break;
+        case W_SEND: {
+            if (v.wid >= 0) {                        /// * retry a full inbox
+                if (v._mq_send(*_vm[v.wid], v.wn)) v._wake();
+                break;
+            }
+            int ok = 1;                              /// * bcast, room in all?
+            for (int j = 0; j < T4_VM_COUNT; j++) {
+                ForthVM &r = *_vm[j];
+                if (j == i || r.state == STOP) continue;
+                ok &= T4_MBOX_SZ - r.mq.size() > v.wn;
+            }
+            if (!ok) break;
+            for (int j = 0; j < T4_VM_COUNT; j++) {  /// * handles shared by refcount
+                ForthVM &r = *_vm[j];
+                if (j == i || r.state == STOP) continue;
+                DU m[T4_MBOX_SZ];
+                m[0] = I2D(v.wn);
+                for (int k = 1; k <= v.wn; k++) {
+                    m[k] = v.DUP(k < v.wn ? v.ss[k - v.wn] : v.tos);
+                }
+                r.mq.try_push(m, v.wn + 1);
+            }
+            _ss_drop(v, v.wn);
+            v._wake();
+        } break;
+        case W_RECV:
+            if (v._mq_recv()) v._wake();
+            break;
+        case W_LOCK:
+            if (atomicCAS(&_io_owner, -1, i) == -1) v._wake();
+            break;
+        default: break;                              /// * W_NEW waits for start
+        }
+    }
+}
+///@}
+#endif // DO_MULTITASK
+///
 /// dictionary initializer
 ///
 __GPU__ void
@@ -139,7 +350,7 @@ ForthVM::init() {
     if (id != 0) return;  /// * done once only
     VM::init();
     
-    CODE("___ ",    {});  /// dict[0] not used, simplify find(), also keeps _XT0
+    CODE("___ ",    {});  /// dict[0] not used, simplify find()
     CODE("nop",     {});  /// do nothing
     ///
     /// @defgroup Stack ops
@@ -152,8 +363,8 @@ ForthVM::init() {
     CODE("rot",     DU n = ss.pop(); DU m = ss.pop(); ss.push(n); PUSH(m));
     CODE("-rot",    DU n = ss.pop(); DU m = ss.pop(); PUSH(m); PUSH(n));
     CODE("pick",    IU i = D2I(tos); tos = DUP(ss[-i]));
-    CODE("nip",     ss.pop());
-    CODE("?dup",    if (tos != DU0) PUSH(tos));
+    CODE("nip",     DROP(ss.pop()));
+    CODE("?dup",    if (tos != DU0) PUSH(DUP(tos)));
     /// @}
     /// @defgroup Stack ops - double
     /// @{
@@ -279,13 +490,13 @@ ForthVM::init() {
     /// @defgrouop DO..LOOP loops
     /// @{
     IMMD("do" ,     add_p(DO); PUSH(HERE));                // do ( -- here )
-    CODE("i",       PUSH(rs[-1]));
+    CODE("i",       PUSH(DUP(rs[-1])));
     CODE("leave",   rs.pop(); rs.pop(); UNNEST());         // quit DO..LOOP
     IMMD("loop",    add_p(LOOP, POPi));                    // next ( here -- )
     /// @}
     /// @defgrouop return stack ops
     /// @{
-    CODE(">r",      rs.push(POP()));
+    CODE(">r",      rs.push(POP()));                       // moves, reference goes along
     CODE("r>",      PUSH(rs.pop()));
     CODE("r@",      PUSH(DUP(rs[-1])));                    // same as I (the loop counter)
     /// @}
@@ -336,7 +547,7 @@ ForthVM::init() {
     /// be careful with memory access, because
     /// it could make access misaligned which cause exception
     ///
-    CODE("@",     IU i = POPi; PUSH((DU)CELL(i)));          // i -- n
+    CODE("@",     IU i = POPi; PUSH(DUP((DU)CELL(i))));     // i -- n
     CODE("!",     IU i = POPi; CELL(i) = POP(););           // n i --
     CODE("+!",    IU i = POPi; CELL(i) += POP());           // n i --
     CODE("?",     IU i = POPi; sys.dot(DOT, CELL(i)));      // i --
@@ -349,11 +560,11 @@ ForthVM::init() {
     /// @}
 #if DO_MULTITASK    
     /// @defgroup Multitasking ops
-    /// @}
+    /// @{
     CODE("task",                                            // w -- task_id
          IU i = POPi; Code &c = dict[i];                    ///< dictionary index
          if (c.udf) PUSH(task_create(c.pfa));               /// create a task starting on pfa
-         else pstr("  ?colon word only\n"));
+         else sys.pstr("  ?colon word only\n"));
     CODE("rank",  PUSH(id));                                /// ( -- task_id ) used insided a task
     CODE("start", task_start(POPi));                        /// ( task_id -- )
     CODE("join",  join(POPi));                              /// ( task_id -- )
@@ -361,7 +572,13 @@ ForthVM::init() {
     CODE("unlock",io_unlock());                             /// release IO semaphore
     CODE("send",  IU t = POPi; send(t, POPi));              /// ( v1 v2 .. vn n tid -- ) pass values onto task's stack
     CODE("recv",  recv());                                  /// ( -- v1 v2 .. vn ) waiting for values passed by sender
-    CODE("bcast", bcast(POPi));                             /// ( v1 v2 .. vn -- )
+    CODE("send?",                                           /// ( v1 .. vn n tid -- f ) items kept if inbox full
+         int t = POPi; int n = POPi;
+         bool ok = t >= 0 && t < T4_VM_COUNT && t != (int)id &&
+                   n >= 0 && n <= ss.idx && n < T4_MBOX_SZ && _mq_send(*_vm[t], n);
+         PUSH(ok ? -DU1 : DU0));
+    CODE("recv?", PUSH(_mq_recv() ? -DU1 : DU0));           /// ( -- v1 .. vn T | F ) no wait
+    CODE("bcast", bcast(POPi));                             /// ( v1 v2 .. vn n -- ) onto every receiver
     CODE("pull",  IU t = POPi; pull(t, POPi));              /// ( n task_id -- v1 v2 .. vn )
     /// @}
 #endif // DO_MULTITASK    
@@ -381,15 +598,24 @@ ForthVM::init() {
                   sys.op(OP_DUMP, 0, n, a));
     CODE("forget", _forget());
     CODE("trace", sys.trace(POPi));                         // set debug/trace level
+#if T4_INLINE_CACHE
+    CODE("icache", _icon = POPi != 0;                       // ( f -- ) inline cache on/off
+         for (int i = 0; i < T4_IC_SZ; i++) _ic[i].site = 0); // and forget the sites seen
+#endif // T4_INLINE_CACHE
     /// @}
     /// @defgroup OS ops
     /// @{
     CODE("mstat", mmu.status());
+    CODE("mcompact", mmu.compact(); state = HOLD);          // defragment object store at sweep
+    CODE("mtally", mmu.tally());                            // report and reset alloc counters
+    CODE("snapshot", mmu.snap());                           // save dict and pmem to T4_SNAP_FILE
     CODE("rnd",   PUSH(sys.rand(DU1, NORMAL)));             // generate random number
+    CODE("seed",  sys.seed((U64)POPi));                     // restart randomizer with a seed
     CODE("ms",    delay(POPi));
-//    CODE("included",                                      // include external file
-//         POP();                                           // string length, not used
-//         sys.load(MEM(POP())));                           // include external file
+    CODE("included",                                        // ( adr len -- ) include external file
+         POP();                                             // string length, not used
+         sys.op(OP_INCL); sys.op_fn((char*)MEM(POPi));      // host streams it in chunks
+         sys.hold());                                       // rest of input after the file
     CODE("clock", DU t = sys.ms(); SCALAR(t); PUSH(t));
     CODE("bye",   state = STOP);                            // atomicExch(&state, STOP)
     ///@}
@@ -417,9 +643,13 @@ ForthVM::parse(char *idiom) {
         return 0;                         /// * next, try as a number
     }
     Code &c = dict[w];
+    if (c.cdp && sys.is_resident()) {     /// * no child kernel in a cooperative launch
+        ERROR("%s: not with resident VMs\n", c.name);
+        return 0;                         /// * fails as unknown word, line dropped
+    }
 #if T4_VERBOSE > 1    
     INFO("%04x[%3x]%c%c %s",
-         c.udf ? c.pfa : mmu.XTOFF(c.xt), w,
+         c.pfa, w,
          c.imm ? '*' : ' ', c.udf ? 'u' : ' ',
          c.name);
 #endif // T4_VERBOSE     > 1
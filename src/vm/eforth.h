@@ -8,6 +8,7 @@
 #define __VM_EFORTH_H
 #include "vm.h"                         ///< VM base class in ../vm
 #include "param.h"                      ///< Parameter field
+#include "ring.h"                       ///< inter-VM queues, in ../mmu
 ///
 /// Forth Virtual Machine operational macros to reduce verbosity
 /// Note:
@@ -49,12 +50,45 @@
 ///@}
 ///@name Forth Virtual Machine class
 ///@{
+#if DO_MULTITASK
+typedef enum {                        ///< what a WAIT VM is parked on
+    W_NONE = 0,                       ///< runnable
+    W_NEW,                            ///< task created, not started
+    W_DONE,                           ///< task ended, STOP at next tick
+    W_JOIN,                           ///< join, wid stopped
+    W_SEND,                           ///< wid inbox full (-1 bcast), wn items
+    W_RECV,                           ///< own inbox empty
+    W_PULL,                           ///< pull wn items from stopped wid
+    W_LOCK                            ///< IO lock held by another VM
+} wait_op;
+#endif // DO_MULTITASK
+#if T4_INLINE_CACHE
+typedef enum {                        ///< operand kinds seen at a call site
+    IC_NONE = 0,                      ///< not cached, generic path
+    IC_SS,                            ///< scalar-scalar
+    IC_TS,                            ///< tensor-scalar
+    IC_TT                             ///< tensor-tensor of the same shape
+} ic_kind;
+typedef struct {                      ///< inline cache entry, one per call site
+    IU  site;                         ///< pmem offset of the Param, 0 empty
+    IU  w;                            ///< built-in called there (primitive index)
+    U8  kind;                         ///< ic_kind
+    U8  op;                           ///< math_op of the built-in
+    U8  drop;                         ///< t4_drop_opt of the built-in
+    U8  xx;                           ///< padding
+} t4_ic;
+#endif // T4_INLINE_CACHE
+
 class ForthVM : public VM {
 public:
     __GPU__ ForthVM(int id, System &sys);
     
     __GPU__ virtual void init();      ///< override VM
     
+#if DO_MULTITASK
+    __GPU__ static void tasker();     ///< resolve parked VMs, all VMs idle
+#endif // DO_MULTITASK
+    
 protected:
     IU    ip     = 0;                 ///< instruction pointer
     DU    tos    = -DU1;              ///< cached top of stack
@@ -80,6 +114,48 @@ protected:
     ///
     __GPU__ void nest();                      ///< inner interpreter
     __GPU__ void call(IU w);                  ///< execute word by index
+    __GPU__ __INLINE__ void _ss_op(math_op op) {  ///< scalar-scalar ops
+        switch (op) {
+        case ADD:  tos = ADD(ss.pop(), tos); break;
+        case SUB:  tos = SUB(ss.pop(), tos); break;
+        case MUL:  tos = MUL(ss.pop(), tos); break;
+        case DIV:  tos = DIV(ss.pop(), tos); break;
+        case MOD:  tos = MOD(ss.pop(), tos); break;
+        case MAX:  tos = MAX(ss.pop(), tos); break;
+        case MIN:  tos = MIN(ss.pop(), tos); break;
+        case MUL2: tos = MUL2(ss.pop(), tos); break;
+        case MOD2: tos = MOD2(ss.pop(), tos); break;
+        default:   break;
+        }
+        SCALAR(tos);                          /// * even +- can set LSB (rounding)
+    }
+#if T4_INLINE_CACHE
+    ///
+    /// inline cache, TensorVM::xop2 feeds the operand kinds seen at the
+    /// call site into this VM's table, the next call at the same site
+    /// takes the scalar pair right here or the tensor kinds thru icall,
+    /// a guard miss falls back to the generic path which feeds again
+    ///
+    IU    _site  = 0;                 ///< call site of the running built-in, 0 none
+    bool  _icon  = true;              ///< inline cache enabled
+    t4_ic _ic[T4_IC_SZ] = {};         ///< direct mapped by call site
+    __GPU__ virtual int icall(t4_ic &c) { return 0; } ///< tensor kinds, 0 on guard miss
+    __GPU__ __INLINE__ void _xcall(Param &ix) {
+        IU    s = ip - sizeof(IU);            /// * ip already advanced
+        t4_ic &c = _ic[(s / sizeof(IU)) & (T4_IC_SZ - 1)];
+        if (_icon && c.site == s && c.w == ix.ioff) {
+            if (c.kind == IC_SS) {            /// * no call at all
+                if (!IS_OBJ(tos) && !IS_OBJ(ss[-1])) { _ss_op((math_op)c.op); return; }
+            }
+            else if (icall(c)) return;        /// * guard held, specialized
+        }
+        _site = _icon ? s : 0;                /// * generic path, feeds kinds
+        mmu.xcall(ix.ioff, this);
+        _site = 0;
+    }
+#else  // !T4_INLINE_CACHE
+    __GPU__ __INLINE__ void _xcall(Param &ix) { mmu.xcall(ix.ioff, this); }
+#endif // T4_INLINE_CACHE
     ///
     /// stack operator short hands
     ///
@@ -87,7 +163,10 @@ protected:
     __GPU__ __INLINE__ DU   POP()      { DU n=tos; tos=ss.pop(); return n; }
     __GPU__ __INLINE__ DU   PUSH(DU v) { ss.push(tos); return tos = v;     }
 #if T4_ENABLE_OBJ    
-    __GPU__ __INLINE__ DU   DUP(DU d)  { return IS_OBJ(d) ? AS_VIEW(d) : d; }  ///< soft copy
+    __GPU__ __INLINE__ DU   DUP(DU d)  {                  ///< soft copy, shared until written
+        if (IS_OBJ(d)) { mmu.du2obj(d).ref_inc(); AS_VIEW(d); }
+        return d;
+    }
     __GPU__ __INLINE__ void DROP(DU d) { if (IS_OBJ(d)) mmu.drop(mmu.du2obj(d)); }
 #else  // !T4_ENABLE_OBJ
     __GPU__ __INLINE__ DU   DUP(DU d)  { return d; }
@@ -101,9 +180,8 @@ protected:
     __GPU__ __INLINE__ void add_w(Param p) { add_iu(p.pack); }
     __GPU__ void add_w(IU w) {                ///< compile a word index into pmem
         Code &c = dict[w];
-        IU   ix = c.udf ? c.pfa : mmu.XTOFF(c.xt);
-        DEBUG(" add_w(%d) => ioff=%x %s\n", w, ix, c.name);
-        Param p(MAX_OP, ix, c.udf);
+        DEBUG(" add_w(%d) => ioff=%x %s\n", w, c.pfa, c.name);
+        Param p(MAX_OP, c.pfa, c.udf);           /// * pfa or primitive table index
         add_w(p);
     }
     __GPU__ int  add_str(const char *s, bool adv=true) {
@@ -123,6 +201,39 @@ protected:
     }
     
 private:    
+#if DO_MULTITASK
+    wait_op wop  = W_NONE;            ///< parked on
+    int     wid  = -1;                ///< peer VM of the parked op
+    int     wn   = 0;                 ///< number of stack items to pass
+    MPMC<DU, T4_MBOX_SZ> mq;          ///< inbox, [n v1 .. vn] per message
+    ///
+    /// task life cycle methods
+    ///
+    __GPU__ int  task_create(IU pfa); ///< claim an idle VM for a colon word
+    __GPU__ void task_start(int tid); ///< make created task runnable
+    __GPU__ void reset(IU pfa, int p);///< reset stacks, ip to pfa
+    __GPU__ void join(int tid);       ///< wait for the given task to end
+    __GPU__ void stop();              ///< task ended
+    ///
+    /// messaging interface, blocking ops park the VM (WAIT) when the
+    /// queue is full/empty, tasker retries them between rounds
+    ///
+    __GPU__ void send(int tid, int n);///< n items into tid's inbox
+    __GPU__ void recv();              ///< next message from own inbox
+    __GPU__ void bcast(int n);        ///< n items into every live VM's inbox
+    __GPU__ void pull(int tid, int n);///< n items from the stack of a stopped task
+    __GPU__ bool _mq_send(ForthVM &d, int n);  ///< non-blocking, moves n items
+    __GPU__ bool _mq_recv();                   ///< non-blocking, pushes a message
+    __GPU__ void io_lock();           ///< wait for IO lock
+    __GPU__ void io_unlock();         ///< release IO lock
+    
+    __GPU__ void _park(wait_op op, int tid=-1, int n=0) {
+        wop = op; wid = tid; wn = n; state = WAIT;
+    }
+    __GPU__ void _wake() { wop = W_NONE; state = NEST; }
+    __GPU__ static void _ss_dup(ForthVM &dst, ForthVM &src, int n);
+    __GPU__ static void _ss_drop(ForthVM &src, int n);
+#endif // DO_MULTITASK
     ///
     /// compiler helpers
     ///
@@ -253,6 +253,7 @@ NetVM::_loss(t4_loss op) {
 ///
 __GPU__ void
 NetVM::init() {
+    if (id != 0) return;                      /// * words added once, run on every VM
     TensorVM::init();
     ///
     ///@defgroup Model creation and persistence
@@ -357,6 +358,21 @@ NetVM::init() {
     CODE("trainable",
          if (M1V) { bool on = POPi; MTOS.train = on; }
          else ERROR("N [1|0] required\n"));
+    CODE("nn.infer",                            ///> (N 1|0 -- N) inference mode
+         if (M1V) { bool on = POPi; MTOS.inference(on); }
+         else ERROR("N [1|0] required\n"));
+    CODE("nn.plan",                             ///> (N 0|1|2 -- N) activation planner
+         if (M1V) { int m = POPi; MTOS.plan(m); }
+         else ERROR("N [0|1|2] required\n"));
+    CODE("nn.fuse",                             ///> (N 1|0 -- N) fused conv2d blocks
+         if (M1V) { bool on = POPi; MTOS.fuse(on); }
+         else ERROR("N [1|0] required\n"));
+    CODE("nn.pipe",                             ///> (N n -- N) n micro-batches per forward
+         if (M1V) { int n = POPi; MTOS.pipe(n); }
+         else ERROR("N n required\n"));
+    CODE("nn.dp",                               ///> (N n -- N) n data-parallel replicas
+         if (M1V) { int n = POPi; MTOS.dp(n); }
+         else ERROR("N n required\n"));
     CODE("batchsize",
          if (IS_M(top)) PUSH(MTOS.batch_size());
          else ERROR("TOS is not a model?\n"));
@@ -388,6 +404,21 @@ NetVM::init() {
          }
          else if (IS_M(top)) MTOS.backprop();          /// * use default output
          else ERROR("TOS not a model?\n"));
+    CODE("predict",                             /// * inference-only forward (INT8 conv/linear)
+         if (IS_M(ss[-1]) && TOS1D) {           /// * TOS is a dataset
+             DU x = POP();
+             MTOS.predict((Tensor&)T4Base::du2obj(x));
+             DROP(x);
+         }
+         else if (IS_M(top) && IS_OBJ(rs[-1])) {       /// * in a for/next loop
+             Tensor &t = (Tensor&)T4Base::du2obj(rs[-1]);
+             if (t.is_dataset()) MTOS.predict(t);
+             else ERROR("rs[-1] is not a dataset?\n");
+         }
+         else ERROR("no model or a dataset?\n"));
+    CODE("nn.quantize",                         /// * INT8 post-training quantization
+         if (IS_M(top)) MTOS.quantize();
+         else ERROR("TOS is not a model?\n"));
     CODE("broadcast",
          if (IS_M(ss[-1]) && TOS1T) {                  /// * TOS is a onehot vector
              DU y = POP();
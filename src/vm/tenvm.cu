@@ -8,6 +8,32 @@
 
 #if T4_ENABLE_OBJ
 ///
+/// a run of literals already parsed by host Compiler, taken as one block
+///
+__GPU__ int
+TensorVM::pre(char *idiom) {
+    if (*idiom != T4_LIT_MARK) return 0;      /// * not a literal block
+    int n  = (int)STRTOL(idiom + 1, NULL, 10);
+    DU  *v = sys.lit(n);
+    if (!v) return 0;                         /// * nothing staged, let process fail
+
+    if (compile) {                            /// * as process, literal by literal
+        for (int i = 0; i < n; i++) add_lit(v[i]);
+    }
+    else if (ten_lvl > 0) {                   /// * straight into tensor storage
+        Tensor &t = TTOS;
+        U64    r  = ten_off < t.numel ? t.numel - ten_off : 0;  ///< room left
+        int    m  = (U64)n < r ? n : (int)r;
+        VLOG2("%d> T[%d..%d]\n", id, ten_off, ten_off + n - 1);
+        MEMCPY(&t.data[ten_off], v, m * sizeof(DU));
+        ten_off += n;
+    }
+    else {
+        for (int i = 0; i < n; i++) PUSH(v[i]);
+    }
+    return 1;
+}
+///
 /// override with tensor handler
 ///
 __GPU__ int
@@ -64,7 +90,7 @@ TensorVM::xop1(math_op op, DU v) {
     ///
     /// single tensor handler (destructive)
     ///
-    Tensor &A = TTOS;
+    Tensor &A = _cow(tos);
     if (!A.is_tensor()) { ERROR("tensor?"); return; }
 
     OPN(MATH_OP);
@@ -94,12 +120,45 @@ TensorVM::xop1(math_op op, DU v) {
 ///
 __GPU__ void
 TensorVM::xop2(math_op op, t4_drop_opt x) {
-    const char *fn = "tenvm#xop2";
-    OPN(MATH_OP);
     ///
     /// 2-operand operator (broadcasting)
     ///
-    int tt = (IS_OBJ(ss[-1]) ? 2 : 0) | (IS_OBJ(tos) ? 1 : 0); 
+    int tt = (IS_OBJ(ss[-1]) ? 2 : 0) | (IS_OBJ(tos) ? 1 : 0);
+#if T4_INLINE_CACHE
+    if (_site) {                                  /// * feed kinds to the call site
+        t4_ic &c = _ic[(_site / sizeof(IU)) & (T4_IC_SZ - 1)];
+        c.site = _site;
+        c.w    = ((Param*)MEM(_site))->ioff;
+        c.kind = tt==0 ? IC_SS : tt==2 ? IC_TS
+               : (tt==3 && TNOS.is_same_shape(TTOS)) ? IC_TT : IC_NONE;
+        c.op   = (U8)op;
+        c.drop = (U8)x;
+        _site  = 0;                               /// * only the outermost xop2
+    }
+#endif // T4_INLINE_CACHE
+    _xop2(op, x, tt);
+}
+#if T4_INLINE_CACHE
+///
+/// cached call site, replays xop2 when the operands still match the kind
+///
+__GPU__ int
+TensorVM::icall(t4_ic &c) {
+    bool a = IS_OBJ(ss[-1]), b = IS_OBJ(tos);     ///< guard
+    switch (c.kind) {
+    case IC_TS: if (!a || b) return 0; break;
+    case IC_TT: if (!a || !b || !TNOS.is_same_shape(TTOS)) return 0; break;
+    default:    return 0;
+    }
+    _xop2((math_op)c.op, (t4_drop_opt)c.drop, c.kind==IC_TS ? 2 : 3);
+    return 1;
+}
+#endif // T4_INLINE_CACHE
+
+__GPU__ void
+TensorVM::_xop2(math_op op, t4_drop_opt x, int tt) {
+    const char *fn = "tenvm#xop2";
+    OPN(MATH_OP);
     switch (tt) {                                 /// tensor flags
     case 0 /* ss */: _ss_op(op); break;           /// * scalar-scalar op ( a b -- c  )
     case 1 /* st */: {                            /// * scalar-tensor op ( n T -- T' )
@@ -141,6 +200,7 @@ TensorVM::blas1(t4_ten_op op) {
     const char *fn = "tenvm#blas1";
     OPN(TENSOR_OP);
     Tensor &A  = TTOS;
+    if (A.is_tensor() && A.rank == 4) { _tbatch(op, A); return; }
     if (!A.is_tensor() || A.rank != 2) { ERROR("tensor2?"); return; }
     
     VLOG2("%s %s(A[%d,%d]) =>{\n", fn, opn[op], A.H(), A.W());
@@ -155,7 +215,7 @@ TensorVM::blas1(t4_ten_op op) {
         PUSH(I);                              /// * put on TOS
         tx = false;                           /// * _tinv create its own temp
     } break;
-    case T_DET: {                             /// * TODO: use PLU
+    case T_DET: {                             /// * PLU, product of diagonal
         int    ns;                            ///> number of row flipping
         Tensor &P = mmu.tensor(A.H());        /// * dummy vector
         Tensor::plu(T, P, &ns);               /// * decompose A to PLU
@@ -166,9 +226,14 @@ TensorVM::blas1(t4_ten_op op) {
         tx = false;
     } break;
     case T_LU:  Tensor::lu(T);    break;      /// * decompose A to LU
-    case T_LUINV:
+    case T_LUINV: {
+        Tensor &I = mmu.tensor(A.H(), A.W());
         Tensor::lu(T);                        /// * create the LU matrix
-        Tensor::lu_inverse(T);    break;      /// * inverse it 
+        if (Tensor::lu_inverse(T, I)) FREE(I);/// * singular, stack unchanged
+        else PUSH(I);                         /// * inverse it
+        FREE(T);
+        tx = false;
+    } break;
     case T_TRIU: T.triu();        break;
     case T_TRIL: T.tril();        break;
     case T_XPOS:
@@ -215,7 +280,7 @@ TensorVM::blas2(t4_ten_op op, t4_drop_opt x) {
     } break;
     case T_SOLV: {              ///< solve B = AX
         Tensor &X = _solv(A, B);
-        PUSH(X);
+        if (X != A) PUSH(X);                 /// * dim or singular, stack unchanged
         VLOG2("} %s => X[%d,%d]\n", fn, X.H(), X.W());
     } break;
     default:
@@ -223,26 +288,11 @@ TensorVM::blas2(t4_ten_op op, t4_drop_opt x) {
     }
 }
 ///
-/// scalar-scalar ops
+/// scalar-scalar ops in ForthVM::_ss_op (inline cache takes them there)
 ///
-__GPU__ __INLINE__ void
-TensorVM::_ss_op(math_op op) {               ///< scalar-scalar ops
-    switch (op) {
-    case ADD:  tos = ADD(ss.pop(), tos); break;
-    case SUB:  tos = SUB(ss.pop(), tos); break;
-    case MUL:  tos = MUL(ss.pop(), tos); break;
-    case DIV:  tos = DIV(ss.pop(), tos); break;
-    case MOD:  tos = MOD(ss.pop(), tos); break;
-    case MAX:  tos = MAX(ss.pop(), tos); break;
-    case MIN:  tos = MIN(ss.pop(), tos); break;
-    case MUL2: tos = MUL2(ss.pop(), tos); break;
-    case MOD2: tos = MOD2(ss.pop(), tos); break;
-    }
-    SCALAR(tos);                              /// * even +- can set LSB (rounding)
-}
-
 __GPU__ __INLINE__ Tensor&
 TensorVM::_st_op(math_op op, t4_drop_opt x) { ///< scalar tensor op
+    if (x!=T_KEEP) _cow(tos);                 /// * in-place on a private tensor
     Tensor &A = TTOS;                         /// * Tensor on TOS
     DU     v  = ss[-1];                       /// * scalar as NOS
     Tensor &O = x==T_KEEP ? COPY(A) : A;      /// * make a hard copy (and parameters)
@@ -259,6 +309,7 @@ TensorVM::_st_op(math_op op, t4_drop_opt x) { ///< scalar tensor op
 
 __GPU__ __INLINE__ Tensor&
 TensorVM::_ts_op(math_op op, t4_drop_opt x) { ///< tensor scalar op
+    if (x!=T_KEEP) _cow(ss[-1]);              /// * in-place on a private tensor
     Tensor &A = TNOS;                         ///< tensor on NOS
     Tensor &O = x==T_KEEP ? COPY(A) : A;      ///< make a hard copy of A
     Tensor::ten_op(op, A, tos, O);            /// * broadcast_op(tensor, scalar)
@@ -303,6 +354,53 @@ TensorVM::_tinv(Tensor &A) {                 ///< matrix inverse
     return I;
 }
 
+///
+/// batched inverse, det, lu of N small square slices [N,n,n,1]
+///
+__GPU__ void
+TensorVM::_tbatch(t4_ten_op op, Tensor &A) {
+    U32 N = A.N(), n = A.H();
+    VLOG2("tenvm#_tbatch %s(A[%d,%d,%d,%d])\n", opn[op], N, n, A.W(), A.C());
+    if (n != A.W() || A.C() != 1) { ERROR("[N,n,n,1] tensor?"); return; }
+
+    Tensor &T = COPY(A);                     ///< L\U slices
+    switch (op) {
+    case T_INV: {
+        Tensor &I = mmu.tensor(N, n, n, 1);
+        if (Tensor::batch_plu(T, NULL, NULL, &I)) FREE(I); /// * singular, stack unchanged
+        else PUSH(I);                        /// * PLU + solve per slice
+        FREE(T);
+    } break;
+    case T_DET: {
+        Tensor &D = mmu.tensor(N);           ///< one determinant per slice
+        if (Tensor::batch_plu(T, NULL, &D) < 0) FREE(D);
+        else PUSH(D);                        /// * NaN for singular slices
+        FREE(T);
+    } break;
+    case T_LU:                               /// * no pivot, as lu
+        if (Tensor::batch_plu(T, NULL, NULL, NULL, false) < 0) FREE(T);
+        else PUSH(T);
+        break;
+    default:
+        ERROR("opn[%d] not batched\n", op);
+        FREE(T);
+    }
+}
+
+///
+/// copy-on-write, replace a shared tensor handle by a private hard copy
+///
+__GPU__ Tensor&
+TensorVM::_cow(DU &v) {
+    Tensor &t = (Tensor&)mmu.du2obj(v);
+    if (!t.is_tensor() || t.nref < 2) return t;   /// * sole owner, write in-place
+    Tensor &t1 = COPY(t);
+    VLOG2("tenvm#_cow T[%d] nref=%d => copy\n", t.rank, t.nref);
+    if (!t.ref_dec()) FREE(t);                /// * other owners dropped meanwhile
+    v = mmu.obj2du(t1);                       /// * private handle (not a view)
+    return t1;
+}
+
 __GPU__ __INLINE__ Tensor&
 TensorVM::_tdiv(Tensor &A, Tensor &B) {      ///< tensor division
     U16 m = A.H(), ka = A.W(), kb = B.H(), n = B.W();
@@ -332,6 +430,15 @@ TensorVM::_tdot(Tensor &A, Tensor &B) {      ///< A x B tensor dot product
               A.H(), A.W(), B.H(), C.H());
         return C;
     }
+    if (A.W()==B.H() && B.rank==4) {         /// * batched, A broadcast or per slice
+        if (A.rank==4 && A.N()!=B.N() && A.N()!=1) { ERROR("A.N!=B.N?"); return A; }
+        Tensor &C = mmu.tensor(B.N(), A.H(), B.W(), B.C());
+        Tensor::mm(A, B, C);
+        VLOG2("tenvm#_tdot A[%d,%d] · B[%d,%d,%d,%d] => C[%d,%d,%d,%d]\n",
+              A.H(), A.W(), B.N(), B.H(), B.W(), B.C(),
+              C.N(), C.H(), C.W(), C.C());
+        return C;
+    }
     if (A.W()==B.H()) {                      /// * tensor @ tensor
         Tensor &C = mmu.tensor(A.H(), B.W());
         Tensor::mm(A, B, C);
@@ -351,10 +458,15 @@ TensorVM::_solv(Tensor &B, Tensor &A) {      /// Note: A, B flipped
     
     if (B.rank!=1 || m!=k || k!=n) return B;
 
-    Tensor &I = _tinv(A);
+    int    ns;                               ///< row swaps (not used)
+    Tensor &P = mmu.tensor(k);               /// * permutation vector
+    Tensor &X = COPY(A);                     /// * LU temp, keep A untouched
     Tensor &O = mmu.tensor(k);               /// resultant vector
-    Tensor::mm(I, B, O);                     /// O = A^-1 x B
-    FREE(I);
+    Tensor::plu(X, P, &ns);                  /// * PA = LU
+    int    err = Tensor::lu_solve(X, P, B, O); /// * O = A^-1 x B by substitution
+    FREE(X);
+    FREE(P);
+    if (err) { FREE(O); return B; }          /// * singular, i.e. skip in xop2
     
     return O;
 }
@@ -406,6 +518,7 @@ __GPU__ void
 TensorVM::init() {
     if (id !=0) return;                       /// * only needed once
     ForthVM::init();
+    mmu.kids(true);                           /// * words below may launch child kernels
     ///
     ///@defgroup Tensor creation ops
     ///@brief - stick to PyTorch naming when possible
@@ -453,20 +566,25 @@ TensorVM::init() {
     ///@{
     CODE("={",                                 ///< (n -- ) or ( -- )
          ten_off = IS_OBJ(tos) ? 0 : POPi;
+         if (IS_OBJ(tos)) _cow(tos);
          ten_lvl = IS_OBJ(tos) ? 1 : 0);
     CODE("zeros", xop1(FILL, DU0));            ///< fill tensor with 0s
     CODE("ones",  xop1(FILL, DU1));            ///< fill tensor with 1s
     CODE("full",  xop1(FILL, POP()));          ///< fill tensor with a value
     CODE("gradfill", xop1(GFILL, DU1));        ///< gradient fill a tensor
     CODE("eye",   xop1(IDEN));                 ///< fill 1s in diag
-    CODE("rand",  tos = sys.rand(tos, UNIFORM));   ///< uniform randomize a tensor or number
-    CODE("randn", tos = sys.rand(tos, NORMAL));    ///< normal dist. randomize a tensor
+    CODE("rand",                               ///< uniform randomize a tensor or number
+         if (IS_OBJ(tos)) _cow(tos);
+         tos = sys.rand(tos, UNIFORM));
+    CODE("randn",                              ///< normal dist. randomize a tensor
+         if (IS_OBJ(tos)) _cow(tos);
+         tos = sys.rand(tos, NORMAL));
     ///@}
     ///@defgrup Tensor slice and dice
     ///@{
     CODE("normalize",
          DU std = POP(); DU avg = POP();
-         if (TOS1T) { TTOS.normalize(std, avg); });
+         if (TOS1T) { _cow(tos).normalize(std, avg); });
     CODE("sum", if (TOS1T) PUSH(TTOS.sum()));
     CODE("avg", if (TOS1T) PUSH(TTOS.avg()));
     CODE("std", if (TOS1T) PUSH(TTOS.std()));
@@ -485,7 +603,7 @@ TensorVM::init() {
              SCALAR(v);
              PUSH(v);
          });
-    CODE("t!",  DU v = POP(); IU i = POPi; if (IS_OBJ(tos)) TTOS[i]=v);
+    CODE("t!",  DU v = POP(); IU i = POPi; if (IS_OBJ(tos)) _cow(tos)[i]=v);
     ///@}
     ///@defgroup 1-tensor ops in-place (i.e. destructive, as in Forth)
     ///@{
@@ -503,7 +621,7 @@ TensorVM::init() {
     ///@defgroup BLAS, 1-tensor ops, that create new tensor
     ///@brief - stick to PyTorch naming when possible
     ///@{
-    CODE("inverse",   blas1(T_INV));          ///< (A -- A Ai')   matrix inversion (GaussJordan)
+    CODE("inverse",   blas1(T_INV));          ///< (A -- A Ai')   matrix inversion (PLU)
     CODE("det",       blas1(T_DET));          ///< (A -- A d)     matrix determinant
     CODE("lu",        blas1(T_LU));           ///< (A -- A A')    LU decomposition
     CODE("luinv",     blas1(T_LUINV));        ///< (A -- A A')    inverse the LU matrix
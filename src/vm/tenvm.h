@@ -38,6 +38,7 @@ protected:
     ///
     /// override literal handler
     ///
+    __GPU__ virtual int pre(char *str);     ///< literal block parsed on host
     __GPU__ virtual int process(char *str); ///< TODO: CC - worked without 'final', why?
     ///
     /// stack operator short hands (override eforth.h)
@@ -51,6 +52,7 @@ protected:
             : d;
     }
     __GPU__ __INLINE__ Tensor &COPY(Tensor &t) { return mmu.copy(t); }
+    __GPU__ Tensor &_cow(DU &v);                            ///< private copy before write
     ///
     /// tensor ops based on number of operands
     ///
@@ -58,12 +60,15 @@ protected:
     __GPU__ void xop2(math_op op, t4_drop_opt x=T_KEEP);    ///< 2-operand ops
     __GPU__ void blas1(t4_ten_op op);                       ///< 1-operand ops with new tensor
     __GPU__ void blas2(t4_ten_op op, t4_drop_opt x=T_KEEP); ///< 2-operand tensor ops
+#if T4_INLINE_CACHE
+    __GPU__ virtual int icall(t4_ic &c);                    ///< cached tensor kinds, guarded
+#endif // T4_INLINE_CACHE
     
 private:
     ///
     /// tensor ops based on data types
     ///
-    __GPU__ void   _ss_op(math_op op);                      ///< scalar-scalar (eForth) ops
+    __GPU__ void   _xop2(math_op op, t4_drop_opt x, int tt); ///< 2-operand ops by kinds
     __GPU__ Tensor &_st_op(math_op op, t4_drop_opt x);      ///< scalar tensor op (broadcast)
     __GPU__ Tensor &_ts_op(math_op op, t4_drop_opt x);      ///< tensor scalar op (broadcast)
     __GPU__ Tensor &_tt_op(math_op op);                     ///< tensor tensor op
@@ -71,6 +76,7 @@ private:
     /// tensor-tensor ops
     ///
     __GPU__ Tensor &_tinv(Tensor &A);                       ///< matrix inversion
+    __GPU__ void   _tbatch(t4_ten_op op, Tensor &A);        ///< batched small matrix ops
     __GPU__ Tensor &_tdot(Tensor &A, Tensor &B);            ///< matrix-matrix multiplication @
     __GPU__ Tensor &_tdiv(Tensor &A, Tensor &B);            ///< matrix-matrix division (no broadcast)
     __GPU__ Tensor &_solv(Tensor &A, Tensor &B);            ///< solve linear equation Ax = b
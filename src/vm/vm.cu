@@ -28,7 +28,9 @@ VM::VM(int id, System &sys)
 __GPU__ void
 VM::outer() {
     char *idiom;
-    while ((idiom = sys.fetch())!=0) {               /// * loop throught tib
+    if ((id || state==NEST) && resume()) return;     /// * task or woken word continued
+    while (state!=WAIT &&                            /// * parked on task op
+           (idiom = sys.fetch())!=0) {               /// * loop throught tib
         DEBUG("%d> idiom='%s' => ", id, idiom);
         if (pre(idiom)) continue;                    /// * pre process (filter)
         if (!process(idiom)) {
@@ -18,11 +18,15 @@
 ///@}
 ///@name virtual machine base class
 ///@{
-typedef enum { STOP=0, HOLD, QUERY, NEST } vm_state;   ///< ten4 states
+typedef enum { STOP=0, HOLD, QUERY, NEST, WAIT } vm_state;   ///< ten4 states
+#define VM_STATES 5                   /**< number of vm_state, for tally  */
 class VM {                            ///< VM (created in kernal mode)
 public:
     IU        id;                     ///< VM id
     vm_state  state   = STOP;         ///< VM state
+#if DO_MULTITASK
+    int       pid     = -1;           ///< creator VM of a task, -1 for none
+#endif // DO_MULTITASK
     
     System    &sys;                   ///< system interface
     MMU       &mmu;                   ///< cached MMU interface
@@ -46,28 +50,9 @@ protected:
     __GPU__ virtual int process(char *str) { return 0; }
     __GPU__ virtual int post()             { return 0; }
     
-#if DO_MULTITASK    
-    static MUTEX    tsk;              ///< mutex for tasker
-    static COND_VAR cv_tsk;           ///< tasker control
-    
-    static void _ss_dup(VM &dst, VM &src, int n);
-    ///
-    /// task life cycle methods
-    ///
-    void reset(IU w, vm_state st);    ///< reset a VM user variables
-    void join(int tid);               ///< wait for the given task to end
-    void stop();                      ///< stop VM
-    ///
-    /// messaging interface
-    ///
-    void send(int tid, int n);        ///< send onto destination VM's stack (blocking, wait for receiver availabe)
-    void recv();                      ///< receive data from any sending VM's stack (blocking, wait for sender's message)
-    void bcast(int n);                ///< broadcast to all receivers
-    void pull(int tid, int n);        ///< pull n items from the stack of a stopped task
-#else  // DO_MULTITASK
-    
+#if !DO_MULTITASK                     /// * tasks in ForthVM (tasker needs ip, tos)
     void set_state(vm_state st) { state = st; }
-#endif // DO_MULTITASK    
+#endif // !DO_MULTITASK    
 };
 ///@}
 #endif // __VM_VM_H
@@ -0,0 +1,79 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth data-parallel backprop, replica dw/db folded into the model
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <vector>
+#include <math.h>
+#include "t_ten4.h"
+
+#if T4_ENABLE_NN
+///
+/// same batch backprops with 1, 2 and 4 replicas (nn.dp), conv and
+/// linear dw/db are copied out after each pass and printed
+///
+static const char *_src = R"(
+0 trace
+8 8 8 1 nn.model
+0.5 4 conv2d relu flatten 0.5 10 linear softmax
+0 nn.fuse
+constant md
+8 8 8 1 tensor randn constant x
+8 1 1 10 tensor rand constant y
+: step ( n -- ) md swap nn.dp nn.zero x forward y backprop drop ;
+: dw ( i -- T ) md swap nn.dw copy nip nip ;
+: db ( i -- T ) md swap nn.db copy nip nip ;
+1 step 1 dw constant w1 4 db constant b1
+2 step 1 dw constant w2 4 db constant b2
+4 step 1 dw constant w4 4 db constant b4
+1 step
+.( [w1] ) w1 . .( [w2] ) w2 . .( [w4] ) w4 .
+.( [b1] ) b1 . .( [b2] ) b2 . .( [b4] ) b4 . .( [e] ) cr
+)";
+///
+/// numbers of a printed tensor
+///
+std::vector<double> nums(const std::string &s) {
+    std::vector<double> v;
+    const char *p = s.c_str();
+    while (*p) {
+        bool num = (*p >= '0' && *p <= '9') ||
+            (*p == '-' && p[1] >= '0' && p[1] <= '9');
+        if (!num) { p++; continue; }
+        char *q;
+        v.push_back(strtod(p, &q));
+        p = q;
+    }
+    return v;
+}
+///
+/// replicas sum their shards in another order, so allow rounding
+///
+bool same(const std::string &a, const std::string &b) {
+    std::vector<double> x = nums(a), y = nums(b);
+    if (!x.size() || x.size() != y.size()) return false;
+    for (size_t i = 0; i < x.size(); i++) {
+        if (fabs(x[i] - y[i]) > 1e-4 * (1.0 + fabs(x[i]))) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    T4Run t(_src);
+    std::string w1 = t.between("[w1]", "[w2]"), b1 = t.between("[b1]", "[b2]");
+
+    t4_check(nums(w1).size() > 0,                   "conv dw, 1 replica");
+    t4_check(same(w1, t.between("[w2]", "[w4]")),   "conv dw, 2 replicas folded");
+    t4_check(same(w1, t.between("[w4]", "[b1]")),   "conv dw, 4 replicas folded");
+    t4_check(nums(b1).size() > 0,                   "linear db, 1 replica");
+    t4_check(same(b1, t.between("[b2]", "[b4]")),   "linear db, 2 replicas folded");
+    t4_check(same(b1, t.between("[b4]", "[e]")),    "linear db, 4 replicas folded");
+    return t4_done("t_allreduce");
+}
+#else  // !T4_ENABLE_NN
+int main(int argc, char **argv) {
+    printf("t_allreduce skipped, T4_ENABLE_NN=0\n");
+    return 0;
+}
+#endif // T4_ENABLE_NN
@@ -0,0 +1,89 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth host Compiler, colon words vs the device : compile
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <vector>
+#include "t_ten4.h"
+///
+/// every body is compiled twice, `: hN ...` leads its line so Compiler
+/// takes it on host, `0 drop : dN ...` goes to the device as is
+///
+static const char *_body[] = {
+    "dup * 3 + ",
+    "0 > if 1 else -1 then ",
+    "begin 1 - dup 0= until ",
+    "begin dup while 1 - repeat ",
+    "for aft r@ drop then next ",
+    "10 0 do i drop loop ",
+    ".\" hi\" s\" xy\" 2drop ",
+    "h1 h1 ( n -- n' ) ",
+    "1.5 $10 %101 + + ",
+    "key drop "
+};
+static const int NBODY = sizeof(_body) / sizeof(char*);
+///
+/// run both of each pair, and a word the host hands back (to)
+///
+static const char *_run = R"(
+0 value vv
+: h99 5 to vv ;
+h99
+.( [run] ) 5 h1 . 5 d1 . 3 h2 . 3 d2 . 5 h3 . 5 d3 . 2 h8 . 2 d8 . vv . .( [e] ) cr
+)";
+///
+/// same entry flags and name gap, body bytes equal with branch targets
+/// taken relative to pfa (device twin is further up in pmem)
+///
+bool same(T4Run &t, IU h, IU d) {
+    MMU  *mu   = t.mu;
+    IU   last  = (IU)(mu->last() - mu->dict(0));
+    auto end   = [mu, last](IU i) { return i < last ? (IU)mu->dict(i + 1)->nfa : mu->here(); };
+    if (!h || !d) return false;
+    Code *ch   = mu->dict(h), *cd = mu->dict(d);
+    if (ch->udf != cd->udf || ch->imm != cd->imm || ch->cdp != cd->cdp) return false;
+    if (ch->pfa - ch->nfa != cd->pfa - cd->nfa) return false;
+
+    IU a = ch->pfa, b = cd->pfa, ea = end(h), eb = end(d);
+    if (ea - a != eb - b) return false;
+    while (a < ea) {
+        Param *p = (Param*)mu->pmem(a), *q = (Param*)mu->pmem(b);
+        bool jmp = p->op==BRAN || p->op==ZBRAN || p->op==NEXT || p->op==LOOP;
+        if (jmp) {
+            if (p->op != q->op || p->exit != q->exit ||
+                p->ioff - ch->pfa != q->ioff - cd->pfa) return false;
+        }
+        else if (p->pack != q->pack) return false;
+        a += sizeof(IU);
+        b += sizeof(IU);
+        int n = p->op==LIT ? sizeof(DU) : (p->op==STR || p->op==DOTQ) ? p->ioff : 0;
+        if (memcmp(mu->pmem(a), mu->pmem(b), n)) return false;
+        a += n;
+        b += n;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string src;
+    for (int i = 0; i < NBODY; i++) {
+        std::string k = std::to_string(i + 1);
+        src += ": h" + k + " " + _body[i] + ";\n";
+        src += "0 drop : d" + k + " " + _body[i] + ";\n";
+    }
+    src += _run;
+    T4Run t(src);
+
+    for (int i = 0; i < NBODY; i++) {
+        std::string k = std::to_string(i + 1);
+        std::string w = "h" + k + " == d" + k + ", " + _body[i];
+        t4_check(same(t, t.find(("h" + k).c_str()), t.find(("d" + k).c_str())), w.c_str());
+    }
+    std::istringstream r(t.between("[run]", "[e]"));
+    std::vector<int>   v;
+    for (int n; r >> n;) v.push_back(n);
+    t4_check(v == std::vector<int>({ 28, 28, 1, 1, 0, 0, 52, 52, 5 }),
+             "host and device words run alike, to handed back");
+    return t4_done("t_compile");
+}
@@ -0,0 +1,118 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth primitive dispatch, heap functor vs ROM table
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <iostream>          // cin, cout
+using namespace std;
+
+#include "../src/ten4_config.h"
+#include "../src/ten4_types.h"
+#include "../src/util.h"
+#include "../src/mmu/code.h"
+
+#define NPRIM  256           /**< number of primitives     */
+#define NCALL  (1 << 20)     /**< primitives per benchmark */
+///
+/// heap functor, as CODE lambdas were before
+///
+struct fop { __GPU__ virtual void operator()() = 0; };
+template<typename F>
+struct functor : fop {
+    F op;
+    __GPU__ functor(const F f) : op(f) {}
+    __GPU__ void operator()() { op(); }
+};
+///
+/// mini VM, primitives capture [this] like CODE()
+///
+struct TVM {
+    DU    tos;
+    fop   **xt;              ///< heap functors
+    Prim  *xrom;             ///< primitive table
+    UFP   xt0;               ///< base of functor allocations
+
+    template<typename F>
+    __GPU__ void add(int i, const F &f) {
+        xt[i] = new functor<F>(f);
+        xrom[i].set(f);
+    }
+    __GPU__ void init() {
+        for (int i = 0; i < NPRIM; i++) {
+            switch (i & 3) {
+            case 0: add(i, [this] __GPU__ () { tos += DU1; });        break;
+            case 1: add(i, [this] __GPU__ () { tos *= 0.999f; });     break;
+            case 2: add(i, [this] __GPU__ () { tos -= 0.5f; });       break;
+            case 3: add(i, [this] __GPU__ () { tos = ABS(tos); });    break;
+            }
+        }
+        xt0 = ~(UFP)0;
+        for (int i = 0; i < NPRIM; i++) if ((UFP)xt[i] < xt0) xt0 = (UFP)xt[i];
+    }
+};
+
+__KERN__ void k_init(TVM *vm, long long *dt) {
+    long long t0 = clock64();
+    vm->init();
+    *dt = clock64() - t0;
+}
+///
+/// run a pseudo random word list, mode 0: functor via _XT0 offset, 1: table index
+///
+__KERN__ void k_run(TVM *vm, IU *code, int mode, long long *dt) {
+    vm->tos = DU0;
+    long long t0 = clock64();
+    if (mode == 0) {
+        for (int i = 0; i < NCALL; i++) {
+            IU off = code[i];                            /// * xt offset
+            (*(fop*)(vm->xt0 + off))();
+        }
+    }
+    else {
+        for (int i = 0; i < NCALL; i++) vm->xrom[code[i]](vm);
+    }
+    *dt = clock64() - t0;
+}
+
+int main(int argc, char **argv) {
+    TVM       *vm;
+    IU        *c0, *c1;
+    long long *dt;
+    MM_ALLOC(&vm, sizeof(TVM));
+    MM_ALLOC(&vm->xt, sizeof(fop*) * NPRIM);
+    MM_ALLOC(&vm->xrom, sizeof(Prim) * NPRIM);
+    MM_ALLOC(&c0, sizeof(IU) * NCALL);
+    MM_ALLOC(&c1, sizeof(IU) * NCALL);
+    MM_ALLOC(&dt, sizeof(long long));
+
+    k_init<<<1, 1>>>(vm, dt);
+    GPU_CHK();
+    printf("init %d primitives: %lld cycles (functor new + table set)\n", NPRIM, *dt);
+
+    srand(1);
+    for (int i = 0; i < NCALL; i++) {
+        int w = rand() % NPRIM;
+        c0[i] = (IU)((UFP)vm->xt[w] - vm->xt0);
+        c1[i] = w;
+    }
+    DU  v[2];
+    for (int m = 0; m < 2; m++) {
+        k_run<<<1, 1>>>(vm, m ? c1 : c0, m, dt);
+        GPU_CHK();
+        v[m] = vm->tos;
+        printf("%-8s %6.2f cycles/primitive\n",
+               m ? "xrom" : "functor", (double)*dt / NCALL);
+    }
+    int err = v[0] != v[1];
+    printf("result functor=%f xrom=%f %s\n", v[0], v[1], err ? "FAILED" : "OK");
+
+    MM_FREE(dt);
+    MM_FREE(c1);
+    MM_FREE(c0);
+    MM_FREE(vm->xrom);
+    MM_FREE(vm->xt);
+    MM_FREE(vm);
+    printf("%s\n", err ? "FAILED" : "PASSED");
+    return err ? -1 : 0;
+}
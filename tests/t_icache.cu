@@ -0,0 +1,59 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth inline cache, xop2 call sites with and without kind feedback
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "t_ten4.h"
+
+#if T4_ENABLE_OBJ && T4_INLINE_CACHE
+///
+/// a scalar loop and a tensor update loop, timed with the cache off then
+/// on (both must agree), and one call site fed scalars, tensors, scalars
+/// again so every guard misses once and falls back to the generic path
+///
+static const char *_src = R"(
+: sl ( -- n ) 0 100000 for 1 + 2 * 2 / next ;
+: tu ( T -- T' ) 1000 for 1 += next ;
+0 icache
+clock sl clock rot - .( [s0] ) . .( [v] ) . .( [e] ) cr
+16 16 matrix zeros clock swap tu clock rot - .( [t0] ) . .( [v] ) sum . drop .( [e] ) cr
+1 icache
+clock sl clock rot - .( [s1] ) . .( [v] ) . .( [e] ) cr
+16 16 matrix zeros clock swap tu clock rot - .( [t1] ) . .( [v] ) sum . drop .( [e] ) cr
+: mix ( a b -- a b' ) + ;
+1 2 mix .( [f1] ) . .( [e] ) cr
+2 2 matrix ones 2 2 matrix ones mix sum .( [f2] ) . drop drop drop .( [e] ) cr
+3 4 mix .( [f3] ) . .( [e] ) cr
+2 2 matrix ones 5 mix sum .( [f4] ) . drop drop drop .( [e] ) cr
+6 7 mix .( [f5] ) . .( [e] ) cr
+depth .( [depth] ) . .( [e] ) cr
+)";
+
+int main(int argc, char **argv) {
+    T4Run t(_src);
+    auto v  = [&t](const char *m) { return atoi(t.between(m, "[e]").c_str()); };
+    auto ms = [&t](const char *m) { return atof(t.between(m, "[v]").c_str()); };
+    auto r  = [&t](const char *m) { return t.between(m, "[e]"); };
+    printf("  scalar loop  cache off %8.1f ms, on %8.1f ms\n", ms("[s0]"), ms("[s1]"));
+    printf("  tensor loop  cache off %8.1f ms, on %8.1f ms\n", ms("[t0]"), ms("[t1]"));
+
+    std::string s0 = r("[s0]"), s1 = r("[s1]"), t0 = r("[t0]"), t1 = r("[t1]");
+    s0 = s0.substr(s0.find("[v]")); s1 = s1.substr(s1.find("[v]"));
+    t0 = t0.substr(t0.find("[v]")); t1 = t1.substr(t1.find("[v]"));
+    t4_check(s0 == s1 && atoi(s1.c_str() + 3) == 100001, "scalar loop, cached == generic");
+    t4_check(t0 == t1 && atoi(t1.c_str() + 3) == 256256, "tensor update loop, cached == generic");
+    t4_check(v("[f1]") == 3,  "site fed scalars");
+    t4_check(v("[f2]") == 8,  "same site, tensor pair, guard miss");
+    t4_check(v("[f3]") == 7,  "same site, scalars again");
+    t4_check(v("[f4]") == 24, "same site, tensor and scalar");
+    t4_check(v("[f5]") == 13, "same site, back to scalars");
+    t4_check(t.between("[depth]", "[e]").size() && v("[depth]") == 0, "stack balanced");
+    return t4_done("t_icache");
+}
+#else  // !(T4_ENABLE_OBJ && T4_INLINE_CACHE)
+int main(int argc, char **argv) {
+    printf("t_icache skipped, T4_INLINE_CACHE=0\n");
+    return 0;
+}
+#endif // T4_ENABLE_OBJ && T4_INLINE_CACHE
@@ -0,0 +1,47 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth included files, chunked thru the double-buffered Istream
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <fstream>
+#include "t_ten4.h"
+
+#define NLINE   30000                    /**< lines of a.fs, several chunks */
+#define FN_A    "/tmp/t_include_a.fs"
+#define FN_B    "/tmp/t_include_b.fs"
+#define FN_C    "/tmp/t_include_c.fs"
+///
+/// a.fs spans several T4_ICHUNK_SZ chunks (lines cut at chunk ends) and
+/// includes b.fs with more on the same line, c.fs fails half way
+///
+static const char *_src =
+    "s\" " FN_A "\" included .( [sum] ) . .( [e] ) cr\n"
+    "inb .( [inb] ) . .( [e] ) cr\n"
+    "s\" " FN_C "\" included\n"
+    ".( [next] ) cr\n";
+
+void files() {
+    std::ofstream a(FN_A), b(FN_B), c(FN_C);
+    a << "0\n";
+    for (int i = 0; i < NLINE; i++) {
+        a << "1 + \\ line " << i << " of " << NLINE << ", padded to cross chunk ends\n";
+    }
+    a << "s\" " FN_B "\" included 1000 +\n";
+    b << ": inb ( -- 7 ) 7 ;\n100 +\n";
+    c << "1 2 xyzzy 3\n.( [after] ) cr\n";
+}
+
+int main(int argc, char **argv) {
+    files();
+    T4Run t(_src);
+    int sum = atoi(t.between("[sum]", "[e]").c_str());
+    int inb = atoi(t.between("[inb]", "[e]").c_str());
+    remove(FN_A); remove(FN_B); remove(FN_C);
+
+    t4_check(sum == NLINE + 100 + 1000, "chunked file, nested file, rest of line");
+    t4_check(inb == 7,                  "word defined in nested file");
+    t4_check(!t.has("[after]"),         "error drops rest of included file");
+    t4_check(t.has("[next]"),           "console line after aborted file");
+    return t4_done("t_include");
+}
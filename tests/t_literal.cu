@@ -0,0 +1,42 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth bulk literal blocks, TensorVM::pre vs literal by literal
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "t_ten4.h"
+
+#if T4_ENABLE_OBJ && T4_BULK_LIT
+///
+/// runs of T4_BULK_LIT or more literals in a tensor body are staged by
+/// Compiler::_bulk and taken as one block by TensorVM::pre, shorter runs and
+/// literals outside a body are parsed one by one on device, both must agree
+///
+static const char *_src = R"(
+2 6 matrix{ 0.5 -1.5 2 3.25 4 5 6 7 8 9 10 11 } constant b
+2 6 matrix{ 0.5 -1.5 2 3.25 4 5
+6 7 8 9 10 11 } constant s
+.( [b] ) b . .( [s] ) s . .( [e] ) cr
+2 8 matrix{ 1 2 3 4 5 6 7 8
+9 10 11 12 13 14 15 16 } sum .( [ml] ) . drop .( [e] ) cr
+hex 2 4 matrix{ 10 11 12 13 14 15 16 17 } sum decimal .( [hex] ) . drop .( [e] ) cr
+1 2 3 4 5 6 7 8 9 + + + + + + + + .( [stk] ) . .( [e] ) cr
+)";
+
+int main(int argc, char **argv) {
+    T4Run t(_src);
+    auto v = [&t](const char *m) { return atoi(t.between(m, "[e]").c_str()); };
+    std::string b = t.between("[b]", "[s]");
+
+    t4_check(b.size() && b == t.between("[s]", "[e]"), "tensor storage, block == one by one");
+    t4_check(v("[ml]")  == 136, "body across lines, a block per line");
+    t4_check(v("[hex]") == 156, "base set on the same line, read by device");
+    t4_check(v("[stk]") == 45,  "literals outside a body, one by one");
+    return t4_done("t_literal");
+}
+#else  // !(T4_ENABLE_OBJ && T4_BULK_LIT)
+int main(int argc, char **argv) {
+    printf("t_literal skipped, T4_BULK_LIT=0\n");
+    return 0;
+}
+#endif // T4_ENABLE_OBJ && T4_BULK_LIT
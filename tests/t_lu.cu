@@ -0,0 +1,146 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth blocked LU (host) vs serial PLU benchmark
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <iostream>          // cin, cout
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <math.h>
+using namespace std;
+
+#include "../src/ten4_config.h"
+#include "../src/ten4_types.h"
+
+typedef chrono::high_resolution_clock CLK;
+///
+/// serial PLU (as in the original Tensor::plu)
+///
+int serial_plu(DU *A, int *P, int n) {
+    int ns = 0;
+    for (int z = 0; z < n; z++) P[z] = z;
+    for (int z = 0; z < n; z++) {
+        int u = z;
+        for (int i = z + 1; i < n; i++) {
+            if (fabs(A[z + i * n]) > fabs(A[z + u * n])) u = i;
+        }
+        if (u != z) {
+            for (int k = 0; k < n; k++) {
+                DU t = A[k + z * n]; A[k + z * n] = A[k + u * n]; A[k + u * n] = t;
+            }
+            int t = P[z]; P[z] = P[u]; P[u] = t;
+            ns++;
+        }
+        DU ra = A[z + z * n];
+        if (fabs(ra) < DU_EPS) continue;
+        for (int y = z + 1; y < n; y++) {
+            DU r1 = A[z + y * n] /= ra;
+            for (int k = z + 1; k < n; k++) A[k + y * n] -= r1 * A[k + z * n];
+        }
+    }
+    return ns;
+}
+///
+/// run f(i) for i in [i0, i1) on all hardware threads
+///
+template<typename F>
+void par_for(int i0, int i1, F f) {
+    int nt = thread::hardware_concurrency();
+    if (nt < 1) nt = 1;
+    vector<thread> th;
+    for (int t = 0; t < nt; t++) {
+        th.emplace_back([=, &f]() {
+            for (int i = i0 + t; i < i1; i += nt) f(i);
+        });
+    }
+    for (auto &x : th) x.join();
+}
+///
+/// blocked right-looking PLU, same steps as device k_lu_panel/trsm/gemm
+///
+int blocked_plu(DU *A, int *P, int n) {
+    int ns = 0;
+    for (int z = 0; z < n; z++) P[z] = z;
+    for (int k = 0; k < n; k += T4_LU_NB) {
+        const int nb = min(T4_LU_NB, n - k), k1 = k + nb;
+        for (int j = k; j < k1; j++) {               /// * panel
+            int u = j;
+            for (int i = j + 1; i < n; i++) {
+                if (fabs(A[j + i * n]) > fabs(A[j + u * n])) u = i;
+            }
+            if (u != j) {
+                for (int c = 0; c < n; c++) swap(A[c + j * n], A[c + u * n]);
+                swap(P[j], P[u]);
+                ns++;
+            }
+            DU ra = A[j + j * n];
+            if (fabs(ra) < DU_EPS) continue;
+            for (int i = j + 1; i < n; i++) {
+                DU r1 = A[j + i * n] /= ra;
+                for (int c = j + 1; c < k1; c++) A[c + i * n] -= r1 * A[c + j * n];
+            }
+        }
+        if (k1 >= n) break;
+        par_for(k1, n, [=](int c) {                  /// * U12 = L11^-1 A12
+            for (int r = k + 1; r < k1; r++) {
+                DU acc = A[c + r * n];
+                for (int q = k; q < r; q++) acc -= A[q + r * n] * A[c + q * n];
+                A[c + r * n] = acc;
+            }
+        });
+        par_for(k1, n, [=](int i) {                  /// * A22 -= L21 @ U12
+            DU *ai = &A[i * n];
+            for (int q = k; q < k1; q++) {
+                DU l = ai[q], *uq = &A[q * n];
+                for (int j = k1; j < n; j++) ai[j] -= l * uq[j];
+            }
+        });
+    }
+    return ns;
+}
+///
+/// max |PA - LU| on a sample of rows
+///
+DU residual(DU *A0, DU *LU, int *P, int n) {
+    DU err = 0;
+    for (int i = 0; i < n; i += max(1, n / 16)) {
+        for (int j = 0; j < n; j++) {
+            DU2 acc = 0;
+            for (int q = 0; q <= min(i, j); q++) {
+                acc += (q == i ? 1.0 : LU[q + i * n]) * LU[j + q * n];
+            }
+            err = max(err, (DU)fabs(acc - A0[j + P[i] * n]));
+        }
+    }
+    return err;
+}
+
+int main(int argc, char **argv) {
+    int err = 0;
+    for (int n = 256; n <= 4096; n *= 2) {
+        vector<DU>  A0((size_t)n * n), A1, A2;
+        vector<int> P1(n), P2(n);
+        srand(n);
+        for (auto &x : A0) x = (DU)rand() / RAND_MAX - 0.5;
+        A1 = A0; A2 = A0;
+
+        auto t0 = CLK::now();
+        int  s1 = n <= 2048 ? serial_plu(A1.data(), P1.data(), n) : 0;
+        auto t1 = CLK::now();
+        int  s2 = blocked_plu(A2.data(), P2.data(), n);
+        auto t2 = CLK::now();
+
+        DU   r  = residual(A0.data(), A2.data(), P2.data(), n);
+        bool ok = r < 1e-2 && (n > 2048 || s1 == s2);
+        printf("n=%4d serial=%9.2f ms blocked=%8.2f ms swaps=%d/%d residual=%g %s\n",
+               n,
+               n <= 2048 ? chrono::duration<double, milli>(t1 - t0).count() : NAN,
+               chrono::duration<double, milli>(t2 - t1).count(),
+               s1, s2, r, ok ? "OK" : "FAILED");
+        err += !ok;
+    }
+    printf("%s\n", err ? "FAILED" : "PASSED");
+    return err ? -1 : 0;
+}
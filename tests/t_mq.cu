@@ -0,0 +1,53 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth inter-VM inboxes, send/recv/bcast and non-blocking send?/recv?
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "t_ten4.h"
+
+#if DO_MULTITASK
+///
+/// messages thru the MPMC inbox of each ForthVM, a 3-item message of two
+/// senders to VM0 must come out whole (no interleaving), 16 fit in an inbox
+///
+static const char *_src = R"(
+: echo ( -- ) recv + 1 0 send ;
+' echo task constant e1
+3 4 2 e1 send? .( [q] ) . .( [e] ) cr
+e1 start recv .( [echo] ) . .( [e] ) cr e1 join
+recv? .( [none] ) . .( [e] ) cr
+: sq ( -- ) recv dup * 1 0 send ;
+' sq task constant s1
+' sq task constant s2
+s1 start s2 start 5 1 bcast
+recv recv + .( [bcast] ) . .( [e] ) cr
+s1 join s2 join
+: p3 ( -- ) 20 for rank rank rank 3 0 send next ;
+' p3 task constant a1
+' p3 task constant a2
+variable bad
+: chk ( -- ) 41 for recv over = >r = r> and 0= if 1 bad +! then next ;
+a1 start a2 start chk a1 join a2 join
+bad @ .( [bad] ) . .( [e] ) cr
+)";
+
+int main(int argc, char **argv) {
+    T4Run t(_src);
+    auto v = [&t](const char *m) { return atoi(t.between(m, "[e]").c_str()); };
+
+    t4_check(v("[q]")     == -1, "send? into a new task's inbox");
+    t4_check(v("[echo]")  == 7,  "2-item message, reply to VM0");
+    t4_check(t.between("[none]", "[e]").size() && v("[none]") == 0,
+             "recv? on empty inbox, no wait");
+    t4_check(v("[bcast]") == 50, "bcast into every live task");
+    t4_check(t.between("[bad]", "[e]").size() && v("[bad]") == 0,
+             "3-item messages of 2 senders not interleaved");
+    return t4_done("t_mq");
+}
+#else  // !DO_MULTITASK
+int main(int argc, char **argv) {
+    printf("t_mq skipped, DO_MULTITASK=0\n");
+    return 0;
+}
+#endif // DO_MULTITASK
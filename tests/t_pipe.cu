@@ -0,0 +1,44 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth micro-batch pipeline, Model::forward with nn.pipe 1/4/8
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "t_ten4.h"
+
+#if T4_ENABLE_NN
+///
+/// same model, same input, forward on 1, 4 and 8 micro-batch streams,
+/// output of last layer copied out after each pass and printed
+///
+static const char *_src = R"(
+0 trace
+8 8 8 1 nn.model
+0.5 4 conv2d relu 2 maxpool flatten 0.5 10 linear
+0 nn.fuse
+constant md
+8 8 8 1 tensor randn constant x
+md x forward -1 n@ copy constant y1 2drop
+md 4 nn.pipe x forward -1 n@ copy constant y4 2drop
+md 8 nn.pipe x forward -1 n@ copy constant y8 2drop
+md 1 nn.pipe drop
+.( [1] ) y1 . .( [4] ) y4 . .( [8] ) y8 . .( [e] ) cr
+)";
+
+int main(int argc, char **argv) {
+    T4Run t(_src);
+    std::string y1 = t.between("[1]", "[4]");
+    std::string y4 = t.between("[4]", "[8]");
+    std::string y8 = t.between("[8]", "[e]");
+
+    t4_check(y1.size() > 0,  "forward, 1 micro-batch");
+    t4_check(y4 == y1,       "forward, 4 micro-batches on streams");
+    t4_check(y8 == y1,       "forward, 8 micro-batches on streams");
+    return t4_done("t_pipe");
+}
+#else  // !T4_ENABLE_NN
+int main(int argc, char **argv) {
+    printf("t_pipe skipped, T4_ENABLE_NN=0\n");
+    return 0;
+}
+#endif // T4_ENABLE_NN
@@ -0,0 +1,92 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth Philox randomizer determinism and throughput tests
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <iostream>          // cin, cout
+#include <string.h>          // memcmp
+using namespace std;
+
+#include "../src/ten4_config.h"
+#include "../src/ten4_types.h"
+#include "../src/philox.h"
+
+#define SEED   0x1234abcdULL
+#define H      1024
+#define W      2048
+
+__KERN__ void
+k_rand(DU *d, U64 sz, U64 seed, U32 stream, rand_opt ntype) {
+    U64 i = threadIdx.x + (U64)blockIdx.x * blockDim.x;
+    if (i * 4 < sz) philox_fill4(d, sz, i, seed, stream, ntype, DU0, DU1);
+}
+
+__HOST__ void
+dev_fill(DU *d, U64 sz, U32 stream, rand_opt ntype, int nthread) {
+    U64 nb = (sz + 3) / 4;
+    k_rand<<<(nb + nthread - 1) / nthread, nthread>>>(d, sz, SEED, stream, ntype);
+    GPU_CHK();
+}
+
+__HOST__ int
+test_determinism(DU *d, DU *h, U64 sz) {
+    printf("test determinism ====================\n");
+    const char *nm[2] = { "uniform", "normal" };
+    int err = 0;
+    for (int t = 0; t < 2; t++) {
+        rand_opt n = t ? NORMAL : UNIFORM;
+        philox_fill(h, sz, SEED, 7, n);              /// * host reference
+        for (int nt = 32; nt <= 1024; nt *= 4) {     /// * launch geometries
+            dev_fill(d, sz, 7, n, nt);
+            int ok = memcmp(d, h, sz * sizeof(DU)) == 0;
+            printf("%-8s threads=%4d host==device %s\n", nm[t], nt, ok ? "OK" : "FAILED");
+            err += !ok;
+        }
+        DU2 m = 0.0, v = 0.0;                        /// * distribution sanity
+        for (U64 i = 0; i < sz; i++) { m += h[i]; v += (DU2)h[i] * h[i]; }
+        m /= sz; v = v / sz - m * m;
+        printf("%-8s mean=%8.5f var=%8.5f\n", nm[t], m, v);
+    }
+    dev_fill(d, sz, 8, UNIFORM, 256);                /// * next stream differs
+    philox_fill(h, sz, SEED, 7, UNIFORM);
+    int diff = 0;
+    for (U64 i = 0; i < sz; i++) diff += d[i] == h[i];
+    printf("stream 7 vs 8 equal=%d/%ld %s\n", diff, sz, diff < 64 ? "OK" : "FAILED");
+    return err + (diff >= 64);
+}
+
+__HOST__ void
+test_throughput(DU *d, U64 sz) {
+    printf("test fill throughput [%dx%d] ==========\n", H, W);
+    EVENT t0, t1;
+    cudaEventCreate(&t0);
+    cudaEventCreate(&t1);
+    for (int t = 0; t < 2; t++) {
+        const int N = 20;
+        cudaEventRecord(t0);
+        for (int i = 0; i < N; i++) dev_fill(d, sz, i, t ? NORMAL : UNIFORM, T4_RAND_SZ);
+        cudaEventRecord(t1);
+        cudaEventSynchronize(t1);
+        float ms;
+        cudaEventElapsedTime(&ms, t0, t1);
+        printf("%-8s %7.3f ms/fill, %6.2f GB/s\n", t ? "normal" : "uniform",
+               ms / N, (DU2)sz * sizeof(DU) * N / ms / 1.0e6);
+    }
+    cudaEventDestroy(t0);
+    cudaEventDestroy(t1);
+}
+
+int main(int argc, char **argv) {
+    const U64 sz = (U64)H * W;
+    DU *d, *h = (DU*)malloc(sz * sizeof(DU));
+    MM_ALLOC(&d, sz * sizeof(DU));
+
+    int err = test_determinism(d, h, sz);
+    test_throughput(d, sz);
+
+    MM_FREE(d);
+    free(h);
+    printf("%s\n", err ? "FAILED" : "PASSED");
+    return err ? -1 : 0;
+}
@@ -0,0 +1,41 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth resident VMs, lines thru the command ring of k_vm_resident
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "t_ten4.h"
+///
+/// interactive lines, a colon word, a task (VM0 parks in the resident
+/// grid) and a tensor word which must be refused with the rest of its line
+///
+static const char *_src = R"(
+1 2 + .( [add] ) . .( [e] ) cr
+: sq ( n -- n*n ) dup * ;
+7 sq .( [sq] ) . .( [e] ) cr
+: one ( -- id ) rank ;
+' one task constant o1
+o1 start o1 join 1 o1 pull .( [task] ) . .( [e] ) cr
+2 2 matrix .( [cdp] ) cr
+depth .( [depth] ) . .( [e] ) cr
+)";
+
+int main(int argc, char **argv) {
+    T4Run t(_src, true);
+    auto v = [&t](const char *m) { return atoi(t.between(m, "[e]").c_str()); };
+    int  coop = 0, cma = 0;                   ///< else main_resident ran main_loop
+    GPU_ERR(cudaDeviceGetAttribute(&coop, cudaDevAttrCooperativeLaunch, 0));
+    GPU_ERR(cudaDeviceGetAttribute(&cma,  cudaDevAttrConcurrentManagedAccess, 0));
+
+    t4_check(v("[add]") == 3,                 "line thru command ring");
+    t4_check(v("[sq]")  == 49,                "colon word compiled and run");
+#if DO_MULTITASK
+    int r = v("[task]");
+    t4_check(r > 0 && r < T4_VM_COUNT,        "task joined by parked VM0");
+#endif // DO_MULTITASK
+#if T4_ENABLE_OBJ
+    if (coop && cma) t4_check(!t.has("[cdp]"), "tensor word refused, line dropped");
+#endif // T4_ENABLE_OBJ
+    t4_check(t.between("[depth]", "[e]").size() > 0, "VM0 alive after refusal");
+    return t4_done("t_resident");
+}
@@ -0,0 +1,65 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth tasks, producer -> filter -> consumer on VMs that park
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include "t_ten4.h"
+
+#if DO_MULTITASK
+///
+/// nmsg+1 values thru a 2x+1 filter, more than an inbox holds so both
+/// send (inbox full) and recv (inbox empty) park, VM0 parks on join
+///
+static const char *_src = R"(
+200 constant nmsg
+: cons ( -- sum ) 0 nmsg for recv + next ;
+' cons task constant c1
+: filt ( -- ) nmsg for recv 2* 1+ 1 c1 send next ;
+' filt task constant f1
+: prod ( -- ) nmsg for i 1 f1 send next ;
+' prod task constant p1
+c1 start f1 start p1 start
+p1 join f1 join c1 join
+1 c1 pull .( [sum] ) . .( [e] ) cr
+: one ( -- ) rank ;
+' one task constant o1
+o1 start o1 join 1 o1 pull .( [rank] ) . .( [e] ) cr
+: acc ( -- sum id ) 0 200 for i rank + + next rank ;
+' acc task constant a1
+' acc task constant a2
+5 a1 start a2 start a1 join a2 join
+.( [vm0] ) . .( [e] ) cr
+2 a1 pull .( [a1] ) . . .( [e] ) cr
+2 a2 pull .( [a2] ) . . .( [e] ) cr
+)";
+
+int main(int argc, char **argv) {
+    T4Run t(_src);
+    const int n = 200 + 1;                             ///< for loops run nmsg+1 times
+    int sum  = atoi(t.between("[sum]",  "[e]").c_str());
+    int rank = atoi(t.between("[rank]", "[e]").c_str());
+
+    t4_check(sum == n * n,          "pipeline sum thru send/recv");
+    t4_check(rank > 0 && rank < T4_VM_COUNT, "task slot reused after join");
+    ///
+    /// two tasks at once, built-in words must run on their own VMs,
+    /// not on VM0 which added them
+    ///
+    std::istringstream r1(t.between("[a1]", "[e]")), r2(t.between("[a2]", "[e]"));
+    int id1 = 0, s1 = 0, id2 = 0, s2 = 0;
+    r1 >> id1 >> s1;
+    r2 >> id2 >> s2;
+    auto ok = [n](int id, int s) {
+        return id > 0 && id < T4_VM_COUNT && s == n * (n - 1) / 2 + n * id;
+    };
+    t4_check(atoi(t.between("[vm0]", "[e]").c_str()) == 5, "VM0 stack untouched by tasks");
+    t4_check(ok(id1, s1) && ok(id2, s2) && id1 != id2,      "two tasks, each on its own VM");
+    return t4_done("t_task");
+}
+#else  // !DO_MULTITASK
+int main(int argc, char **argv) {
+    printf("t_task skipped, DO_MULTITASK=0\n");
+    return 0;
+}
+#endif // DO_MULTITASK
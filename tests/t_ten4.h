@@ -0,0 +1,72 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth test harness, feeds a Forth script thru TensorForth
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#ifndef __T_TEN4_H
+#define __T_TEN4_H
+#include <iostream>          // cin, cout
+#include <sstream>
+#include <string>
+#include <string.h>
+#include "../src/ten4.h"
+///
+/// one TensorForth per test program (System is a singleton), the
+/// script runs to its end in the constructor, VM output is kept in out
+/// and dictionary, pmem, object store stay up for checks till teardown
+///
+struct T4Run {
+    std::istringstream in;
+    std::ostringstream out;
+    TensorForth        *f;
+    System             *sys;
+    MMU                *mu;
+
+    T4Run(const std::string &src, bool resident=false) : in(src) {
+        GPU_ERR(cudaDeviceSetLimit(cudaLimitStackSize, T4_PER_THREAD_STACK));
+        f   = new TensorForth(0, 0, in, out);
+        f->setup();
+        sys = System::get_sys();
+        mu  = sys->mu;
+        if (resident) f->main_resident();
+        else          f->main_loop();
+        GPU_CHK();
+    }
+    ~T4Run() { f->teardown(); }
+    ///
+    /// text VMs printed between two markers, empty if not found
+    ///
+    std::string between(const char *m0, const char *m1) {
+        std::string s = out.str();
+        size_t i = s.find(m0);
+        if (i == std::string::npos) return "";
+        i += strlen(m0);
+        size_t j = s.find(m1, i);
+        return j == std::string::npos ? "" : s.substr(i, j - i);
+    }
+    bool has(const char *s) { return out.str().find(s) != std::string::npos; }
+    ///
+    /// colon word by name, newest first as MMU::find, 0 if none
+    ///
+    IU find(const char *s) {
+        for (IU i = (IU)(mu->last() - mu->dict(0)); i > 0; --i) {
+            Code *c = mu->dict(i);
+            if (c->udf && !strcmp(c->name, s)) return i;  /// * names in pmem
+        }
+        return 0;
+    }
+};
+///
+/// check one condition, tally failures for the exit code
+///
+static int t4_nfail = 0;
+static void t4_check(bool ok, const char *what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) t4_nfail++;
+}
+static int t4_done(const char *t) {
+    printf("%s %s\n", t, t4_nfail ? "FAILED" : "PASSED");
+    return t4_nfail ? -1 : 0;
+}
+#endif // __T_TEN4_H
@@ -10,14 +10,14 @@ using namespace std;
 
 #include "../src/ten4_config.h"
 #include "../src/ten4_types.h"
-#include "../src/tlsf.h"
+#include "../src/mmu/tlsf.h"
 
 __HOST__ void
 test_host_init(U8 *data, U32 sz) {
     printf("test HOST init ====================\n");
     TLSF tlsf;
     tlsf.init(data, sz);
-    tlsf.status(2);
+    tlsf.status();
 }
 
 __KERN__ void
@@ -27,7 +27,7 @@ test_kern_init(U8 *data, U32 sz) {
     printf("test KERN init =====================\n");
     TLSF tlsf;
     tlsf.init(data, sz);
-    tlsf.status(2);
+    tlsf.status();
 }
 
 __KERN__ void
@@ -42,32 +42,63 @@ test_alloc(U8 *data, U32 sz) {
     for (int i=0; i<4; i++) {
         blk[i] = (DU*)tlsf.malloc(a[i]);
         printf("malloc(%x) => %p\n", a[i], blk[i]);
-        tlsf.status(2);
+        tlsf.status();
     }
     printf("test KERN free ==================\n");
     for (int i=0; i<4; i++) {
         printf("free(%p)\n", blk[i]);
         tlsf.free(blk[i]);
-        tlsf.status(2);
+        tlsf.status();
     }
     printf("test KERN 2nd malloc ====================\n");
     for (int i=0; i<4; i++) {
         blk[i] = (DU*)tlsf.malloc(a[i]);
         printf("malloc(%x) => %p\n", a[i], blk[i]);
-        tlsf.status(2);
+        tlsf.status();
     }
     printf("test KERN 2nd free ===============\n");
     for (int i=3; i>=0; i--) {
         printf("free(%p)\n", blk[i]);
         tlsf.free(blk[i]);
-        tlsf.status(2);
+        tlsf.status();
     }
 }
 
+#define NBLK 256
+__KERN__ void
+test_compact(U8 *data, U32 sz) {
+    if (blockIdx.x !=0 || threadIdx.x != 0) return;
+
+    DU   *blk[NBLK];                           ///< owners of data blocks
+    void **own[NBLK];
+    TLSF tlsf;
+    tlsf.init(data, sz);
+    printf("test KERN compact ===============\n");
+    for (int i=0; i<NBLK; i++) {               /// * alternate small, large blocks
+        U32 n = (i & 1) ? 256 * 1024 : 16 * 1024;
+        blk[i] = (DU*)tlsf.malloc(n * sizeof(DU));
+        for (U32 k=0; k<n; k+=1024) blk[i][k] = (DU)i;
+    }
+    for (int i=1; i<NBLK; i+=2) tlsf.free(blk[i]); /// * punch holes
+    int m = 0;
+    for (int i=0; i<NBLK; i+=2) own[m++] = (void**)&blk[i];
+    U64 f0 = tlsf.largest();
+    clock_t t0 = clock64();
+    int nmv = tlsf.compact(own, m);
+    clock_t t1 = clock64();
+    U64 f1 = tlsf.largest();
+    int err = 0;
+    for (int i=0; i<NBLK; i+=2) {              /// * data moved intact
+        for (U32 k=0; k<16 * 1024; k+=1024) err += blk[i][k] != (DU)i;
+    }
+    printf("moved=%d, largest free 0x%lx => 0x%lx, %ld cycles %s\n",
+           nmv, f0, f1, (long)(t1 - t0), err ? "FAILED" : "OK");
+}
+
 int main(int argc, char**argv) {
     printf("%s tests start ===============\n", argv[0]);
     U8 *data;
-    U32 sz = T4_TENSOR_SZ;
+    U32 sz = T4_OSTORE_SZ;
     cudaMallocManaged((void**)&data, sz);
     GPU_CHK();
 
@@ -78,6 +109,9 @@ int main(int argc, char**argv) {
     test_alloc<<<1,1>>>(data, sz);
     GPU_CHK();
 
+    test_compact<<<1,1>>>(data, sz);
+    GPU_CHK();
+
     cudaFree(data);
     GPU_CHK();
 
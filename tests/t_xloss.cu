@@ -0,0 +1,152 @@
+/** -*- c++ -*-
+ * @file
+ * @brief - tensorForth fused loss/dLoss/hit from labels vs one-hot path
+ *
+ * <pre>Copyright (C) 2022- GreenII, this file is distributed under BSD 3-Clause License.</pre>
+ */
+#include <iostream>          // cin, cout
+#include <math.h>
+using namespace std;
+
+#include "../src/ten4_config.h"
+#include "../src/ten4_types.h"
+#include "../src/mmu/xloss.h"
+
+#define HWC    10            /**< number of classes  */
+#define NSTEP  20            /**< steps per timing   */
+///
+/// fused, one thread per sample (same body as nn/loss.cu k_xloss)
+///
+__KERN__ void
+t_xloss(t4_loss op, DU *O, U32 *L, int sz, int N, DU *sum, int *hit) {
+    const int n = threadIdx.x + blockIdx.x * blockDim.x;
+    DU  v = DU0;
+    int h = 0;
+    if (n < N) v = xloss1(op, &O[(U64)n * sz], sz, xl_label(L, n, sz), h);
+    for (int d = 16; d > 0; d >>= 1) {
+        v += __shfl_down_sync(0xffffffff, v, d);
+        h += __shfl_down_sync(0xffffffff, h, d);
+    }
+    if ((threadIdx.x & 31) == 0) { atomicAdd(sum, v); atomicAdd(hit, h); }
+}
+__KERN__ void
+t_xdloss(bool sub, DU *O, U32 *L, int sz, U64 numel) {
+    const U64 k = threadIdx.x + (U64)blockIdx.x * blockDim.x;
+    if (k < numel) O[k] = xdloss1(sub, O, L, sz, k);
+}
+///
+/// one-hot path, serial fill and argmax as Model::onehot/hit were
+///
+__KERN__ void
+t_onehot(DU *H, U32 *L, int sz, int N, DU *O, int *hit) {
+    int cnt = 0;
+    for (int n = 0; n < N; n++) {
+        DU *h = &H[(U64)n * sz], *o = &O[(U64)n * sz];
+        for (int i = 0; i < sz; i++) h[i] = DU0;
+        h[xl_label(L, n, sz)] = DU1;
+        int m = 0;
+        for (int i = 1; i < sz; i++) if (o[i] > o[m]) m = i;
+        cnt += INT(h[m]);
+    }
+    *hit = cnt;
+}
+__KERN__ void
+t_ce(DU *T, DU *O, DU *H, U64 numel) {           ///< tmp = ln(out) * onehot
+    const U64 k = threadIdx.x + (U64)blockIdx.x * blockDim.x;
+    if (k < numel) T[k] = H[k] > DU0 ? LN(O[k]) * H[k] : DU0;
+}
+///
+/// softmax-like random outputs, labels
+///
+__HOST__ void
+fill(DU *O, U32 *L, int N) {
+    for (int n = 0; n < N; n++) {
+        DU s = DU0, *o = &O[(U64)n * HWC];
+        for (int i = 0; i < HWC; i++) s += (o[i] = (DU)rand() / RAND_MAX + DU_EPS);
+        for (int i = 0; i < HWC; i++) o[i] /= s;
+        L[n] = rand() % HWC;
+    }
+}
+
+int main(int argc, char **argv) {
+    const int NMAX = 4096;
+    DU  *O, *T, *H, *O1, *sum;
+    U32 *L;
+    int *hit, err = 0;
+    MM_ALLOC(&O,   sizeof(DU) * NMAX * HWC);
+    MM_ALLOC(&T,   sizeof(DU) * NMAX * HWC);
+    MM_ALLOC(&H,   sizeof(DU) * NMAX * HWC);
+    MM_ALLOC(&L,   sizeof(U32) * NMAX);
+    MM_ALLOC(&sum, sizeof(DU));
+    MM_ALLOC(&hit, sizeof(int));
+    O1 = (DU*)malloc(sizeof(DU) * NMAX * HWC);
+
+    const char *nm[4] = { "MSE", "BCE", "CE", "NLL" };
+    EVENT t0, t1;
+    cudaEventCreate(&t0);
+    cudaEventCreate(&t1);
+    for (int N = 64; N <= NMAX; N *= 4) {
+        srand(N);
+        fill(O, L, N);
+        const U64 numel = (U64)N * HWC;
+        dim3 blk(T4_WARP_SQ, 1, 1), gn((N + blk.x - 1) / blk.x, 1, 1);
+        dim3 ge((numel + blk.x - 1) / blk.x, 1, 1);
+        ///
+        /// fused vs host reference, all four losses
+        ///
+        for (int op = LOSS_MSE; op <= LOSS_NLL; op++) {
+            int hh;
+            DU  ref = xloss_host((t4_loss)op, O, L, HWC, N, hh);
+            *sum = DU0; *hit = 0;
+            t_xloss<<<gn, blk>>>((t4_loss)op, O, L, HWC, N, sum, hit);
+            GPU_CHK();
+            bool ok = fabs(*sum - ref) <= 1e-3 * (fabs(ref) + 1) && *hit == hh;
+            printf("N=%4d %-3s loss=%9.4f host=%9.4f hit=%d/%d %s\n",
+                   N, nm[op], *sum / N, ref / N, *hit, hh, ok ? "OK" : "FAILED");
+            err += !ok;
+        }
+        memcpy(O1, O, sizeof(DU) * numel);            /// * dLoss vs host
+        xdloss_host(true, O1, L, HWC, N);
+        memcpy(T, O, sizeof(DU) * numel);
+        t_xdloss<<<ge, blk>>>(true, T, L, HWC, numel);
+        GPU_CHK();
+        bool ok = memcmp(T, O1, sizeof(DU) * numel) == 0;
+        printf("N=%4d dLoss host==device %s\n", N, ok ? "OK" : "FAILED");
+        err += !ok;
+        ///
+        /// per step timing, CE loss + hit
+        ///
+        float ms[2];
+        for (int m = 0; m < 2; m++) {
+            cudaEventRecord(t0);
+            for (int s = 0; s < NSTEP; s++) {
+                if (m) {
+                    *sum = DU0;
+                    t_xloss<<<gn, blk>>>(LOSS_CE, O, L, HWC, N, sum, hit);
+                }
+                else {
+                    t_onehot<<<1, 1>>>(H, L, HWC, N, O, hit);
+                    t_ce<<<ge, blk>>>(T, O, H, numel);
+                }
+                cudaDeviceSynchronize();
+            }
+            cudaEventRecord(t1);
+            cudaEventSynchronize(t1);
+            cudaEventElapsedTime(&ms[m], t0, t1);
+        }
+        printf("N=%4d per step one-hot=%7.3f ms fused=%7.3f ms\n",
+               N, ms[0] / NSTEP, ms[1] / NSTEP);
+    }
+    cudaEventDestroy(t0);
+    cudaEventDestroy(t1);
+
+    free(O1);
+    MM_FREE(hit);
+    MM_FREE(sum);
+    MM_FREE(L);
+    MM_FREE(H);
+    MM_FREE(T);
+    MM_FREE(O);
+    printf("%s\n", err ? "FAILED" : "PASSED");
+    return err ? -1 : 0;
+}